@@ -12,7 +12,8 @@ public class ActorPortrait : ModuleRules
         {
             "Core",
             "CoreUObject",
-            "Engine"
+            "Engine",
+            "DeveloperSettings"
         });
 
         PrivateDependencyModuleNames.AddRange(new string[]
@@ -21,7 +22,8 @@ public class ActorPortrait : ModuleRules
             "UMG",
             "SlateCore",
             "InputCore",
-			"RenderCore"
+			"RenderCore",
+			"RHI"
         });
 
         if (Target.bBuildEditor)
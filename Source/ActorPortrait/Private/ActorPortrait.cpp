@@ -5,6 +5,10 @@
 #include "ActorPortraitModule.h"
 #include "ActorPortraitSettings.h"
 #include "ActorPortraitInterface.h"
+#include "ActorPortraitProjectSettings.h"
+#include "ActorPortraitScene.h"
+#include "ActorPortraitScenePool.h"
+#include "PortraitBakedBackdrop.h"
 
 #include "Components/SkyLightComponent.h"
 #include "Components/DirectionalLightComponent.h"
@@ -16,6 +20,7 @@
 #include "Widgets/Layout/SBox.h"
 
 #include "Engine/World.h"
+#include "Engine/TextureCube.h"
 #include "Engine/Engine.h"
 #include "Engine/GameInstance.h"
 #include "Misc/AssertionMacros.h"
@@ -57,14 +62,21 @@ UActorPortrait::UActorPortrait()
 	RenderMaterial  = DefaultRenderMaterial.Object;
 	TexureParameter = ActorPortraitHelpers::DefaultTexureParameterName;
 
+	PlaceholderBrush.DrawAs = ESlateBrushDrawType::NoDrawType;
+
 	bShowInDesigner                   = true;
 	DirectionalLightComponentTemplate = nullptr;
 	SkyLightComponentTemplate         = nullptr;
 	UserData                          = nullptr;
 
-	bTickWorld    = true;
-	bIsRealTime   = true;
-	CaptureSource = ESceneCaptureSource::SCS_FinalColorHDR;
+	bTickWorld         = true;
+	TickRate           = 0.f;
+	TimeDilation       = 1.f;
+	TickPriority       = 0;
+	bIsRealTime        = true;
+	MaxCaptureRate     = 0.f;
+	CaptureSource      = ESceneCaptureSource::SCS_FinalColorHDR;
+	RenderTargetFormat = EPortraitRenderTargetFormat::Auto;
 	
 	// Disable auto exposure as it doesn't work well in a portrait scenario
 	PostProcessingSettings.bOverride_AutoExposureMinBrightness = true;
@@ -84,6 +96,16 @@ UActorPortrait::UActorPortrait()
 	static ConstructorHelpers::FClassFinder<AActor> DefaultSkySphere(ActorPortraitHelpers::DefaultSkySpherePath);
 	SkySphereClass = DefaultSkySphere.Class;
 	UserDataClass  = UPortraitEnvironmentSettings::StaticClass();
+
+	bLoadBackgroundWorldAsync = false;
+	bWaitForStreamingLevels   = true;
+	StreamingLevelsTimeout    = 10.f;
+	SharedStageName           = NAME_None;
+	WorldProfile              = EPortraitWorldProfile::Full;
+	bPruneBackgroundActors    = false;
+	BackgroundPruneDistance   = 0.f;
+	bRenderToAtlas            = false;
+	BakedBackdrop             = nullptr;
 }
 
 UWorld* UActorPortrait::GetPortraitWorld() const
@@ -91,6 +113,16 @@ UWorld* UActorPortrait::GetPortraitWorld() const
 	return ViewportWidget.IsValid() ? ViewportWidget->GetPortraitWorld() : nullptr;
 }
 
+bool UActorPortrait::IsPortraitSceneLoading() const
+{
+	return ViewportWidget.IsValid() && ViewportWidget->IsPortraitSceneLoading();
+}
+
+bool UActorPortrait::IsPortraitReady() const
+{
+	return ViewportWidget.IsValid() && ViewportWidget->IsPortraitReady();
+}
+
 AActor* UActorPortrait::GetPortraitSkySphereActor() const
 {
 	return ViewportWidget.IsValid() ? ViewportWidget->GetSkySphereActor() : nullptr;
@@ -153,6 +185,33 @@ void UActorPortrait::SetTickWorld(bool bInTickWorld)
 	}
 }
 
+void UActorPortrait::SetTickRate(float InTickRate)
+{
+	TickRate = FMath::Max(InTickRate, 0.f);
+	if (ViewportWidget.IsValid())
+	{
+		ViewportWidget->SetTickRate(TickRate);
+	}
+}
+
+void UActorPortrait::SetTimeDilation(float InTimeDilation)
+{
+	TimeDilation = FMath::Max(InTimeDilation, 0.f);
+	if (ViewportWidget.IsValid())
+	{
+		ViewportWidget->SetTimeDilation(TimeDilation);
+	}
+}
+
+void UActorPortrait::SetTickPriority(int32 InTickPriority)
+{
+	TickPriority = InTickPriority;
+	if (ViewportWidget.IsValid())
+	{
+		ViewportWidget->SetTickPriority(TickPriority);
+	}
+}
+
 void UActorPortrait::SetIsRealTime(bool bInIsRealTime)
 {
 	bIsRealTime = bInIsRealTime;
@@ -162,6 +221,15 @@ void UActorPortrait::SetIsRealTime(bool bInIsRealTime)
 	}
 }
 
+void UActorPortrait::SetMaxCaptureRate(float InMaxCaptureRate)
+{
+	MaxCaptureRate = FMath::Max(InMaxCaptureRate, 0.f);
+	if (ViewportWidget.IsValid())
+	{
+		ViewportWidget->SetMaxCaptureRate(MaxCaptureRate);
+	}
+}
+
 void UActorPortrait::SetCaptureSource(ESceneCaptureSource InCaptureSource)
 {
 	CaptureSource = InCaptureSource;
@@ -171,13 +239,34 @@ void UActorPortrait::SetCaptureSource(ESceneCaptureSource InCaptureSource)
 	}
 }
 
+void UActorPortrait::SetRenderTargetFormat(EPortraitRenderTargetFormat InRenderTargetFormat)
+{
+	RenderTargetFormat = InRenderTargetFormat;
+	if (ViewportWidget.IsValid())
+	{
+		ViewportWidget->SetRenderTargetFormat(InRenderTargetFormat);
+	}
+}
+
+int64 UActorPortrait::GetRenderTargetMemorySize() const
+{
+	return ViewportWidget.IsValid() ? ViewportWidget->GetRenderTargetMemorySize() : 0;
+}
+
 void UActorPortrait::SetPortraitActorClass(TSubclassOf<AActor> NewActorClass, bool bResetCamera)
 {
 	const bool bActorClassChanged = ActorClass != NewActorClass;
 	ActorClass = NewActorClass;
 	if (bActorClassChanged && ViewportWidget.IsValid()) 
 	{
-		ViewportWidget->RecreatePortraitActor(NewActorClass, ActorTransform, bResetCamera);
+		if (ViewportWidget->NeedsNewPortraitScene(NewActorClass))
+		{
+			ViewportWidget->RecreatePortraitScene(GetPortraitWorldAsset(), ActorClass, ActorTransform, SkySphereClass, DirectionalLightComponentTemplate, SkyLightComponentTemplate, GetOwningGameInstance());
+		}
+		else
+		{
+			ViewportWidget->RecreatePortraitActor(NewActorClass, ActorTransform, bResetCamera);
+		}
 	}
 }
 
@@ -204,14 +293,15 @@ void UActorPortrait::SetPortraitUserDataClass(TSubclassOf<UObject> InUserDataCla
 {
 	UserDataClass = InUserDataClass;
 
-	if ((UserData && UserData->GetClass() != UserDataClass.Get()) || (!UserData && UserDataClass.Get()))
+	const bool bUserDataClassChanged = (UserData && UserData->GetClass() != UserDataClass.Get()) || (!UserData && UserDataClass.Get());
+	if (bUserDataClassChanged)
 	{
 		RecreateUserData();
 	}
 
-	if (ViewportWidget.IsValid())
+	if (bUserDataClassChanged && ViewportWidget.IsValid())
 	{
-		ViewportWidget->SetPortraitUserData(UserData);
+		ViewportWidget->SetPortraitUserData(GetPortraitUserData());
 	}
 }
 
@@ -222,7 +312,19 @@ void UActorPortrait::SetPortraitBackgroundWorld(TSoftObjectPtr<UWorld> NewBackgr
 
 	if (bBackgroundWorldChanged && ViewportWidget.IsValid())
 	{
-		ViewportWidget->RecreatePortraitScene(BackgroundWorldAsset, ActorClass, ActorTransform, SkySphereClass, DirectionalLightComponentTemplate, SkyLightComponentTemplate, GetOwningGameInstance());
+		ViewportWidget->RecreatePortraitScene(GetPortraitWorldAsset(), ActorClass, ActorTransform, SkySphereClass, DirectionalLightComponentTemplate, SkyLightComponentTemplate, GetOwningGameInstance());
+	}
+}
+
+void UActorPortrait::SetPortraitBakedBackdrop(UPortraitBakedBackdrop* NewBakedBackdrop)
+{
+	const bool bBakedBackdropChanged = BakedBackdrop != NewBakedBackdrop;
+	BakedBackdrop = NewBakedBackdrop;
+
+	if (bBakedBackdropChanged && ViewportWidget.IsValid())
+	{
+		ViewportWidget->SetPortraitUserData(GetPortraitUserData(), false);
+		ViewportWidget->RecreatePortraitScene(GetPortraitWorldAsset(), ActorClass, ActorTransform, SkySphereClass, DirectionalLightComponentTemplate, SkyLightComponentTemplate, GetOwningGameInstance());
 	}
 }
 
@@ -230,7 +332,7 @@ void UActorPortrait::ApplyUserData()
 {
 	if (ViewportWidget.IsValid())
 	{
-		ViewportWidget->SetPortraitUserData(UserData);
+		ViewportWidget->SetPortraitUserData(GetPortraitUserData(true));
 	}
 }
 
@@ -440,7 +542,10 @@ void UActorPortrait::PreEditChange(FEditPropertyChain& EditPropertyChain)
 	{
 		DirtyFlags.bUserDataDirty = true;
 	}
-	else if (HAS_MEMBER_PROPERTY_CHANGED(UActorPortrait, BackgroundWorldAsset))
+	else if (HAS_MEMBER_PROPERTY_CHANGED(UActorPortrait, BackgroundWorldAsset)
+		  || HAS_MEMBER_PROPERTY_CHANGED(UActorPortrait, BakedBackdrop)
+		  || HAS_MEMBER_PROPERTY_CHANGED(UActorPortrait, SharedStageName)
+		  || HAS_MEMBER_PROPERTY_CHANGED(UActorPortrait, WorldProfile))
 	{
 		DirtyFlags.bBackgroundWorldDirty = true;
 	}
@@ -501,14 +606,14 @@ TSharedRef<SWidget> UActorPortrait::RebuildWidget()
 	}
 
 	SAssignNew(ViewportWidget, SActorPortrait)
-		.WorldAsset(BackgroundWorldAsset)
+		.WorldAsset(GetPortraitWorldAsset())
 		.PortraitActorClass(ActorClass)
 		.PortraitActorTransform(ActorTransform)
 		.DirectionalLightTemplate(DirectionalLightComponentTemplate)
 		.SkyLightTemplate(SkyLightComponentTemplate)
 		.SkySphereClass(SkySphereClass)
 		.OwningGameInstance(GetOwningGameInstance())
-		.PortraitUserData(UserData)
+		.PortraitUserData(GetPortraitUserData())
 		.ColorAndOpacity(ColorAndOpacity)
 		.PortraitCameraSettings(FPortraitCameraSettings::MergePortraitCameraSettings(PortraitCameraSettings, FPortraitCameraSettings::DefaultCameraSettings()))
 		.PostProcessingSettings(PostProcessingSettings)
@@ -519,6 +624,7 @@ TSharedRef<SWidget> UActorPortrait::RebuildWidget()
 		.ResolutionScale(ResolutionScale)
 		.bLockDuringCapture(bLockMouseDuringCapture)
 		.bRealTime(bIsRealTime)
+		.MaxCaptureRate(MaxCaptureRate)
 		.bShouldShowMouseCursor_Lambda([&]()->bool
 		{
 			UWorld* World = GetWorld();
@@ -535,7 +641,20 @@ TSharedRef<SWidget> UActorPortrait::RebuildWidget()
 			return true;
 		})
 		.bTickWorld(bTickWorld)
+		.TickRate(TickRate)
+		.TimeDilation(TimeDilation)
+		.TickPriority(TickPriority)
 		.CaptureSource(CaptureSource)
+		.RenderTargetFormat(RenderTargetFormat)
+		.bLoadWorldAsync(bLoadBackgroundWorldAsync)
+		.PlaceholderBrush(&PlaceholderBrush)
+		.SharedStageName(SharedStageName)
+		.WorldProfile(WorldProfile)
+		.bWaitForStreamingLevels(bWaitForStreamingLevels)
+		.StreamingLevelsTimeout(StreamingLevelsTimeout)
+		.bPruneBackgroundActors(bPruneBackgroundActors)
+		.BackgroundPruneDistance(BackgroundPruneDistance)
+		.bRenderToAtlas(bRenderToAtlas)
 		
 		.OnInputTouchEvent_Lambda([&](const FGeometry& Geometry, const FPointerEvent& PointerEvent)->FReply
 		{
@@ -632,6 +751,14 @@ TSharedRef<SWidget> UActorPortrait::RebuildWidget()
 		.PostCameraResetEvent_Lambda([&]()
 		{
 			PostCameraResetEvent.Broadcast();
+		})
+		.OnPortraitSceneLoadedEvent_Lambda([&](bool bSuccess)
+		{
+			OnPortraitSceneLoadedEvent.Broadcast(bSuccess);
+		})
+		.OnPortraitReadyEvent_Lambda([&](bool bTimedOut)
+		{
+			OnPortraitReadyEvent.Broadcast(bTimedOut);
 		});
 
 	if (GetChildrenCount() > 0)
@@ -652,8 +779,13 @@ void UActorPortrait::SynchronizeProperties()
 		ViewportWidget->SetColorAndOpacity(PROPERTY_BINDING(FSlateColor, ColorAndOpacity));
 		ViewportWidget->SetLockDuringCapture(bLockMouseDuringCapture);
 		ViewportWidget->SetRealTime(bIsRealTime);
+		ViewportWidget->SetMaxCaptureRate(MaxCaptureRate);
 		ViewportWidget->SetTickWorld(bTickWorld);
+		ViewportWidget->SetTickRate(TickRate);
+		ViewportWidget->SetTimeDilation(TimeDilation);
+		ViewportWidget->SetTickPriority(TickPriority);
 		ViewportWidget->SetCaptureSource(CaptureSource);
+		ViewportWidget->SetRenderTargetFormat(RenderTargetFormat);
 		ViewportWidget->SetPortraitSize(PortraitSize);
 		ViewportWidget->SetRenderResolutionOverride(bOverride_RenderResolutionOverride ? RenderResolutionOverride : TOptional<FIntPoint>());
 		ViewportWidget->SetResolutionScale(ResolutionScale);
@@ -675,11 +807,19 @@ void UActorPortrait::SynchronizeProperties()
 			RecreateUserData();
 		}
 
-		ViewportWidget->SetPortraitUserData(UserData, false);
+		ViewportWidget->SetPortraitUserData(GetPortraitUserData(DirtyFlags.bUserDataDirty), false);
+		ViewportWidget->SetBackgroundPruning(bPruneBackgroundActors, BackgroundPruneDistance);
+		ViewportWidget->SetRenderToAtlas(bRenderToAtlas);
 
-		if (DirtyFlags.bBackgroundWorldDirty)
+		// The lights are shared by every portrait on a stage, a portrait whose light templates changed moves to the stage with its new lights.
+		// The Auto world profile picks the engine subsystems of the portrait world from the actor class, so the world may need to be recreated for a new actor class.
+		if (DirtyFlags.bBackgroundWorldDirty 
+			|| (DirtyFlags.bLightTemplatesDirty && !SharedStageName.IsNone()) 
+			|| (DirtyFlags.bActorClassDirty && ViewportWidget->NeedsNewPortraitScene(ActorClass)))
 		{
-			ViewportWidget->RecreatePortraitScene(BackgroundWorldAsset, ActorClass, ActorTransform, SkySphereClass, DirectionalLightComponentTemplate, SkyLightComponentTemplate, GetOwningGameInstance());
+			ViewportWidget->SetSharedStageName(SharedStageName);
+			ViewportWidget->SetWorldProfile(WorldProfile);
+			ViewportWidget->RecreatePortraitScene(GetPortraitWorldAsset(), ActorClass, ActorTransform, SkySphereClass, DirectionalLightComponentTemplate, SkyLightComponentTemplate, GetOwningGameInstance());
 		}
 		else
 		{
@@ -752,9 +892,99 @@ void UActorPortrait::RecreateUserData()
 		UserData = ActorPortraitHelpers::NewInstancedSubObj<UObject>(this, UserDataClass.Get());
 }
 
+TSoftObjectPtr<UWorld> UActorPortrait::GetPortraitWorldAsset() const
+{
+	// Fall back to the background world until the backdrop has been baked
+	return IsValid(BakedBackdrop) && IsValid(BakedBackdrop->CubeMap) ? TSoftObjectPtr<UWorld>() : BackgroundWorldAsset;
+}
+
+UObject* UActorPortrait::GetPortraitUserData(bool bUserDataEdited)
+{
+	if (!IsValid(BakedBackdrop) || !IsValid(BakedBackdrop->CubeMap))
+	{
+		BakedBackdropUserData = nullptr;
+		return UserData;
+	}
+
+	if (BakedBackdropUserData && !bUserDataEdited && BakedBackdropUserDataSource == UserData && BakedBackdropUserDataCubeMap == BakedBackdrop->CubeMap)
+	{
+		return BakedBackdropUserData;
+	}
+
+	BakedBackdropUserData = nullptr;
+
+	UPortraitEnvironmentSettings* EnvironmentSettings = Cast<UPortraitEnvironmentSettings>(UserData);
+	if (!EnvironmentSettings)
+	{
+		UE_LOG(LogActorPortrait, Warning, TEXT("%s can't render baked backdrop %s, its user data (%s) isn't a PortraitEnvironmentSettings"), 
+			*GetPathName(), *BakedBackdrop->GetPathName(), UserData ? *UserData->GetClass()->GetName() : TEXT("None"));
+		return UserData;
+	}
+
+	// The backdrop is applied to a transient copy, the user data is saved with the widget and keeps its own environment cube map
+	UPortraitEnvironmentSettings* BackdropSettings = DuplicateObject<UPortraitEnvironmentSettings>(EnvironmentSettings, GetTransientPackage());
+	BackdropSettings->SetFlags(RF_Transient);
+	BackdropSettings->EnvironmentCubeMap = BakedBackdrop->CubeMap;
+
+	BakedBackdropUserData        = BackdropSettings;
+	BakedBackdropUserDataSource  = UserData;
+	BakedBackdropUserDataCubeMap = BakedBackdrop->CubeMap;
+	return BakedBackdropUserData;
+}
+
 UGameInstance* UActorPortrait::GetOwningGameInstance() const
 {
 	return GetWorld() ? GetWorld()->GetGameInstance() : nullptr;
 }
 
+int32 UActorPortrait::PrewarmPortraitScenes(UObject* WorldContextObject, TSoftObjectPtr<UWorld> BackgroundWorld, TSubclassOf<AActor> PortraitActorClass, TSubclassOf<AActor> PortraitSkySphereClass, EPortraitWorldProfile PortraitWorldProfile, int32 NumScenes)
+{
+	UWorld* World = GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::LogAndReturnNull);
+	if (!World)
+	{
+		return 0;
+	}
+
+	// Must match the construction values of the widget for it to adopt the prewarmed world, see RebuildWidget
+	UClass* PrewarmSkySphereClass = PortraitSkySphereClass ? PortraitSkySphereClass.Get() : GetDefault<UActorPortrait>()->SkySphereClass.Get();
+	const FInstanceWorld::ConstructionValues CVS = FActorPortraitScene::MakeConstructionValues(BackgroundWorld, PortraitActorClass.Get(), PrewarmSkySphereClass, PortraitWorldProfile, World->GetGameInstance());
+
+	return FActorPortraitScenePool::Get().PrewarmScenes(CVS, NumScenes);
+}
+
+void UActorPortrait::PrewarmPortraitScenesFromSettings(UWorld* LoadedWorld)
+{
+	if (!IsValid(LoadedWorld) || !LoadedWorld->IsGameWorld())
+	{
+		return;
+	}
+
+	const FString LoadedMapName = UWorld::RemovePIEPrefix(LoadedWorld->GetOutermost()->GetName());
+
+	for (const FPortraitPrewarmSettings& PrewarmSettings : UActorPortraitProjectSettings::Get().PrewarmedScenes)
+	{
+		if (PrewarmSettings.BackgroundWorld.IsNull())
+		{
+			continue;
+		}
+
+		const bool bPrewarmOnMap = PrewarmSettings.PrewarmOnMaps.Num() == 0 || PrewarmSettings.PrewarmOnMaps.ContainsByPredicate([&LoadedMapName](const TSoftObjectPtr<UWorld>& Map)
+		{
+			return Map.GetLongPackageName() == LoadedMapName;
+		});
+
+		if (!bPrewarmOnMap)
+		{
+			continue;
+		}
+
+		// The classes are only needed to pick the subsystems of the Auto world profile
+		const bool bNeedsClasses = PrewarmSettings.WorldProfile == EPortraitWorldProfile::Auto;
+		UClass* PrewarmActorClass     = bNeedsClasses ? PrewarmSettings.ActorClass.LoadSynchronous() : PrewarmSettings.ActorClass.Get();
+		UClass* PrewarmSkySphereClass = bNeedsClasses ? PrewarmSettings.SkySphereClass.LoadSynchronous() : PrewarmSettings.SkySphereClass.Get();
+
+		PrewarmPortraitScenes(LoadedWorld, PrewarmSettings.BackgroundWorld, PrewarmActorClass, PrewarmSkySphereClass, PrewarmSettings.WorldProfile, PrewarmSettings.NumScenes);
+	}
+}
+
 #undef LOCTEXT_NAMESPACE
\ No newline at end of file
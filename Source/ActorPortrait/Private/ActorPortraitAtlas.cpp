@@ -0,0 +1,614 @@
+// Copyright Mans Isaksson. All Rights Reserved.
+
+#include "ActorPortraitAtlas.h"
+#include "ActorPortraitModule.h"
+#include "ActorPortraitProjectSettings.h"
+
+#include "Framework/Application/SlateApplication.h"
+#include "HAL/IConsoleManager.h"
+#include "RenderGraphBuilder.h"
+#include "RenderGraphUtils.h"
+#include "RenderingThread.h"
+#include "TextureResource.h"
+#include "UObject/Package.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Atlas Pages"), STAT_ActorPortraitAtlas_NumPages, STATGROUP_ActorPortrait);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Atlas Allocations"), STAT_ActorPortraitAtlas_NumAllocations, STATGROUP_ActorPortrait);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Atlas Copies"), STAT_ActorPortraitAtlas_NumCopies, STATGROUP_ActorPortrait);
+DECLARE_MEMORY_STAT(TEXT("Atlas Page Memory"), STAT_ActorPortraitAtlas_PageMemory, STATGROUP_ActorPortrait);
+
+static FAutoConsoleCommand DefragmentAtlasCommand(
+	TEXT("ActorPortrait.DefragmentAtlas"),
+	TEXT("Repacks all portrait atlas pages, freeing the space left behind by portraits which were destroyed or resized."),
+	FConsoleCommandDelegate::CreateLambda([]() { FActorPortraitAtlas::Get().Defragment(); }));
+
+FActorPortraitAtlas& FActorPortraitAtlas::Get()
+{
+	static FActorPortraitAtlas Atlas;
+	return Atlas;
+}
+
+int32 FActorPortraitAtlas::Allocate(const FIntPoint& Size, UTextureRenderTarget2D* Source)
+{
+	check(IsInGameThread());
+
+	if (!IsValid(Source) || Size.X <= 0 || Size.Y <= 0)
+	{
+		return INDEX_NONE;
+	}
+
+	FAtlasAllocation Allocation;
+	Allocation.Source = Source;
+
+	if (!AllocateRect(Allocation, Size, Source->RenderTargetFormat))
+	{
+		UE_LOG(LogActorPortrait, Verbose, TEXT("Portrait of size %dx%d doesn't fit in the atlas"), Size.X, Size.Y);
+		return INDEX_NONE;
+	}
+
+	const int32 AllocationId = NextAllocationId++;
+	Allocations.Add(AllocationId, Allocation);
+	SourceAllocations.Add(Source, AllocationId);
+
+	EnqueueCopy(Allocation);
+	UpdateStats();
+
+	return AllocationId;
+}
+
+bool FActorPortraitAtlas::Reallocate(int32 AllocationId, const FIntPoint& Size, UTextureRenderTarget2D* Source)
+{
+	check(IsInGameThread());
+
+	FAtlasAllocation* Allocation = Allocations.Find(AllocationId);
+	if (!Allocation)
+	{
+		return false;
+	}
+
+	if (Allocation->Rect.Size() == Size && Allocation->Source == TObjectKey<UTextureRenderTarget2D>(Source) && IsValid(Source))
+	{
+		return true;
+	}
+
+	// Remove the allocation before looking for a new rectangle, so it isn't moved along if its page is repacked
+	const FAtlasAllocation PreviousAllocation = *Allocation;
+	Allocations.Remove(AllocationId);
+	SourceAllocations.Remove(PreviousAllocation.Source);
+	FreeRect(PreviousAllocation);
+
+	FAtlasAllocation NewAllocation;
+	NewAllocation.Source = Source;
+
+	const bool bAllocated = IsValid(Source) && Size.X > 0 && Size.Y > 0 && AllocateRect(NewAllocation, Size, Source->RenderTargetFormat);
+	if (bAllocated)
+	{
+		Allocations.Add(AllocationId, NewAllocation);
+		SourceAllocations.Add(Source, AllocationId);
+		EnqueueCopy(NewAllocation);
+	}
+
+	// Empty pages are released after allocating, so a portrait moving within its own page doesn't destroy and re-create it
+	ReleaseEmptyPages();
+	UpdateStats();
+
+	return bAllocated;
+}
+
+void FActorPortraitAtlas::Free(int32 AllocationId)
+{
+	check(IsInGameThread());
+
+	FAtlasAllocation Allocation;
+	if (!Allocations.RemoveAndCopyValue(AllocationId, Allocation))
+	{
+		return;
+	}
+
+	SourceAllocations.Remove(Allocation.Source);
+	FreeRect(Allocation);
+	ReleaseEmptyPages();
+
+	if (Pages.IsValidIndex(Allocation.PageIndex) && IsFragmented(Pages[Allocation.PageIndex]))
+	{
+		RequestRepack(Allocation.PageIndex);
+	}
+
+	UpdateStats();
+}
+
+bool FActorPortraitAtlas::GetAllocation(int32 AllocationId, UTextureRenderTarget2D*& OutPage, FBox2f& OutUVRegion) const
+{
+	const FAtlasAllocation* Allocation = Allocations.Find(AllocationId);
+	if (!Allocation || !Pages.IsValidIndex(Allocation->PageIndex))
+	{
+		return false;
+	}
+
+	UTextureRenderTarget2D* PageRenderTarget = Pages[Allocation->PageIndex].RenderTarget;
+	if (!PageRenderTarget)
+	{
+		return false;
+	}
+
+	const FVector2f PageSize((float)PageRenderTarget->SizeX, (float)PageRenderTarget->SizeY);
+
+	OutPage     = PageRenderTarget;
+	OutUVRegion = FBox2f(FVector2f(Allocation->Rect.Min) / PageSize, FVector2f(Allocation->Rect.Max) / PageSize);
+	return true;
+}
+
+void FActorPortraitAtlas::CopyFromSource(const UTextureRenderTarget2D* Source)
+{
+	if (Allocations.Num() == 0 || !Source)
+	{
+		return;
+	}
+
+	if (const int32* AllocationId = SourceAllocations.Find(Source))
+	{
+		EnqueueCopy(Allocations.FindChecked(*AllocationId));
+	}
+}
+
+void FActorPortraitAtlas::Defragment()
+{
+	check(IsInGameThread());
+
+	for (int32 PageIndex = 0; PageIndex < Pages.Num(); ++PageIndex)
+	{
+		if (Pages[PageIndex].RenderTarget)
+		{
+			RequestRepack(PageIndex);
+		}
+	}
+}
+
+void FActorPortraitAtlas::Flush()
+{
+	check(IsInGameThread());
+
+	for (FAtlasPage& Page : Pages)
+	{
+		DestroyPageRenderTarget(Page.RenderTarget);
+	}
+
+	Pages.Reset();
+	Allocations.Reset();
+	SourceAllocations.Reset();
+	Generation++;
+
+	if (SlatePreTickHandle.IsValid() && FSlateApplication::IsInitialized())
+	{
+		FSlateApplication::Get().OnPreTick().Remove(SlatePreTickHandle);
+	}
+	SlatePreTickHandle.Reset();
+
+	UpdateStats();
+}
+
+FIntPoint FActorPortraitAtlas::GetPaddedSize(const FIntPoint& Size) const
+{
+	const int32 Padding = FMath::Max(UActorPortraitProjectSettings::Get().AtlasPadding, 0);
+	return Size + FIntPoint(Padding * 2, Padding * 2);
+}
+
+bool FActorPortraitAtlas::PlaceInPage(FAtlasPage& Page, int32 PageSize, FAtlasAllocation& Allocation, const FIntPoint& Size) const
+{
+	const FIntPoint PaddedSize = GetPaddedSize(Size);
+	if (PaddedSize.X > PageSize || PaddedSize.Y > PageSize)
+	{
+		return false;
+	}
+
+	// Use the lowest shelf the rectangle fits in, to waste as little of the shelf height as possible
+	FAtlasShelf* BestShelf = nullptr;
+	for (FAtlasShelf& Shelf : Page.Shelves)
+	{
+		if (Shelf.Height >= PaddedSize.Y && PageSize - Shelf.Width >= PaddedSize.X && (!BestShelf || Shelf.Height < BestShelf->Height))
+		{
+			BestShelf = &Shelf;
+		}
+	}
+
+	// Open a new shelf below the last one if the rectangle doesn't fit in any, or would leave most of the shelf height unused
+	const int32 NextShelfY = Page.Shelves.Num() > 0 ? Page.Shelves.Last().Y + Page.Shelves.Last().Height : 0;
+	const bool bCanOpenShelf = NextShelfY + PaddedSize.Y <= PageSize;
+
+	if (bCanOpenShelf && (!BestShelf || BestShelf->Height > PaddedSize.Y * 2))
+	{
+		BestShelf = &Page.Shelves.Add_GetRef(FAtlasShelf{ NextShelfY, PaddedSize.Y, 0 });
+	}
+
+	if (!BestShelf)
+	{
+		return false;
+	}
+
+	const FIntPoint Padding = (PaddedSize - Size) / 2;
+	const FIntPoint RectMin(BestShelf->Width + Padding.X, BestShelf->Y + Padding.Y);
+
+	Allocation.Rect = FIntRect(RectMin, RectMin + Size);
+
+	BestShelf->Width   += PaddedSize.X;
+	Page.AllocatedArea += (int64)PaddedSize.X * PaddedSize.Y;
+
+	return true;
+}
+
+bool FActorPortraitAtlas::IsFragmented(const FAtlasPage& Page) const
+{
+	if (!Page.RenderTarget)
+	{
+		return false;
+	}
+
+	int64 ShelfArea = 0;
+	for (const FAtlasShelf& Shelf : Page.Shelves)
+	{
+		ShelfArea += (int64)Shelf.Width * Shelf.Height;
+	}
+
+	// Only repack pages which are getting full, repacking copies every portrait on the page again
+	const int64 PageArea = (int64)Page.RenderTarget->SizeX * Page.RenderTarget->SizeY;
+	return ShelfArea > PageArea / 2 && Page.AllocatedArea < ShelfArea / 2;
+}
+
+bool FActorPortraitAtlas::RepackPage(int32 PageIndex, int32 PageSize, bool bInPlace)
+{
+	FAtlasPage& Page = Pages[PageIndex];
+	if (!Page.RenderTarget)
+	{
+		return false;
+	}
+
+	TArray<int32> PageAllocationIds;
+	for (const TPair<int32, FAtlasAllocation>& Pair : Allocations)
+	{
+		if (Pair.Value.PageIndex == PageIndex)
+		{
+			PageAllocationIds.Add(Pair.Key);
+		}
+	}
+
+	// Packing the tallest rectangles first keeps the shelves tight
+	PageAllocationIds.Sort([this](int32 A, int32 B)
+	{
+		return Allocations[A].Rect.Height() > Allocations[B].Rect.Height();
+	});
+
+	FAtlasPage RepackedPage;
+	TArray<FAtlasAllocation> RepackedAllocations;
+	RepackedAllocations.Reserve(PageAllocationIds.Num());
+
+	for (int32 AllocationId : PageAllocationIds)
+	{
+		FAtlasAllocation RepackedAllocation = Allocations[AllocationId];
+		if (!PlaceInPage(RepackedPage, PageSize, RepackedAllocation, RepackedAllocation.Rect.Size()))
+		{
+			return false;
+		}
+
+		RepackedAllocations.Add(RepackedAllocation);
+	}
+
+	if (Page.RenderTarget->SizeX != PageSize || !bInPlace)
+	{
+		// Portraits which already drew the old page this frame keep drawing it intact
+		const ETextureRenderTargetFormat Format = Page.RenderTarget->RenderTargetFormat;
+		DestroyPageRenderTarget(Page.RenderTarget);
+		RepackedPage.RenderTarget = CreatePageRenderTarget(PageSize, Format);
+
+		UE_LOG(LogActorPortrait, Verbose, TEXT("Repacked portrait atlas page %d into a new %dx%d page (%d portraits)"), PageIndex, PageSize, PageSize, PageAllocationIds.Num());
+	}
+	else
+	{
+		RepackedPage.RenderTarget = Page.RenderTarget;
+		EnqueueClear(RepackedPage.RenderTarget);
+	}
+
+	Page = MoveTemp(RepackedPage);
+
+	for (int32 Index = 0; Index < PageAllocationIds.Num(); ++Index)
+	{
+		FAtlasAllocation& Allocation = Allocations[PageAllocationIds[Index]];
+		Allocation = RepackedAllocations[Index];
+		EnqueueCopy(Allocation);
+	}
+
+	Generation++;
+	return true;
+}
+
+void FActorPortraitAtlas::RequestRepack(int32 PageIndex)
+{
+	if (!FSlateApplication::IsInitialized())
+	{
+		if (Pages[PageIndex].RenderTarget)
+		{
+			RepackPage(PageIndex, Pages[PageIndex].RenderTarget->SizeX, true);
+			UpdateStats();
+		}
+		return;
+	}
+
+	Pages[PageIndex].bPendingRepack = true;
+
+	if (!SlatePreTickHandle.IsValid())
+	{
+		SlatePreTickHandle = FSlateApplication::Get().OnPreTick().AddRaw(this, &FActorPortraitAtlas::OnSlatePreTick);
+	}
+}
+
+void FActorPortraitAtlas::OnSlatePreTick(float DeltaTime)
+{
+	bool bRepacked = false;
+
+	for (int32 PageIndex = 0; PageIndex < Pages.Num(); ++PageIndex)
+	{
+		FAtlasPage& Page = Pages[PageIndex];
+		if (Page.bPendingRepack)
+		{
+			Page.bPendingRepack = false;
+			bRepacked |= Page.RenderTarget && RepackPage(PageIndex, Page.RenderTarget->SizeX, true);
+		}
+	}
+
+	if (bRepacked)
+	{
+		UpdateStats();
+	}
+}
+
+bool FActorPortraitAtlas::AllocateRect(FAtlasAllocation& Allocation, const FIntPoint& Size, ETextureRenderTargetFormat Format)
+{
+	const UActorPortraitProjectSettings& Settings = UActorPortraitProjectSettings::Get();
+
+	const int32 MaxPageSize  = FMath::Max(Settings.AtlasMaxPageSize, 1);
+	const FIntPoint PaddedSize = GetPaddedSize(Size);
+	if (PaddedSize.X > MaxPageSize || PaddedSize.Y > MaxPageSize)
+	{
+		return false;
+	}
+
+	auto IsUsablePage = [Format](const FAtlasPage& Page)
+	{
+		return Page.RenderTarget && Page.RenderTarget->RenderTargetFormat == Format;
+	};
+
+	// Room left in an existing page
+	for (int32 PageIndex = 0; PageIndex < Pages.Num(); ++PageIndex)
+	{
+		if (IsUsablePage(Pages[PageIndex]) && PlaceInPage(Pages[PageIndex], Pages[PageIndex].RenderTarget->SizeX, Allocation, Size))
+		{
+			Allocation.PageIndex = PageIndex;
+			return true;
+		}
+	}
+
+	// Room left behind by freed allocations
+	for (int32 PageIndex = 0; PageIndex < Pages.Num(); ++PageIndex)
+	{
+		FAtlasPage& Page = Pages[PageIndex];
+		if (!IsUsablePage(Page))
+		{
+			continue;
+		}
+
+		const int32 PageSize = Page.RenderTarget->SizeX;
+		const int64 PageArea = (int64)PageSize * PageSize;
+		if (Page.AllocatedArea + (int64)PaddedSize.X * PaddedSize.Y > PageArea * 3 / 4)
+		{
+			continue; // Unlikely to fit even when repacked
+		}
+
+		if (RepackPage(PageIndex, PageSize, false) && PlaceInPage(Page, PageSize, Allocation, Size))
+		{
+			Allocation.PageIndex = PageIndex;
+			return true;
+		}
+	}
+
+	// Grow a page, fewer larger pages draw in fewer batches than many small ones
+	for (int32 PageIndex = 0; PageIndex < Pages.Num(); ++PageIndex)
+	{
+		if (!IsUsablePage(Pages[PageIndex]))
+		{
+			continue;
+		}
+
+		for (int32 PageSize = Pages[PageIndex].RenderTarget->SizeX * 2; PageSize <= MaxPageSize; PageSize *= 2)
+		{
+			if (RepackPage(PageIndex, PageSize, false) && PlaceInPage(Pages[PageIndex], PageSize, Allocation, Size))
+			{
+				Allocation.PageIndex = PageIndex;
+				return true;
+			}
+		}
+	}
+
+	// New page, large enough for the rectangle
+	int32 NewPageSize = FMath::Clamp(Settings.AtlasInitialPageSize, 1, MaxPageSize);
+	while (NewPageSize < PaddedSize.X || NewPageSize < PaddedSize.Y)
+	{
+		NewPageSize = FMath::Min(NewPageSize * 2, MaxPageSize);
+	}
+
+	int32 NewPageIndex = Pages.IndexOfByPredicate([](const FAtlasPage& Page) { return Page.RenderTarget == nullptr; });
+	if (NewPageIndex == INDEX_NONE)
+	{
+		NewPageIndex = Pages.AddDefaulted();
+	}
+
+	FAtlasPage& NewPage = Pages[NewPageIndex];
+	NewPage = FAtlasPage();
+	NewPage.RenderTarget = CreatePageRenderTarget(NewPageSize, Format);
+
+	UE_LOG(LogActorPortrait, Verbose, TEXT("Created portrait atlas page %d (%dx%d)"), NewPageIndex, NewPageSize, NewPageSize);
+
+	const bool bPlaced = PlaceInPage(NewPage, NewPageSize, Allocation, Size);
+	check(bPlaced);
+
+	Allocation.PageIndex = NewPageIndex;
+	return true;
+}
+
+void FActorPortraitAtlas::FreeRect(const FAtlasAllocation& Allocation)
+{
+	if (!Pages.IsValidIndex(Allocation.PageIndex))
+	{
+		return;
+	}
+
+	FAtlasPage& Page = Pages[Allocation.PageIndex];
+
+	const FIntPoint PaddedSize = GetPaddedSize(Allocation.Rect.Size());
+	const FIntPoint Padding    = (PaddedSize - Allocation.Rect.Size()) / 2;
+
+	Page.AllocatedArea = FMath::Max<int64>(Page.AllocatedArea - (int64)PaddedSize.X * PaddedSize.Y, 0);
+
+	// The space of the last rectangle on a shelf can be used again right away, other space is reclaimed by repacking the page
+	const int32 ShelfY = Allocation.Rect.Min.Y - Padding.Y;
+	for (FAtlasShelf& Shelf : Page.Shelves)
+	{
+		if (Shelf.Y == ShelfY && Shelf.Width == Allocation.Rect.Max.X + Padding.X)
+		{
+			Shelf.Width -= PaddedSize.X;
+			break;
+		}
+	}
+
+	while (Page.Shelves.Num() > 0 && Page.Shelves.Last().Width == 0)
+	{
+		Page.Shelves.Pop(EAllowShrinking::No);
+	}
+}
+
+void FActorPortraitAtlas::ReleaseEmptyPages()
+{
+	for (int32 PageIndex = 0; PageIndex < Pages.Num(); ++PageIndex)
+	{
+		FAtlasPage& Page = Pages[PageIndex];
+		if (!Page.RenderTarget || Page.AllocatedArea > 0)
+		{
+			continue;
+		}
+
+		UE_LOG(LogActorPortrait, Verbose, TEXT("Destroying empty portrait atlas page %d"), PageIndex);
+
+		DestroyPageRenderTarget(Page.RenderTarget);
+		Page = FAtlasPage();
+	}
+
+	while (Pages.Num() > 0 && !Pages.Last().RenderTarget)
+	{
+		Pages.Pop(EAllowShrinking::No);
+	}
+}
+
+UTextureRenderTarget2D* FActorPortraitAtlas::CreatePageRenderTarget(int32 PageSize, ETextureRenderTargetFormat Format) const
+{
+	UTextureRenderTarget2D* PageRenderTarget = NewObject<UTextureRenderTarget2D>(GetTransientPackage(), NAME_None, RF_Transient);
+	PageRenderTarget->RenderTargetFormat = Format;
+	PageRenderTarget->ClearColor = FLinearColor::Transparent;
+	PageRenderTarget->InitAutoFormat(PageSize, PageSize);
+	PageRenderTarget->UpdateResourceImmediate(true);
+	PageRenderTarget->AddToRoot();
+
+	return PageRenderTarget;
+}
+
+void FActorPortraitAtlas::DestroyPageRenderTarget(UTextureRenderTarget2D* RenderTarget) const
+{
+	if (!RenderTarget)
+	{
+		return;
+	}
+
+	// Not marked as garbage, brushes still drawing the page (portraits which haven't picked up the new generation) keep it alive until they do
+	RenderTarget->RemoveFromRoot();
+}
+
+void FActorPortraitAtlas::EnqueueCopy(const FAtlasAllocation& Allocation) const
+{
+	UTextureRenderTarget2D* Source = Allocation.Source.ResolveObjectPtr();
+	UTextureRenderTarget2D* PageRenderTarget = Pages.IsValidIndex(Allocation.PageIndex) ? Pages[Allocation.PageIndex].RenderTarget.Get() : nullptr;
+	if (!Source || !PageRenderTarget)
+	{
+		return;
+	}
+
+	FTextureRenderTargetResource* SourceResource = Source->GameThread_GetRenderTargetResource();
+	FTextureRenderTargetResource* PageResource   = PageRenderTarget->GameThread_GetRenderTargetResource();
+	if (!SourceResource || !PageResource)
+	{
+		return;
+	}
+
+	INC_DWORD_STAT(STAT_ActorPortraitAtlas_NumCopies);
+
+	const FIntRect Rect = Allocation.Rect;
+	ENQUEUE_RENDER_COMMAND(ActorPortraitAtlasCopy)([SourceResource, PageResource, Rect](FRHICommandListImmediate& RHICmdList)
+	{
+		FRHITexture* SourceTexture = SourceResource->GetRenderTargetTexture();
+		FRHITexture* PageTexture   = PageResource->GetRenderTargetTexture();
+		if (!SourceTexture || !PageTexture)
+		{
+			return;
+		}
+
+		// The portrait is rendered to the top left of its own render target
+		FRHICopyTextureInfo CopyInfo;
+		CopyInfo.Size         = FIntVector(Rect.Width(), Rect.Height(), 1);
+		CopyInfo.DestPosition = FIntVector(Rect.Min.X, Rect.Min.Y, 0);
+
+		FRDGBuilder GraphBuilder(RHICmdList);
+		FRDGTextureRef SourceRDGTexture = GraphBuilder.RegisterExternalTexture(CreateRenderTarget(SourceTexture, TEXT("ActorPortraitAtlasSource")));
+		FRDGTextureRef PageRDGTexture   = GraphBuilder.RegisterExternalTexture(CreateRenderTarget(PageTexture, TEXT("ActorPortraitAtlasPage")));
+		AddCopyTexturePass(GraphBuilder, SourceRDGTexture, PageRDGTexture, CopyInfo);
+		GraphBuilder.Execute();
+	});
+}
+
+void FActorPortraitAtlas::EnqueueClear(UTextureRenderTarget2D* PageRenderTarget) const
+{
+	FTextureRenderTargetResource* PageResource = PageRenderTarget ? PageRenderTarget->GameThread_GetRenderTargetResource() : nullptr;
+	if (!PageResource)
+	{
+		return;
+	}
+
+	const FLinearColor ClearColor = PageRenderTarget->ClearColor;
+	ENQUEUE_RENDER_COMMAND(ActorPortraitAtlasClear)([PageResource, ClearColor](FRHICommandListImmediate& RHICmdList)
+	{
+		FRHITexture* PageTexture = PageResource->GetRenderTargetTexture();
+		if (!PageTexture)
+		{
+			return;
+		}
+
+		FRDGBuilder GraphBuilder(RHICmdList);
+		FRDGTextureRef PageRDGTexture = GraphBuilder.RegisterExternalTexture(CreateRenderTarget(PageTexture, TEXT("ActorPortraitAtlasPage")));
+		AddClearRenderTargetPass(GraphBuilder, PageRDGTexture, ClearColor);
+		GraphBuilder.Execute();
+	});
+}
+
+void FActorPortraitAtlas::UpdateStats() const
+{
+	int32 NumPages = 0;
+	SIZE_T PageMemory = 0;
+
+	for (const FAtlasPage& Page : Pages)
+	{
+		if (Page.RenderTarget)
+		{
+			NumPages++;
+			PageMemory += (SIZE_T)Page.RenderTarget->CalcTextureMemorySizeEnum(TMC_ResidentMips);
+		}
+	}
+
+	SET_DWORD_STAT(STAT_ActorPortraitAtlas_NumPages, NumPages);
+	SET_DWORD_STAT(STAT_ActorPortraitAtlas_NumAllocations, Allocations.Num());
+	SET_MEMORY_STAT(STAT_ActorPortraitAtlas_PageMemory, PageMemory);
+}
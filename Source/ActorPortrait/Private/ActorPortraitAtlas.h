@@ -0,0 +1,119 @@
+// Copyright Mans Isaksson. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/TextureRenderTarget2D.h"
+#include "UObject/ObjectKey.h"
+
+/**
+ * Packs the portraits rendering to the atlas into large shared render targets (pages), so Slate can draw all portraits on a page in a single batch.
+ * Every portrait keeps capturing into its own render target, which is copied into its rectangle of the atlas after each capture, a capture can't
+ * be limited to a part of its render target without clearing the rest of it. Rectangles are packed into shelves, pages are repacked when freed
+ * rectangles leave too much of them unused, and grow up to AtlasMaxPageSize when a rectangle doesn't fit. Repacked rectangles are copied again
+ * from their portrait's render target, and the generation is bumped so portraits pick up their new rectangle.
+ *
+ * Portraits painted earlier in the frame keep drawing their old rectangle, so a page is only repacked in place (cleared and copied again) before
+ * Slate ticks the portraits. Repacks needed right away, to make room for a rectangle, go to a new render target and leave the old page untouched.
+ */
+class FActorPortraitAtlas
+{
+private:
+	struct FAtlasShelf
+	{
+		int32 Y      = 0;
+		int32 Height = 0;
+		int32 Width  = 0;
+	};
+
+	struct FAtlasPage
+	{
+		TObjectPtr<UTextureRenderTarget2D> RenderTarget;
+		TArray<FAtlasShelf> Shelves;
+		int64 AllocatedArea = 0;
+		bool bPendingRepack = false;
+	};
+
+	struct FAtlasAllocation
+	{
+		int32 PageIndex = INDEX_NONE;
+		FIntRect Rect;
+		TObjectKey<UTextureRenderTarget2D> Source;
+	};
+
+	// Pages are rooted while in use, empty pages are released and leave a null render target behind for the next page
+	TArray<FAtlasPage> Pages;
+
+	TMap<int32, FAtlasAllocation> Allocations;
+	TMap<TObjectKey<UTextureRenderTarget2D>, int32> SourceAllocations;
+
+	int32 NextAllocationId = 0;
+
+	// Bumped whenever existing allocations move to another rectangle or page
+	uint32 Generation = 0;
+
+	FDelegateHandle SlatePreTickHandle;
+
+public:
+	static FActorPortraitAtlas& Get();
+
+	// Allocates a rectangle of Size for the portrait rendering into Source, returns INDEX_NONE if Size doesn't fit in a page
+	int32 Allocate(const FIntPoint& Size, UTextureRenderTarget2D* Source);
+
+	// Moves the allocation to a rectangle of Size if its size changed, possibly to another page. Frees the allocation and returns false if Size doesn't fit in a page.
+	bool Reallocate(int32 AllocationId, const FIntPoint& Size, UTextureRenderTarget2D* Source);
+
+	void Free(int32 AllocationId);
+
+	// The page and UV region the allocation is drawn from
+	bool GetAllocation(int32 AllocationId, UTextureRenderTarget2D*& OutPage, FBox2f& OutUVRegion) const;
+
+	// Copies the latest capture of Source into its rectangle, call after the capture has been submitted
+	void CopyFromSource(const UTextureRenderTarget2D* Source);
+
+	// Repacks all pages before Slate ticks the next frame, freeing the space left behind by freed allocations
+	void Defragment();
+
+	// Destroys all pages and their allocations
+	void Flush();
+
+	FORCEINLINE uint32 GetGeneration() const { return Generation; }
+
+	FORCEINLINE bool HasAllocations() const { return Allocations.Num() > 0; }
+
+private:
+	FIntPoint GetPaddedSize(const FIntPoint& Size) const;
+
+	// Places a rectangle of Size in the shelves of a page of PageSize without moving other allocations
+	bool PlaceInPage(FAtlasPage& Page, int32 PageSize, FAtlasAllocation& Allocation, const FIntPoint& Size) const;
+
+	// True if enough of the page's shelves is left unused by freed allocations that repacking it is worthwhile
+	bool IsFragmented(const FAtlasPage& Page) const;
+
+	// Repacks all allocations of the page into a page of PageSize. A new render target is created unless the size stays the same and bInPlace is set,
+	// which is only safe while no portrait has drawn the page this frame. Returns false if they don't fit.
+	bool RepackPage(int32 PageIndex, int32 PageSize, bool bInPlace);
+
+	// Repacks the page in place before Slate ticks the next frame, or right away when Slate isn't running
+	void RequestRepack(int32 PageIndex);
+
+	void OnSlatePreTick(float DeltaTime);
+
+	// Finds room for the allocation, repacking or growing pages and creating a new page when needed
+	bool AllocateRect(FAtlasAllocation& Allocation, const FIntPoint& Size, ETextureRenderTargetFormat Format);
+
+	void FreeRect(const FAtlasAllocation& Allocation);
+
+	void ReleaseEmptyPages();
+
+	UTextureRenderTarget2D* CreatePageRenderTarget(int32 PageSize, ETextureRenderTargetFormat Format) const;
+
+	void DestroyPageRenderTarget(UTextureRenderTarget2D* RenderTarget) const;
+
+	void EnqueueCopy(const FAtlasAllocation& Allocation) const;
+
+	// Clears the page, so the padding of repacked rectangles doesn't show what used to be there
+	void EnqueueClear(UTextureRenderTarget2D* PageRenderTarget) const;
+
+	void UpdateStats() const;
+};
@@ -0,0 +1,158 @@
+// Copyright Mans Isaksson. All Rights Reserved.
+
+#include "ActorPortraitCaptureScheduler.h"
+#include "ActorPortraitModule.h"
+#include "ActorPortraitScene.h"
+
+#include "Components/SceneCaptureComponent2D.h"
+#include "Framework/Application/SlateApplication.h"
+#include "HAL/IConsoleManager.h"
+
+DECLARE_CYCLE_STAT(TEXT("Batched Scene Captures"), STAT_ActorPortraitCaptureScheduler_Flush, STATGROUP_ActorPortrait);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Batched Captures"), STAT_ActorPortraitCaptureScheduler_NumCaptures, STATGROUP_ActorPortrait);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Batched Capture Scenes"), STAT_ActorPortraitCaptureScheduler_NumScenes, STATGROUP_ActorPortrait);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Capped Captures"), STAT_ActorPortraitCaptureScheduler_NumCappedCaptures, STATGROUP_ActorPortrait);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Deferred Capped Captures"), STAT_ActorPortraitCaptureScheduler_NumDeferredCappedCaptures, STATGROUP_ActorPortrait);
+
+static TAutoConsoleVariable<bool> CVarBatchSceneCaptures(
+	TEXT("ActorPortrait.BatchSceneCaptures"),
+	true,
+	TEXT("Whether to collect the portrait captures requested while painting and render them together once Slate has painted the frame, with one scene render builder per portrait world.\n")
+	TEXT("When disabled every portrait renders its capture from its own paint call. Batched captures are drawn to the screen a frame later."));
+
+FActorPortraitCaptureScheduler& FActorPortraitCaptureScheduler::Get()
+{
+	static FActorPortraitCaptureScheduler CaptureScheduler;
+	return CaptureScheduler;
+}
+
+bool FActorPortraitCaptureScheduler::IsEnabled()
+{
+	return CVarBatchSceneCaptures.GetValueOnGameThread() && FSlateApplication::IsInitialized();
+}
+
+void FActorPortraitCaptureScheduler::RequestCapture(const TSharedPtr<FActorPortraitScene>& Scene, USceneCaptureComponent2D* CaptureComponent)
+{
+	check(IsInGameThread());
+
+	if (!Scene.IsValid() || !IsValid(CaptureComponent))
+	{
+		return;
+	}
+
+	if (!IsEnabled())
+	{
+		Scene->UpdateCaptureContents(CaptureComponent);
+		return;
+	}
+
+	FSceneCaptures* SceneCaptures = PendingCaptures.FindByPredicate([&Scene](const FSceneCaptures& Captures)
+	{
+		return Captures.Scene.HasSameObject(Scene.Get());
+	});
+
+	if (SceneCaptures == nullptr)
+	{
+		SceneCaptures = &PendingCaptures.Add_GetRef(FSceneCaptures{ Scene });
+	}
+
+	SceneCaptures->CaptureComponents.AddUnique(CaptureComponent);
+
+	if (!SlatePostTickHandle.IsValid())
+	{
+		SlatePostTickHandle = FSlateApplication::Get().OnPostTick().AddRaw(this, &FActorPortraitCaptureScheduler::OnSlatePostTick);
+	}
+}
+
+void FActorPortraitCaptureScheduler::Flush()
+{
+	check(IsInGameThread());
+
+	if (PendingCaptures.Num() == 0)
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_ActorPortraitCaptureScheduler_Flush);
+
+	// Rendering a capture may end up requesting new ones, those are rendered by the next flush
+	TArray<FSceneCaptures> CapturesToRender = MoveTemp(PendingCaptures);
+	PendingCaptures.Reset();
+
+	int32 NumCaptures = 0;
+
+	for (const FSceneCaptures& SceneCaptures : CapturesToRender)
+	{
+		TSharedPtr<FActorPortraitScene> Scene = SceneCaptures.Scene.Pin();
+		if (!Scene.IsValid())
+		{
+			continue;
+		}
+
+		TArray<USceneCaptureComponent2D*, TInlineAllocator<4>> CaptureComponents;
+		for (const TWeakObjectPtr<USceneCaptureComponent2D>& CaptureComponent : SceneCaptures.CaptureComponents)
+		{
+			if (CaptureComponent.IsValid() && CaptureComponent->IsRegistered())
+			{
+				CaptureComponents.Add(CaptureComponent.Get());
+			}
+		}
+
+		Scene->UpdateCaptureContents(CaptureComponents);
+		NumCaptures += CaptureComponents.Num();
+	}
+
+	SET_DWORD_STAT(STAT_ActorPortraitCaptureScheduler_NumCaptures, NumCaptures);
+	SET_DWORD_STAT(STAT_ActorPortraitCaptureScheduler_NumScenes, CapturesToRender.Num());
+}
+
+float FActorPortraitCaptureScheduler::AddCappedCapture(float CaptureRate)
+{
+	TotalCappedCaptureRate += FMath::Max(CaptureRate, 0.f);
+
+	// Golden ratio sequence, every new phase lands in the largest gap left between the previous ones
+	return (float)FMath::Frac((double)NextCapturePhaseIndex++ * 0.6180339887);
+}
+
+void FActorPortraitCaptureScheduler::RemoveCappedCapture(float CaptureRate)
+{
+	TotalCappedCaptureRate = FMath::Max(TotalCappedCaptureRate - FMath::Max(CaptureRate, 0.f), 0.f);
+}
+
+bool FActorPortraitCaptureScheduler::TryConsumeCappedCapture(float DeltaTime)
+{
+	if (CappedCaptureFrame != GFrameCounter)
+	{
+		CappedCaptureFrame         = GFrameCounter;
+		NumCappedCapturesThisFrame = 0;
+	}
+
+	// Portraits which happen to fall due in the same frame are spread over the following frames
+	const int32 MaxCapturesThisFrame = FMath::Max(FMath::CeilToInt(TotalCappedCaptureRate * DeltaTime), 1);
+	if (NumCappedCapturesThisFrame >= MaxCapturesThisFrame)
+	{
+		INC_DWORD_STAT(STAT_ActorPortraitCaptureScheduler_NumDeferredCappedCaptures);
+		return false;
+	}
+
+	NumCappedCapturesThisFrame++;
+	INC_DWORD_STAT(STAT_ActorPortraitCaptureScheduler_NumCappedCaptures);
+	return true;
+}
+
+void FActorPortraitCaptureScheduler::Shutdown()
+{
+	if (SlatePostTickHandle.IsValid() && FSlateApplication::IsInitialized())
+	{
+		FSlateApplication::Get().OnPostTick().Remove(SlatePostTickHandle);
+	}
+
+	SlatePostTickHandle.Reset();
+	PendingCaptures.Empty();
+}
+
+void FActorPortraitCaptureScheduler::OnSlatePostTick(float DeltaTime)
+{
+	// Portrait worlds ticked by their widgets (in the editor) have ticked by now, rendering any earlier would capture last frame's world state
+	Flush();
+}
@@ -0,0 +1,66 @@
+// Copyright Mans Isaksson. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/WeakObjectPtr.h"
+
+class FActorPortraitScene;
+class USceneCaptureComponent2D;
+
+/**
+ * Collects the portrait captures requested while Slate paints, and renders them together once Slate has ticked and painted every widget, so the
+ * captures see the portrait worlds ticked this frame, whether they're ticked by the engine or by the portrait widgets. Slate has already drawn the
+ * frame by then, so batched captures show up on screen a frame later. The captures of each portrait scene are submitted through a single scene render
+ * builder, so portraits sharing a stage share the render setup of their scene. Captures are rendered right away when batching is disabled
+ * (ActorPortrait.BatchSceneCaptures) or Slate isn't running.
+ *
+ * Also spreads the captures of real-time portraits with a capped capture rate over the frames. Every capped portrait is given a phase within its
+ * capture interval, and the number of capped captures per frame is limited to what the combined capture rate of all capped portraits needs.
+ */
+class FActorPortraitCaptureScheduler
+{
+private:
+	struct FSceneCaptures
+	{
+		TWeakPtr<FActorPortraitScene> Scene;
+		TArray<TWeakObjectPtr<USceneCaptureComponent2D>> CaptureComponents;
+	};
+
+	TArray<FSceneCaptures> PendingCaptures;
+
+	FDelegateHandle SlatePostTickHandle;
+
+	// Sum of the capture rates (in Hz) of all portraits with a capped capture rate
+	float TotalCappedCaptureRate = 0.f;
+
+	uint64 CappedCaptureFrame = 0;
+	int32 NumCappedCapturesThisFrame = 0;
+
+	uint32 NextCapturePhaseIndex = 0;
+
+public:
+	static FActorPortraitCaptureScheduler& Get();
+
+	// True if captures are collected and rendered in one batch per frame
+	static bool IsEnabled();
+
+	// Queues a capture of the scene with CaptureComponent, a component is only captured once per batch no matter how many times it's requested
+	void RequestCapture(const TSharedPtr<FActorPortraitScene>& Scene, USceneCaptureComponent2D* CaptureComponent);
+
+	// Renders all queued captures
+	void Flush();
+
+	// Registers a portrait capturing at most CaptureRate times per second, returns the phase (0 to 1 of the capture interval) to offset its captures by
+	float AddCappedCapture(float CaptureRate);
+
+	void RemoveCappedCapture(float CaptureRate);
+
+	// Returns true if a portrait with a capped capture rate which is due may capture this frame, portraits turned away try again next frame
+	bool TryConsumeCappedCapture(float DeltaTime);
+
+	void Shutdown();
+
+private:
+	void OnSlatePostTick(float DeltaTime);
+};
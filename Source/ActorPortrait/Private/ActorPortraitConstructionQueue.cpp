@@ -0,0 +1,81 @@
+// Copyright Mans Isaksson. All Rights Reserved.
+
+#include "ActorPortraitConstructionQueue.h"
+#include "ActorPortraitModule.h"
+#include "ActorPortraitProjectSettings.h"
+
+DECLARE_CYCLE_STAT(TEXT("Construction Stages"), STAT_ActorPortraitConstructionQueue_Tick, STATGROUP_ActorPortrait);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Queued Constructions"), STAT_ActorPortraitConstructionQueue_Num, STATGROUP_ActorPortrait);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Construction Stages Run"), STAT_ActorPortraitConstructionQueue_StagesRun, STATGROUP_ActorPortrait);
+
+FActorPortraitConstructionQueue& FActorPortraitConstructionQueue::Get()
+{
+	static FActorPortraitConstructionQueue Queue;
+	return Queue;
+}
+
+bool FActorPortraitConstructionQueue::IsEnabled()
+{
+	return UActorPortraitProjectSettings::Get().SceneConstructionTimeBudget > 0.f;
+}
+
+void FActorPortraitConstructionQueue::Enqueue(const TSharedPtr<bool>& Token, TArray<FStage>&& Stages)
+{
+	check(IsInGameThread());
+	check(Token.IsValid());
+
+	if (Stages.Num() == 0)
+	{
+		return;
+	}
+
+	FQueuedConstruction& Construction = Constructions.AddDefaulted_GetRef();
+	Construction.Token  = Token;
+	Construction.Stages = MoveTemp(Stages);
+
+	if (!TickerHandle.IsValid())
+	{
+		TickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FActorPortraitConstructionQueue::Tick));
+	}
+}
+
+bool FActorPortraitConstructionQueue::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_ActorPortraitConstructionQueue_Tick);
+
+	const double Budget    = UActorPortraitProjectSettings::Get().SceneConstructionTimeBudget / 1000.0;
+	const double StartTime = FPlatformTime::Seconds();
+
+	int32 NumStagesRun = 0;
+
+	while (Constructions.Num() > 0 && (NumStagesRun == 0 || FPlatformTime::Seconds() - StartTime < Budget))
+	{
+		FQueuedConstruction& Construction = Constructions[0];
+		if (!Construction.Token.IsValid())
+		{
+			Constructions.RemoveAt(0);
+			continue;
+		}
+
+		// Stages may queue new constructions or destroy other owners, take the stage and finish the bookkeeping before running it
+		FStage Stage = MoveTemp(Construction.Stages[Construction.NextStage++]);
+		if (Construction.NextStage >= Construction.Stages.Num())
+		{
+			Constructions.RemoveAt(0);
+		}
+
+		Stage();
+		NumStagesRun++;
+	}
+
+	SET_DWORD_STAT(STAT_ActorPortraitConstructionQueue_Num, Constructions.Num());
+	SET_DWORD_STAT(STAT_ActorPortraitConstructionQueue_StagesRun, NumStagesRun);
+
+	if (Constructions.Num() == 0)
+	{
+		TickerHandle.Reset();
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,44 @@
+// Copyright Mans Isaksson. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+
+/**
+ * Runs the stages of portrait scene construction spread over several frames. Every frame stages are run in the order they were queued
+ * until the time budget from the project settings has been spent, so opening a screen with many portraits doesn't build them all in one frame.
+ * At least one stage is run every frame, a single stage is never split.
+ */
+class FActorPortraitConstructionQueue
+{
+public:
+	using FStage = TFunction<void()>;
+
+private:
+	struct FQueuedConstruction
+	{
+		// The remaining stages are dropped once the owner of the construction releases its token
+		TWeakPtr<bool> Token;
+		TArray<FStage> Stages;
+		int32 NextStage = 0;
+	};
+
+	TArray<FQueuedConstruction> Constructions;
+
+	FTSTicker::FDelegateHandle TickerHandle;
+
+public:
+	static FActorPortraitConstructionQueue& Get();
+
+	// True if construction should be time-sliced, i.e. the per-frame budget is greater than zero
+	static bool IsEnabled();
+
+	// Queues the stages of a construction, they are run in order starting next frame for as long as Token is valid
+	void Enqueue(const TSharedPtr<bool>& Token, TArray<FStage>&& Stages);
+
+	FORCEINLINE int32 Num() const { return Constructions.Num(); }
+
+private:
+	bool Tick(float DeltaTime);
+};
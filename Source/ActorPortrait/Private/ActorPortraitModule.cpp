@@ -1,6 +1,14 @@
 // Copyright Mans Isaksson. All Rights Reserved.
 
 #include "ActorPortraitModule.h"
+#include "ActorPortraitScenePool.h"
+#include "ActorPortraitTeardownQueue.h"
+#include "ActorPortraitCaptureScheduler.h"
+#include "ActorPortraitRenderTargetPool.h"
+#include "ActorPortraitAtlas.h"
+#include "InstanceWorld.h"
+#include "ActorPortrait.h"
+#include "UObject/UObjectGlobals.h"
 #include "Misc/CoreDelegates.h"
 
 #if WITH_EDITOR
@@ -13,6 +21,7 @@ DEFINE_LOG_CATEGORY(LogActorPortrait);
 void FActorPortraitModule::StartupModule()
 {
 	FCoreDelegates::OnEnginePreExit.AddRaw(this, &FActorPortraitModule::OnApplicationQuit);
+	FCoreUObjectDelegates::PostLoadMapWithWorld.AddRaw(this, &FActorPortraitModule::OnPostLoadMapWithWorld);
 #if WITH_EDITOR
 	FEditorDelegates::PrePIEEnded.AddRaw(this, &FActorPortraitModule::OnPrePIEEnded);
 	FGameDelegates::Get().GetEndPlayMapDelegate().AddRaw(this, &FActorPortraitModule::OnEndPlayMap);
@@ -22,10 +31,18 @@ void FActorPortraitModule::StartupModule()
 void FActorPortraitModule::ShutdownModule()
 {
 	FCoreDelegates::OnEnginePreExit.RemoveAll(this);
+	FCoreUObjectDelegates::PostLoadMapWithWorld.RemoveAll(this);
 #if WITH_EDITOR
 	FEditorDelegates::PrePIEEnded.RemoveAll(this);
 	FGameDelegates::Get().GetEndPlayMapDelegate().RemoveAll(this);
 #endif
+
+	FActorPortraitCaptureScheduler::Get().Shutdown();
+	FActorPortraitScenePool::Get().Shutdown();
+	FActorPortraitTeardownQueue::Get().Flush();
+	FInstanceWorld::FlushUnusedWorldTemplates();
+	FActorPortraitRenderTargetPool::Get().Shutdown();
+	FActorPortraitAtlas::Get().Flush();
 }
 
 bool FActorPortraitModule::IsShuttingDown()
@@ -41,11 +58,20 @@ bool FActorPortraitModule::IsEndingPlay()
 void FActorPortraitModule::OnApplicationQuit()
 {
 	bIsShuttingDown = true;
+	FActorPortraitScenePool::Get().Flush();
+	FActorPortraitTeardownQueue::Get().Flush();
+	FInstanceWorld::FlushUnusedWorldTemplates();
+	FActorPortraitRenderTargetPool::Get().Flush();
+	FActorPortraitAtlas::Get().Flush();
 }
 
 void FActorPortraitModule::OnPrePIEEnded(bool bIsSimulatingInEditor)
 {
 	bIsEndingPlay = true;
+
+	// Pooled scenes and scenes waiting to be torn down may reference the game instance of the play session
+	FActorPortraitScenePool::Get().Flush();
+	FActorPortraitTeardownQueue::Get().Flush();
 }
 
 void FActorPortraitModule::OnEndPlayMap()
@@ -53,4 +79,10 @@ void FActorPortraitModule::OnEndPlayMap()
 	bIsEndingPlay = false;
 }
 
+void FActorPortraitModule::OnPostLoadMapWithWorld(UWorld* LoadedWorld)
+{
+	// The loading screen is still up, the one time we can afford to create portrait worlds
+	UActorPortrait::PrewarmPortraitScenesFromSettings(LoadedWorld);
+}
+
 IMPLEMENT_MODULE(FActorPortraitModule, ActorPortrait)
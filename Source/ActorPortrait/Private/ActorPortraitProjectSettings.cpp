@@ -0,0 +1,32 @@
+// Copyright Mans Isaksson. All Rights Reserved.
+
+#include "ActorPortraitProjectSettings.h"
+
+UActorPortraitProjectSettings::UActorPortraitProjectSettings()
+{
+	bEnableScenePooling     = true;
+	MaxPooledScenes         = 8;
+	MaxPooledScenesPerWorld = 4;
+	PooledSceneIdleTimeout  = 60.f;
+
+	bUseBackgroundWorldTemplates       = true;
+	BackgroundWorldTemplateIdleTimeout = 30.f;
+
+	SharedStageSlotSpacing = 10000.f;
+
+	SceneConstructionTimeBudget = 0.f;
+	SceneTeardownTimeBudget     = 2.f;
+
+	bEnableRenderTargetPooling    = true;
+	RenderTargetPoolBucketSize    = 0;
+	MaxPooledRenderTargets        = 8;
+	PooledRenderTargetIdleTimeout = 30.f;
+
+	AtlasInitialPageSize = 1024;
+	AtlasMaxPageSize     = 4096;
+	AtlasPadding         = 2;
+
+	bPauseHiddenPortraits               = true;
+	HiddenPortraitGraceFrames           = 2;
+	bReleaseHiddenPortraitRenderTargets = false;
+}
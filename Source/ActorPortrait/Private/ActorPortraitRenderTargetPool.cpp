@@ -0,0 +1,277 @@
+// Copyright Mans Isaksson. All Rights Reserved.
+
+#include "ActorPortraitRenderTargetPool.h"
+#include "ActorPortraitModule.h"
+#include "ActorPortraitProjectSettings.h"
+
+#include "UObject/Package.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Render Target Pool Hits"), STAT_ActorPortraitRenderTargetPool_Hits, STATGROUP_ActorPortrait);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Render Target Pool Misses"), STAT_ActorPortraitRenderTargetPool_Misses, STATGROUP_ActorPortrait);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Render Target Pool Hit Rate"), STAT_ActorPortraitRenderTargetPool_HitRate, STATGROUP_ActorPortrait);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Pooled Render Targets"), STAT_ActorPortraitRenderTargetPool_NumPooled, STATGROUP_ActorPortrait);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Active Render Targets"), STAT_ActorPortraitRenderTargetPool_NumActive, STATGROUP_ActorPortrait);
+DECLARE_MEMORY_STAT(TEXT("Pooled Render Target Memory"), STAT_ActorPortraitRenderTargetPool_PooledMemory, STATGROUP_ActorPortrait);
+DECLARE_MEMORY_STAT(TEXT("Active Render Target Memory"), STAT_ActorPortraitRenderTargetPool_ActiveMemory, STATGROUP_ActorPortrait);
+
+namespace ActorPortraitRenderTargetPool
+{
+	static SIZE_T GetRenderTargetMemory(const UTextureRenderTarget2D* RenderTarget)
+	{
+		return RenderTarget ? (SIZE_T)RenderTarget->CalcTextureMemorySizeEnum(TMC_ResidentMips) : 0;
+	}
+}
+
+FActorPortraitRenderTargetPool& FActorPortraitRenderTargetPool::Get()
+{
+	static FActorPortraitRenderTargetPool RenderTargetPool;
+	return RenderTargetPool;
+}
+
+FIntPoint FActorPortraitRenderTargetPool::GetBucketSize(const FIntPoint& Size)
+{
+	const int32 BucketSize = UActorPortraitProjectSettings::Get().RenderTargetPoolBucketSize;
+	if (BucketSize <= 1)
+	{
+		return Size;
+	}
+
+	return FIntPoint(FMath::DivideAndRoundUp(Size.X, BucketSize) * BucketSize, FMath::DivideAndRoundUp(Size.Y, BucketSize) * BucketSize);
+}
+
+bool FActorPortraitRenderTargetPool::IsSuitable(const UTextureRenderTarget2D* RenderTarget, const FIntPoint& Size, ETextureRenderTargetFormat Format)
+{
+	if (!IsValid(RenderTarget) || RenderTarget->RenderTargetFormat != Format)
+	{
+		return false;
+	}
+
+	return FIntPoint(RenderTarget->SizeX, RenderTarget->SizeY) == GetBucketSize(Size);
+}
+
+FBox2f FActorPortraitRenderTargetPool::GetUVRegion(const UTextureRenderTarget2D* RenderTarget, const FIntPoint& Size)
+{
+	if (!RenderTarget || RenderTarget->SizeX <= 0 || RenderTarget->SizeY <= 0)
+	{
+		return FBox2f(FVector2f::ZeroVector, FVector2f::UnitVector);
+	}
+
+	const FVector2f UVMax(
+		FMath::Clamp((float)Size.X / (float)RenderTarget->SizeX, 0.f, 1.f),
+		FMath::Clamp((float)Size.Y / (float)RenderTarget->SizeY, 0.f, 1.f));
+
+	return FBox2f(FVector2f::ZeroVector, UVMax);
+}
+
+UTextureRenderTarget2D* FActorPortraitRenderTargetPool::Acquire(const FIntPoint& Size, ETextureRenderTargetFormat Format)
+{
+	check(IsInGameThread());
+
+	const FIntPoint BucketSize = GetBucketSize(Size);
+
+	UTextureRenderTarget2D* OutRenderTarget = nullptr;
+
+	// Search from the back to pick the most recently used render target
+	for (int32 Index = PooledRenderTargets.Num() - 1; Index >= 0; --Index)
+	{
+		UTextureRenderTarget2D* PooledRenderTarget = PooledRenderTargets[Index].RenderTarget;
+		if (!IsValid(PooledRenderTarget) || PooledRenderTarget->RenderTargetFormat != Format || FIntPoint(PooledRenderTarget->SizeX, PooledRenderTarget->SizeY) != BucketSize)
+		{
+			continue;
+		}
+
+		PooledRenderTargets.RemoveAt(Index, EAllowShrinking::No);
+		PooledRenderTarget->RemoveFromRoot();
+
+		OutRenderTarget = PooledRenderTarget;
+		break;
+	}
+
+	if (OutRenderTarget)
+	{
+		NumHits++;
+	}
+	else
+	{
+		NumMisses++;
+
+		OutRenderTarget = NewObject<UTextureRenderTarget2D>(GetTransientPackage(), NAME_None, RF_Transient);
+		OutRenderTarget->RenderTargetFormat = Format;
+		OutRenderTarget->ClearColor = FLinearColor::Black;
+		OutRenderTarget->InitAutoFormat(BucketSize.X, BucketSize.Y);
+		OutRenderTarget->UpdateResourceImmediate(true);
+
+		UE_LOG(LogActorPortrait, Verbose, TEXT("Created portrait render target %dx%d for %dx%d (%d render targets in pool)"), BucketSize.X, BucketSize.Y, Size.X, Size.Y, PooledRenderTargets.Num());
+	}
+
+	NumActiveRenderTargets++;
+	ActiveRenderTargetMemory += ActorPortraitRenderTargetPool::GetRenderTargetMemory(OutRenderTarget);
+
+	UpdateStats();
+
+	return OutRenderTarget;
+}
+
+void FActorPortraitRenderTargetPool::Release(UTextureRenderTarget2D* RenderTarget)
+{
+	check(IsInGameThread());
+
+	if (!RenderTarget)
+	{
+		return;
+	}
+
+	NumActiveRenderTargets = FMath::Max(NumActiveRenderTargets - 1, 0);
+	ActiveRenderTargetMemory -= FMath::Min(ActiveRenderTargetMemory, ActorPortraitRenderTargetPool::GetRenderTargetMemory(RenderTarget));
+
+	if (!IsValid(RenderTarget) || !CanPoolRenderTargets())
+	{
+		DestroyRenderTarget(RenderTarget);
+		UpdateStats();
+		return;
+	}
+
+	RenderTarget->AddToRoot();
+	PooledRenderTargets.Add(FPooledRenderTarget{ RenderTarget, FPlatformTime::Seconds() });
+
+	TrimPool();
+	StartTicking();
+}
+
+void FActorPortraitRenderTargetPool::Flush()
+{
+	check(IsInGameThread());
+
+	TArray<FPooledRenderTarget> RenderTargetsToDestroy = MoveTemp(PooledRenderTargets);
+	PooledRenderTargets.Reset();
+
+	for (const FPooledRenderTarget& PooledRenderTarget : RenderTargetsToDestroy)
+	{
+		DestroyRenderTarget(PooledRenderTarget.RenderTarget);
+	}
+
+	UpdateStats();
+}
+
+void FActorPortraitRenderTargetPool::Shutdown()
+{
+	if (TickerHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+		TickerHandle.Reset();
+	}
+
+	Flush();
+}
+
+bool FActorPortraitRenderTargetPool::CanPoolRenderTargets() const
+{
+	const UActorPortraitProjectSettings& Settings = UActorPortraitProjectSettings::Get();
+	if (!Settings.bEnableRenderTargetPooling || Settings.MaxPooledRenderTargets <= 0)
+	{
+		return false;
+	}
+
+	return !FActorPortraitModule::IsShuttingDown();
+}
+
+void FActorPortraitRenderTargetPool::TrimPool()
+{
+	const UActorPortraitProjectSettings& Settings = UActorPortraitProjectSettings::Get();
+
+	const double IdleTimeout = Settings.PooledRenderTargetIdleTimeout;
+	const double CurrentTime = FPlatformTime::Seconds();
+	const bool bCanPool      = CanPoolRenderTargets();
+
+	int32 NumDestroyed = 0;
+
+	for (int32 Index = PooledRenderTargets.Num() - 1; Index >= 0; --Index)
+	{
+		const FPooledRenderTarget& PooledRenderTarget = PooledRenderTargets[Index];
+
+		const bool bIsIdle = IdleTimeout > 0.0 && CurrentTime - PooledRenderTarget.ReleaseTime > IdleTimeout;
+		if (bIsIdle || !bCanPool || !IsValid(PooledRenderTarget.RenderTarget))
+		{
+			DestroyRenderTarget(PooledRenderTarget.RenderTarget);
+			PooledRenderTargets.RemoveAt(Index, EAllowShrinking::No);
+			NumDestroyed++;
+		}
+	}
+
+	const int32 NumOverBudget = PooledRenderTargets.Num() - FMath::Max(Settings.MaxPooledRenderTargets, 0);
+	for (int32 Index = 0; Index < NumOverBudget; ++Index)
+	{
+		DestroyRenderTarget(PooledRenderTargets[Index].RenderTarget);
+		NumDestroyed++;
+	}
+
+	if (NumOverBudget > 0)
+	{
+		PooledRenderTargets.RemoveAt(0, NumOverBudget, EAllowShrinking::No);
+	}
+
+	if (NumDestroyed > 0)
+	{
+		UE_LOG(LogActorPortrait, Verbose, TEXT("Destroyed %d pooled portrait render targets (%d render targets left in pool)"), NumDestroyed, PooledRenderTargets.Num());
+	}
+
+	UpdateStats();
+}
+
+void FActorPortraitRenderTargetPool::DestroyRenderTarget(UTextureRenderTarget2D* RenderTarget)
+{
+	if (!RenderTarget)
+	{
+		return;
+	}
+
+	RenderTarget->RemoveFromRoot();
+
+	if (IsValid(RenderTarget))
+	{
+		RenderTarget->ReleaseResource();
+		RenderTarget->MarkAsGarbage();
+	}
+}
+
+void FActorPortraitRenderTargetPool::UpdateStats()
+{
+	SIZE_T PooledMemory = 0;
+	for (const FPooledRenderTarget& PooledRenderTarget : PooledRenderTargets)
+	{
+		PooledMemory += ActorPortraitRenderTargetPool::GetRenderTargetMemory(PooledRenderTarget.RenderTarget);
+	}
+
+	const uint64 NumRequests = NumHits + NumMisses;
+
+	SET_DWORD_STAT(STAT_ActorPortraitRenderTargetPool_Hits, NumHits);
+	SET_DWORD_STAT(STAT_ActorPortraitRenderTargetPool_Misses, NumMisses);
+	SET_FLOAT_STAT(STAT_ActorPortraitRenderTargetPool_HitRate, NumRequests > 0 ? 100.0 * (double)NumHits / (double)NumRequests : 0.0);
+	SET_DWORD_STAT(STAT_ActorPortraitRenderTargetPool_NumPooled, PooledRenderTargets.Num());
+	SET_DWORD_STAT(STAT_ActorPortraitRenderTargetPool_NumActive, NumActiveRenderTargets);
+	SET_MEMORY_STAT(STAT_ActorPortraitRenderTargetPool_PooledMemory, PooledMemory);
+	SET_MEMORY_STAT(STAT_ActorPortraitRenderTargetPool_ActiveMemory, ActiveRenderTargetMemory);
+}
+
+void FActorPortraitRenderTargetPool::StartTicking()
+{
+	if (!TickerHandle.IsValid() && PooledRenderTargets.Num() > 0)
+	{
+		TickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FActorPortraitRenderTargetPool::Tick), 1.f);
+	}
+}
+
+bool FActorPortraitRenderTargetPool::Tick(float DeltaTime)
+{
+	QUICK_SCOPE_CYCLE_COUNTER(STAT_ActorPortraitRenderTargetPool_Tick);
+
+	TrimPool();
+
+	if (PooledRenderTargets.Num() == 0)
+	{
+		TickerHandle.Reset();
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,73 @@
+// Copyright Mans Isaksson. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+#include "Engine/TextureRenderTarget2D.h"
+
+/**
+ * Hands out the render targets portraits capture into. Requested sizes are rounded up to a size bucket when RenderTargetPoolBucketSize is set,
+ * so a portrait only renders into the sub-rect of its render target given by GetUVRegion. Released render targets are kept around
+ * and handed out again to portraits requesting the same bucket and format, instead of creating a new render target.
+ */
+class FActorPortraitRenderTargetPool
+{
+private:
+	struct FPooledRenderTarget
+	{
+		TObjectPtr<UTextureRenderTarget2D> RenderTarget;
+		double ReleaseTime = 0.0;
+	};
+
+	// Sorted by release time, the least recently used render target is first. Pooled render targets are rooted.
+	TArray<FPooledRenderTarget> PooledRenderTargets;
+
+	// Render targets currently used by portraits, kept to report their memory
+	int32 NumActiveRenderTargets = 0;
+	SIZE_T ActiveRenderTargetMemory = 0;
+
+	uint64 NumHits   = 0;
+	uint64 NumMisses = 0;
+
+	FTSTicker::FDelegateHandle TickerHandle;
+
+public:
+	static FActorPortraitRenderTargetPool& Get();
+
+	// Size of the render target handed out for a portrait rendered at Size
+	static FIntPoint GetBucketSize(const FIntPoint& Size);
+
+	// True if RenderTarget is the render target the pool would hand out for Size and Format
+	static bool IsSuitable(const UTextureRenderTarget2D* RenderTarget, const FIntPoint& Size, ETextureRenderTargetFormat Format);
+
+	// The part of RenderTarget a portrait rendered at Size is drawn into, in UV space with the origin at the top left
+	static FBox2f GetUVRegion(const UTextureRenderTarget2D* RenderTarget, const FIntPoint& Size);
+
+	// Returns a pooled render target fitting Size, or creates a new one if none is available. The render target needs to be returned with Release.
+	UTextureRenderTarget2D* Acquire(const FIntPoint& Size, ETextureRenderTargetFormat Format);
+
+	// Returns the render target to the pool, or destroys it if it can't be pooled
+	void Release(UTextureRenderTarget2D* RenderTarget);
+
+	// Destroys all pooled render targets
+	void Flush();
+
+	// Destroys all pooled render targets and stops trimming the pool
+	void Shutdown();
+
+	FORCEINLINE int32 Num() const { return PooledRenderTargets.Num(); }
+
+private:
+	bool CanPoolRenderTargets() const;
+
+	void TrimPool();
+
+	void DestroyRenderTarget(UTextureRenderTarget2D* RenderTarget);
+
+	void UpdateStats();
+
+	void StartTicking();
+
+	bool Tick(float DeltaTime);
+};
@@ -1,59 +1,400 @@
 // Copyright Mans Isaksson. All Rights Reserved.
 
 #include "ActorPortraitScene.h"
+#include "ActorPortraitProjectSettings.h"
+#include "ActorPortraitModule.h"
+#include "ActorPortraitWorldTickDispatcher.h"
+#include "ActorPortraitTickManager.h"
+#include "ActorPortraitAtlas.h"
 
 #include "Components/SkyLightComponent.h"
 #include "Components/DirectionalLightComponent.h"
 #include "Components/ReflectionCaptureComponent.h"
 #include "Components/SceneCaptureComponent2D.h"
 #include "Components/ReflectionCaptureComponent.h"
+#include "Components/ChildActorComponent.h"
+#include "Components/PrimitiveComponent.h"
+#include "GameFramework/MovementComponent.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/WorldSettings.h"
+#include "Particles/ParticleSystemComponent.h"
 
 #include "Engine/World.h"
 #include "Engine/GameInstance.h"
+#include "EngineUtils.h"
 #include "UObject/Package.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/CoreDelegates.h"
 #include "SceneRenderBuilderInterface.h"
 
-FActorPortraitScene::FActorPortraitScene(const TSoftObjectPtr<UWorld> &WorldAsset, UDirectionalLightComponent* DirLightTemplate, USkyLightComponent* SkyLightTemplate, bool bShouldTick, UGameInstance* OwningGameInstance)
-	: FInstanceWorld(FInstanceWorld::ConstructionValues().SetShouldTickWorld(bShouldTick).SetWorldAsset(WorldAsset).SetOwningGameInstance(OwningGameInstance))
+#if WITH_EDITOR
+#include "Editor.h"
+#endif
+
+static TAutoConsoleVariable<bool> CVarBatchPortraitActorRegistration(
+	TEXT("ActorPortrait.BatchPortraitActorRegistration"),
+	true,
+	TEXT("Whether to register the native primitive components of portrait actors in one batch, creating their scene proxies in parallel.\n")
+	TEXT("The components are registered right after the actor is spawned, before its construction script, PostInitializeComponents and BeginPlay run."));
+
+static TAutoConsoleVariable<bool> CVarPluginTickedWorlds(
+	TEXT("ActorPortrait.PluginTickedWorlds"),
+	false,
+	TEXT("Whether new portrait worlds should be created without an engine world context. These worlds are ticked by the ActorPortrait tick manager in a single pass\n")
+	TEXT("ordered by tick priority, instead of the engine iterating and ticking one world context per portrait. Engine code looking up the world context of a portrait world won't find one."));
+
+FActorPortraitScene::FActorPortraitScene(const FInstanceWorld::ConstructionValues& CVS, UDirectionalLightComponent* DirLightTemplate, USkyLightComponent* SkyLightTemplate)
+	: FInstanceWorld(CVS)
 {
 	check(IsInGameThread());
 
+	if (IsLoading())
+	{
+		PendingDirLightTemplate = DirLightTemplate;
+		PendingSkyLightTemplate = SkyLightTemplate;
+		return;
+	}
+
+	InitializeScene(DirLightTemplate, SkyLightTemplate);
+}
+
+void FActorPortraitScene::InitializeScene(UDirectionalLightComponent* DirLightTemplate, USkyLightComponent* SkyLightTemplate)
+{
 	if (GetWorld() == nullptr)
 	{
 		return;
 	}
 
+	// HACK: Since all worlds share the same GameInstance, they will all share the same LatentActionManager and TimerManager.
+	// We therefore use the OnWorldTickStart and OnWorldTickEnd events to override the LatentActionManager and TimerManager during our
+	// portrait scene tick to avoid double-ticking the LatentActionManager and TimerManager.
+	FActorPortraitWorldTickDispatcher::Get().RegisterScene(GetWorld(), this);
+
+	if (IsPluginTicked())
+	{
+		FActorPortraitTickManager::Get().RegisterScene(this);
+	}
+
 	DirectionalLightComponent = NewObject<UDirectionalLightComponent>(GetTransientPackage(), DirLightTemplate ? DirLightTemplate->GetClass() : UDirectionalLightComponent::StaticClass(), NAME_None, RF_Transient, DirLightTemplate);
 	AddComponentToWorld(DirectionalLightComponent);
 
 	SkyLightComponent = NewObject<USkyLightComponent>(GetTransientPackage(), SkyLightTemplate ? SkyLightTemplate->GetClass() : USkyLightComponent::StaticClass(), NAME_None, RF_Transient, SkyLightTemplate);
 	AddComponentToWorld(SkyLightComponent);
 
-	CaptureComponent = NewObject<USceneCaptureComponent2D>(GetTransientPackage(), NAME_None, RF_Transient);
-	CaptureComponent->bCaptureEveryFrame           = false;
-	CaptureComponent->bCaptureOnMovement           = false;
-	CaptureComponent->PostProcessBlendWeight       = 1.f;
-	CaptureComponent->CompositeMode                = ESceneCaptureCompositeMode::SCCM_Overwrite;
-	CaptureComponent->CaptureSource                = ESceneCaptureSource::SCS_FinalColorHDR;
-	CaptureComponent->bAlwaysPersistRenderingState = true;
-	CaptureComponent->bConsiderUnrenderedOpaquePixelAsFullyTranslucent = true;
-	AddComponentToWorld(CaptureComponent);
+	CaptureComponent = CreateCaptureComponent();
 
-	// HACK: Since all worlds share the same GameInstance, they will all share the same LatentActionManager and TimerManager.
-	// We therefore use the OnWorldTickStart and OnWorldTickEnd events to override the LatentActionManager and TimerManager during our
-	// portrait scene tick to avoid double-ticking the LatentActionManager and TimerManager.
-	FWorldDelegates::OnWorldTickStart.AddRaw(this, &FActorPortraitScene::OnWorldTickStart);
-	FWorldDelegates::OnWorldTickEnd.AddRaw(this, &FActorPortraitScene::OnWorldTickEnd);
+	for (TActorIterator<AActor> It(GetWorld()); It; ++It)
+	{
+		BackgroundActors.Add(*It);
+	}
+}
+
+void FActorPortraitScene::DeferComponentRegistration(FActorSpawnParameters& SpawnParameters)
+{
+	if (!CVarBatchPortraitActorRegistration.GetValueOnGameThread())
+	{
+		return;
+	}
+
+	// Called before the actor registers its native components in SpawnActor, components created by the construction script register as usual
+	SpawnParameters.CustomPreSpawnInitalization = [this, CustomPreSpawnInitialization = MoveTemp(SpawnParameters.CustomPreSpawnInitalization)](AActor* Actor)
+	{
+		if (CustomPreSpawnInitialization)
+		{
+			CustomPreSpawnInitialization(Actor);
+		}
+
+		TArray<TWeakObjectPtr<UPrimitiveComponent>> DeferredComponents;
+		Actor->ForEachComponent<UPrimitiveComponent>(false, [Actor, &DeferredComponents](UPrimitiveComponent* Component)
+		{
+			// The root is registered first so the other components can rely on it
+			if (Component != Actor->GetRootComponent() && Component->bAutoRegister)
+			{
+				Component->bAutoRegister = false;
+				DeferredComponents.Add(Component);
+			}
+		});
+
+		if (DeferredComponents.Num() > 0)
+		{
+			DeferredComponentRegistrations.Add(Actor, MoveTemp(DeferredComponents));
+		}
+	};
+}
+
+void FActorPortraitScene::RegisterDeferredComponents(AActor* Actor)
+{
+	TArray<TWeakObjectPtr<UPrimitiveComponent>> DeferredComponents;
+	if (!Actor || !DeferredComponentRegistrations.RemoveAndCopyValue(Actor, DeferredComponents))
+	{
+		return;
+	}
+
+	UWorld* PortraitWorld = GetWorld();
+	if (!IsValid(Actor) || !IsValid(PortraitWorld))
+	{
+		return;
+	}
+
+	QUICK_SCOPE_CYCLE_COUNTER(STAT_ActorPortraitScene_RegisterDeferredComponents);
+
+	FRegisterComponentContext Context(PortraitWorld);
+	for (const TWeakObjectPtr<UPrimitiveComponent>& WeakComponent : DeferredComponents)
+	{
+		UPrimitiveComponent* Component = WeakComponent.Get();
+		if (IsValid(Component) && Component->GetOwner() == Actor)
+		{
+			Component->bAutoRegister = true;
+			if (!Component->IsRegistered())
+			{
+				Component->RegisterComponentWithWorld(PortraitWorld, &Context);
+			}
+		}
+	}
+	Context.Process();
+}
+
+void FActorPortraitScene::OnWorldLoaded()
+{
+	InitializeScene(PendingDirLightTemplate, PendingSkyLightTemplate);
+
+	PendingDirLightTemplate = nullptr;
+	PendingSkyLightTemplate = nullptr;
+
+	OnPortraitSceneLoaded.Broadcast(GetWorld() != nullptr);
 }
 
 FActorPortraitScene::~FActorPortraitScene()
 {
-	FWorldDelegates::OnWorldTickStart.RemoveAll(this);
-	FWorldDelegates::OnWorldTickEnd.RemoveAll(this);
+	FActorPortraitWorldTickDispatcher::Get().UnregisterScene(this);
+	FActorPortraitTickManager::Get().UnregisterScene(this);
+}
+
+void FActorPortraitScene::OnBeginTeardown()
+{
+	// The scene may outlive its world while the teardown is spread over several frames, stop ticking it right away
+	FActorPortraitWorldTickDispatcher::Get().UnregisterScene(this);
+	FActorPortraitTickManager::Get().UnregisterScene(this);
+
+	DeferredComponentRegistrations.Empty();
+}
+
+bool FActorPortraitScene::UpdateStreamingLevels()
+{
+	UWorld* PortraitWorld = GetWorld();
+	if (!IsValid(PortraitWorld) || AreStreamingLevelsReady())
+	{
+		return true;
+	}
+
+	// Portrait worlds are not necessarily ticked, so drive the streaming here instead of relying on the world tick. Unlike FlushLevelStreaming this never blocks.
+	if (LastStreamingUpdateFrame != GFrameCounter)
+	{
+		LastStreamingUpdateFrame = GFrameCounter;
+		PortraitWorld->UpdateLevelStreaming();
+	}
+
+	return AreStreamingLevelsReady();
+}
+
+void FActorPortraitScene::PrepareForPooling()
+{
+	check(IsInGameThread());
+
+	UWorld* PortraitWorld = GetWorld();
+	if (!IsValid(PortraitWorld))
+	{
+		return;
+	}
+
+	for (TActorIterator<AActor> It(PortraitWorld); It; ++It)
+	{
+		AActor* Actor = *It;
+		if (IsValid(Actor) && !BackgroundActors.Contains(Actor))
+		{
+			Actor->Destroy();
+		}
+	}
+
+	RestorePrunedBackgroundPrimitives();
+
+	if (IsValid(CaptureComponent))
+	{
+		CaptureComponent->TextureTarget      = nullptr;
+		CaptureComponent->bCaptureEveryFrame = false;
+		CaptureComponent->ShowOnlyActors.Empty();
+		CaptureComponent->HiddenActors.Empty();
+		CaptureComponent->ClearShowOnlyComponents();
+		CaptureComponent->ClearHiddenComponents();
+	}
+
+	constexpr const UWorld::ELineBatcherType LineBatchersToFlush[] = 
+	{ 
+		UWorld::ELineBatcherType::World,
+		UWorld::ELineBatcherType::WorldPersistent,
+		UWorld::ELineBatcherType::Foreground,
+		UWorld::ELineBatcherType::ForegroundPersistent
+	};
+	PortraitWorld->FlushLineBatchers(LineBatchersToFlush);
+
+	PortraitWorld->SetShouldTick(false);
+	TickAccumulator   = 0.f;
+	RequestedTickRate = 0.f;
+
+	if (AWorldSettings* WorldSettings = PortraitWorld->GetWorldSettings(false, false))
+	{
+		WorldSettings->SetTimeDilation(1.f);
+	}
+
+	DeferredComponentRegistrations.Empty();
+
+	bIsSharedStage = false;
+	UsedStageSlots.Empty();
+	StageSkySphereActor = nullptr;
+}
+
+void FActorPortraitScene::PrepareForReuse(UDirectionalLightComponent* DirLightTemplate, USkyLightComponent* SkyLightTemplate, bool bShouldTick)
+{
+	check(IsInGameThread());
+
+	if (!IsValid(GetWorld()))
+	{
+		return;
+	}
+
+	// Fall back to the class defaults so no light settings leak over from the previous user of this scene
+	ApplyDirectionalLightTemplate(DirLightTemplate ? DirLightTemplate : GetMutableDefault<UDirectionalLightComponent>());
+	ApplySkyLightTemplate(SkyLightTemplate ? SkyLightTemplate : GetMutableDefault<USkyLightComponent>());
+
+	GetWorld()->SetShouldTick(bShouldTick);
+}
+
+void FActorPortraitScene::PruneBackgroundPrimitives(const FSphere& CameraVolume, float PruneDistance)
+{
+	check(IsInGameThread());
+
+	if (!IsValid(GetWorld()) || bIsSharedStage)
+	{
+		return;
+	}
+
+	QUICK_SCOPE_CYCLE_COUNTER(STAT_ActorPortraitScene_PruneBackgroundPrimitives);
+
+	const auto ShouldPrune = [&CameraVolume, PruneDistance](const UPrimitiveComponent* Component)->bool
+	{
+		if (Component->bNeverDistanceCull)
+		{
+			return false;
+		}
+
+		float MaxDrawDistance = Component->CachedMaxDrawDistance;
+		if (PruneDistance > 0.f)
+		{
+			MaxDrawDistance = MaxDrawDistance > 0.f ? FMath::Min(MaxDrawDistance, PruneDistance) : PruneDistance;
+		}
+
+		if (MaxDrawDistance <= 0.f)
+		{
+			return false;
+		}
+
+		// Distance from the closest camera location inside the volume to the closest point of the primitive bounds
+		const double DistanceToCameraVolume = FVector::Dist(Component->Bounds.Origin, CameraVolume.Center) - Component->Bounds.SphereRadius - CameraVolume.W;
+		return DistanceToCameraVolume > MaxDrawDistance;
+	};
+
+	for (const TObjectKey<AActor>& BackgroundActor : BackgroundActors)
+	{
+		AActor* Actor = BackgroundActor.ResolveObjectPtr();
+		if (!IsValid(Actor))
+		{
+			continue;
+		}
+
+		int32 NumPrimitives = 0;
+		int32 NumPrunedPrimitives = 0;
+
+		Actor->ForEachComponent<UPrimitiveComponent>(false, [&](UPrimitiveComponent* Component)
+		{
+			const bool bIsPruned = PrunedBackgroundPrimitives.Contains(Component);
+			if (!bIsPruned && !Component->IsRegistered())
+			{
+				return; // Unregistered by someone else, leave it be
+			}
+
+			NumPrimitives++;
+
+			if (ShouldPrune(Component))
+			{
+				if (!bIsPruned)
+				{
+					Component->UnregisterComponent();
+					PrunedBackgroundPrimitives.Add(Component);
+				}
+
+				NumPrunedPrimitives++;
+			}
+			else if (bIsPruned)
+			{
+				PrunedBackgroundPrimitives.Remove(Component);
+				Component->RegisterComponent();
+			}
+		});
+
+		const bool bPruneActor = NumPrimitives > 0 && NumPrimitives == NumPrunedPrimitives;
+		if (bPruneActor && Actor->IsActorTickEnabled())
+		{
+			Actor->SetActorTickEnabled(false);
+			PrunedBackgroundActors.Add(Actor);
+		}
+		else if (!bPruneActor && PrunedBackgroundActors.Remove(Actor) > 0)
+		{
+			Actor->SetActorTickEnabled(true);
+		}
+	}
+
+	UE_LOG(LogActorPortrait, Verbose, TEXT("Pruned %d background primitives and %d background actors of %s"), PrunedBackgroundPrimitives.Num(), PrunedBackgroundActors.Num(), *GetConstructionValues().WorldAsset.ToString());
+}
+
+void FActorPortraitScene::RestorePrunedBackgroundPrimitives()
+{
+	check(IsInGameThread());
+
+	for (const TObjectKey<UPrimitiveComponent>& PrunedPrimitive : PrunedBackgroundPrimitives)
+	{
+		UPrimitiveComponent* Component = PrunedPrimitive.ResolveObjectPtr();
+		if (IsValid(Component) && !Component->IsRegistered())
+		{
+			Component->RegisterComponent();
+		}
+	}
+
+	for (const TObjectKey<AActor>& PrunedActor : PrunedBackgroundActors)
+	{
+		AActor* Actor = PrunedActor.ResolveObjectPtr();
+		if (IsValid(Actor))
+		{
+			Actor->SetActorTickEnabled(true);
+		}
+	}
+
+	PrunedBackgroundPrimitives.Empty();
+	PrunedBackgroundActors.Empty();
 }
 
 void FActorPortraitScene::ApplyDirectionalLightTemplate(UDirectionalLightComponent* DirLightTemplate)
 {
+	if (IsLoading())
+	{
+		PendingDirLightTemplate = DirLightTemplate;
+		return;
+	}
+
+	if (!GetWorld())
+	{
+		return;
+	}
+
 	if (!IsValid(DirectionalLightComponent)
 		|| (!IsValid(DirLightTemplate) && DirectionalLightComponent->GetClass() != UDirectionalLightComponent::StaticClass())
 		|| (IsValid(DirLightTemplate) && DirectionalLightComponent->GetClass() != DirLightTemplate->GetClass()))
@@ -81,6 +422,17 @@ void FActorPortraitScene::ApplyDirectionalLightTemplate(UDirectionalLightCompone
 
 void FActorPortraitScene::ApplySkyLightTemplate(USkyLightComponent* SkyLightTemplate)
 {
+	if (IsLoading())
+	{
+		PendingSkyLightTemplate = SkyLightTemplate;
+		return;
+	}
+
+	if (!GetWorld())
+	{
+		return;
+	}
+
 	if (!IsValid(SkyLightComponent)
 		|| (!IsValid(SkyLightTemplate) && SkyLightComponent->GetClass() != USkyLightComponent::StaticClass())
 		|| (IsValid(SkyLightTemplate) && SkyLightComponent->GetClass() != SkyLightTemplate->GetClass()))
@@ -114,6 +466,11 @@ void FActorPortraitScene::ApplySkyLightTemplate(USkyLightComponent* SkyLightTemp
 
 void FActorPortraitScene::UpdateSkyCaptureContents()
 {
+	if (!GetWorld())
+	{
+		return;
+	}
+
 	if (IsValid(SkyLightComponent))
 		SkyLightComponent->SetCaptureIsDirty();
 
@@ -123,78 +480,233 @@ void FActorPortraitScene::UpdateSkyCaptureContents()
 
 void FActorPortraitScene::UpdateCaptureComponentCaptureContents()
 {
-	if (IsValid(CaptureComponent))
+	UpdateCaptureContents(CaptureComponent);
+}
+
+void FActorPortraitScene::UpdateCaptureContents(USceneCaptureComponent2D* InCaptureComponent)
+{
+	if (IsValid(InCaptureComponent))
 	{
-		TUniquePtr<ISceneRenderBuilder> SceneRenderBuilder = ISceneRenderBuilder::Create(GetWorld()->Scene);
-		CaptureComponent->UpdateSceneCaptureContents(GetWorld()->Scene, *SceneRenderBuilder);
-		SceneRenderBuilder->Execute();
+		UpdateCaptureContents(MakeArrayView(&InCaptureComponent, 1));
 	}
 }
 
-#if WITH_EDITOR
-void FActorPortraitScene::EditorTick(float DeltaTime)
+void FActorPortraitScene::UpdateCaptureContents(TConstArrayView<USceneCaptureComponent2D*> InCaptureComponents)
 {
-	// We have to tick the world manually in the editor. Ticking is handled by UGameEngine::Tick in non-editor builds
-
-	if (!GetWorld() || !GetWorld()->ShouldTick())
+	UWorld* PortraitWorld = GetWorld();
+	if (!PortraitWorld || !PortraitWorld->Scene || InCaptureComponents.Num() == 0)
 	{
 		return;
 	}
 
-	struct FActorPortraitSceneEditorTicker
+	if (LastCaptureFrame != GFrameCounter)
+	{
+		LastCaptureFrame = GFrameCounter;
+
+		PortraitWorld->SendAllEndOfFrameUpdates();
+		PortraitWorld->Scene->IncrementFrameNumber();
+	}
+
+	TUniquePtr<ISceneRenderBuilder> SceneRenderBuilder = ISceneRenderBuilder::Create(PortraitWorld->Scene);
+	for (USceneCaptureComponent2D* InCaptureComponent : InCaptureComponents)
 	{
-		static TArray<TWeakObjectPtr<UWorld>>& LatentTickQueue()
+		InCaptureComponent->UpdateSceneCaptureContents(PortraitWorld->Scene, *SceneRenderBuilder);
+	}
+	SceneRenderBuilder->Execute();
+
+	// Portraits rendering to the atlas are copied into it once their capture has been rendered
+	FActorPortraitAtlas& Atlas = FActorPortraitAtlas::Get();
+	if (Atlas.HasAllocations())
+	{
+		for (USceneCaptureComponent2D* InCaptureComponent : InCaptureComponents)
 		{
-			static TArray<TWeakObjectPtr<UWorld>> OutQueue;
-			return OutQueue;
+			Atlas.CopyFromSource(InCaptureComponent->TextureTarget);
 		}
+	}
+}
+
+USceneCaptureComponent2D* FActorPortraitScene::CreateCaptureComponent()
+{
+	if (!GetWorld())
+	{
+		return nullptr;
+	}
+
+	USceneCaptureComponent2D* NewCaptureComponent = NewObject<USceneCaptureComponent2D>(GetTransientPackage(), NAME_None, RF_Transient);
+	NewCaptureComponent->bCaptureEveryFrame           = false;
+	NewCaptureComponent->bCaptureOnMovement           = false;
+	NewCaptureComponent->PostProcessBlendWeight       = 1.f;
+	NewCaptureComponent->CompositeMode                = ESceneCaptureCompositeMode::SCCM_Overwrite;
+	NewCaptureComponent->CaptureSource                = ESceneCaptureSource::SCS_FinalColorHDR;
+	NewCaptureComponent->bAlwaysPersistRenderingState = true;
+	NewCaptureComponent->bConsiderUnrenderedOpaquePixelAsFullyTranslucent = true;
+	AddComponentToWorld(NewCaptureComponent);
+
+	return NewCaptureComponent;
+}
+
+void FActorPortraitScene::DestroyCaptureComponent(USceneCaptureComponent2D* InCaptureComponent)
+{
+	if (!IsValid(InCaptureComponent) || InCaptureComponent == CaptureComponent)
+	{
+		return;
+	}
+
+	InCaptureComponent->TextureTarget = nullptr;
+
+	if (GetWorld() && InCaptureComponent->IsRegistered())
+	{
+		RemoveComponentFromWorld(InCaptureComponent);
+	}
+
+	InCaptureComponent->DestroyComponent();
+}
 
-		// Mini version of UGameEngine::Tick world ticking which only ticks parts relevant to the portrait scene
-		static void TickWorld(UWorld* World, float DeltaTime)
+int32 FActorPortraitScene::AcquireStageSlot()
+{
+	int32 Slot = UsedStageSlots.Find(false);
+	if (Slot == INDEX_NONE)
+	{
+		Slot = UsedStageSlots.Add(true);
+	}
+	else
+	{
+		UsedStageSlots[Slot] = true;
+	}
+
+	return Slot;
+}
+
+void FActorPortraitScene::ReleaseStageSlot(int32 Slot)
+{
+	if (UsedStageSlots.IsValidIndex(Slot))
+	{
+		UsedStageSlots[Slot] = false;
+	}
+}
+
+FVector FActorPortraitScene::GetStageSlotLocation(int32 Slot) const
+{
+	// Slot 0 is at the world origin, which is where a portrait would have been placed if it had its own world
+	return FVector(FMath::Max(Slot, 0) * UActorPortraitProjectSettings::Get().SharedStageSlotSpacing, 0.f, 0.f);
+}
+
+uint32 FActorPortraitScene::GetLightTemplatesHash(UDirectionalLightComponent* DirLightTemplate, USkyLightComponent* SkyLightTemplate)
+{
+	// Hashes the exported value of every property applied by ApplyDirectionalLightTemplate and ApplySkyLightTemplate
+	const auto HashTemplate = [](UObject* Template, uint32 Hash)
+	{
+		if (!IsValid(Template))
 		{
-			if (!World->ShouldTick())
-				return;
+			return HashCombine(Hash, 0u);
+		}
+
+		Hash = HashCombine(Hash, GetTypeHash(Template->GetClass()));
 
+		FString ValueString;
+		for (FProperty* Property = Template->GetClass()->PropertyLink; Property; Property = Property->PropertyLinkNext)
+		{
+			if (!Property->HasAnyPropertyFlags(CPF_Edit) || PropertyBlacklist().Contains(Property->GetFName()))
 			{
-				QUICK_SCOPE_CYCLE_COUNTER(STAT_Editor_TickPortrait)
-				World->Tick(ELevelTick::LEVELTICK_All, DeltaTime);
+				continue;
 			}
 
-			if (!IsRunningDedicatedServer() && !IsRunningCommandlet())
+			for (int32 Index = 0; Index < Property->ArrayDim; ++Index)
 			{
-				QUICK_SCOPE_CYCLE_COUNTER(STAT_Editor_CheckPortraitCaptures);
-				// Update sky light first because it's considered direct lighting, sky diffuse will be visible in reflection capture indirect specular
-				USkyLightComponent::UpdateSkyCaptureContents(World);
-				UReflectionCaptureComponent::UpdateReflectionCaptureContents(World);
+				ValueString.Reset();
+				Property->ExportText_InContainer(Index, ValueString, Template, nullptr, nullptr, PPF_None);
+				Hash = HashCombine(Hash, GetTypeHash(ValueString));
 			}
 		}
 
-		static void PostEditorTick(float DeltaTime)
+		return Hash;
+	};
+
+	return HashTemplate(SkyLightTemplate, HashTemplate(DirLightTemplate, 0));
+}
+
+AActor* FActorPortraitScene::GetOrSpawnStageSkySphere(UClass* SkySphereClass)
+{
+	if (IsValid(StageSkySphereActor) && (!SkySphereClass || StageSkySphereActor->GetClass() != SkySphereClass))
+	{
+		StageSkySphereActor->Destroy();
+		StageSkySphereActor = nullptr;
+	}
+
+	if (!IsValid(StageSkySphereActor) && SkySphereClass)
+	{
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.bNoFail = true;
+		StageSkySphereActor = SpawnPortraitActor<AActor>(SkySphereClass, SpawnParams);
+	}
+
+	return StageSkySphereActor;
+}
+
+namespace ActorPortraitSceneTicker
+{
+	struct FLatentWorldTick
+	{
+		TWeakObjectPtr<UWorld> World;
+		float DeltaTime;
+	};
+
+	static TArray<FLatentWorldTick>& LatentTickQueue()
+	{
+		static TArray<FLatentWorldTick> OutQueue;
+		return OutQueue;
+	}
+
+	// Mini version of UGameEngine::Tick world ticking which only ticks parts relevant to the portrait scene
+	static void TickWorld(UWorld* World, float DeltaTime)
+	{
+		{
+			QUICK_SCOPE_CYCLE_COUNTER(STAT_TickPortrait)
+			World->Tick(ELevelTick::LEVELTICK_All, DeltaTime);
+		}
+
+		if (!IsRunningDedicatedServer() && !IsRunningCommandlet())
 		{
-			for (auto & World : LatentTickQueue())
-			{
-				if (!World.IsValid())
-					continue;
+			QUICK_SCOPE_CYCLE_COUNTER(STAT_CheckPortraitCaptures);
+			// Update sky light first because it's considered direct lighting, sky diffuse will be visible in reflection capture indirect specular
+			USkyLightComponent::UpdateSkyCaptureContents(World);
+			UReflectionCaptureComponent::UpdateReflectionCaptureContents(World);
+		}
+	}
 
-				FActorPortraitSceneEditorTicker::TickWorld(World.Get(), DeltaTime);
-			}
-			LatentTickQueue().Empty(LatentTickQueue().Num());
+	static void FlushLatentWorldTicks()
+	{
+		for (const FLatentWorldTick& LatentTick : LatentTickQueue())
+		{
+			if (!LatentTick.World.IsValid())
+				continue;
+
+			TickWorld(LatentTick.World.Get(), LatentTick.DeltaTime);
 		}
+		LatentTickQueue().Empty(LatentTickQueue().Num());
+	}
 
-		static void QueueLatentWorldTick(UWorld* World)
+	static void QueueLatentWorldTick(UWorld* World, float DeltaTime)
+	{
+		static bool bNeedsInit = true;
+		if (bNeedsInit)
 		{
-			static bool bNeedsInit = true;
-			if (bNeedsInit)
+#if WITH_EDITOR
+			if (GEngine)
 			{
-				if (GEngine)
-					GEngine->OnPostEditorTick().AddStatic(&FActorPortraitSceneEditorTicker::PostEditorTick);
+				GEngine->OnPostEditorTick().AddLambda([](float) { FlushLatentWorldTicks(); });
+				bNeedsInit = false;
 			}
-
-			LatentTickQueue().Add(World);
+#else
+			FCoreDelegates::OnEndFrame.AddStatic(&FlushLatentWorldTicks);
+			bNeedsInit = false;
+#endif
 		}
-	};
 
-	static auto IsAnyWorldTicking = []() 
+		LatentTickQueue().Add({ World, DeltaTime });
+	}
+
+	static bool IsAnyWorldTicking()
 	{
 		for (const FWorldContext& WorldContext : GEngine->GetWorldContexts()) 
 		{
@@ -205,20 +717,124 @@ void FActorPortraitScene::EditorTick(float DeltaTime)
 			}
 		}
 		return false;
-	};
+	}
+}
+
+void FActorPortraitScene::TickScene(float DeltaTime, bool bShouldTick, float TickRate, float TimeDilation, int32 InTickPriority)
+{
+	UWorld* PortraitWorld = GetWorld();
+	if (!PortraitWorld)
+	{
+		return;
+	}
+
+	// Portraits sharing a stage all try to tick it, only do it once per frame
+	if (LastTickFrame == GFrameCounter)
+	{
+		return;
+	}
+	LastTickFrame = GFrameCounter;
+
+	// UWorld::Tick scales DeltaSeconds by the effective time dilation, no matter who ticks the world. SetTimeDilation clamps it to the global min and max time dilation.
+	if (AWorldSettings* WorldSettings = PortraitWorld->GetWorldSettings(false, false))
+	{
+		WorldSettings->SetTimeDilation(TimeDilation);
+	}
+
+	if (IsPluginTicked())
+	{
+		// The engine doesn't know about this world, FActorPortraitTickManager ticks it with the settings requested here
+		PortraitWorld->SetShouldTick(bShouldTick);
+		RequestedTickRate = TickRate;
+
+		if (TickPriority != InTickPriority)
+		{
+			TickPriority = InTickPriority;
+			FActorPortraitTickManager::Get().MarkPrioritiesDirty();
+		}
+
+		if (!bShouldTick)
+		{
+			TickAccumulator = 0.f;
+		}
+		return;
+	}
+
+	// We have to tick the world manually in the editor. Ticking is handled by UGameEngine::Tick in non-editor builds, 
+	// unless the tick rate is throttled in which case the engine must not tick the world every frame.
+#if WITH_EDITOR
+	const bool bTickManually = true;
+#else
+	const bool bTickManually = TickRate > 0.f;
+#endif
+
+	PortraitWorld->SetShouldTick(bShouldTick && !bTickManually);
+
+	if (!bShouldTick)
+	{
+		TickAccumulator = 0.f;
+		return;
+	}
+
+	float TickDeltaTime = 0.f;
+	if (!bTickManually || !ConsumeTickTime(DeltaTime, TickRate, TickDeltaTime))
+	{
+		return;
+	}
 		
 	// We can't tick more than one world at a time, in cases where we are ticked through the level tick (such as 3D Widget Components)
 	// we need to delay the tick until the end of the frame.
-	if (!IsAnyWorldTicking())
+	if (!ActorPortraitSceneTicker::IsAnyWorldTicking())
 	{
-		FActorPortraitSceneEditorTicker::TickWorld(GetWorld(), DeltaTime);
+		ActorPortraitSceneTicker::TickWorld(PortraitWorld, TickDeltaTime);
 	}
 	else
 	{
-		FActorPortraitSceneEditorTicker::QueueLatentWorldTick(GetWorld());
+		ActorPortraitSceneTicker::QueueLatentWorldTick(PortraitWorld, TickDeltaTime);
 	}
 }
-#endif
+
+void FActorPortraitScene::TickManaged(float DeltaTime)
+{
+	UWorld* PortraitWorld = GetWorld();
+	if (!PortraitWorld || !PortraitWorld->ShouldTick())
+	{
+		return;
+	}
+
+	// Only tick worlds which a portrait has asked to tick recently, pooled scenes and portraits which are no longer ticked (e.g. hidden) are skipped
+	if (GFrameCounter - LastTickFrame > 1)
+	{
+		TickAccumulator = 0.f;
+		return;
+	}
+
+	float TickDeltaTime = 0.f;
+	if (ConsumeTickTime(DeltaTime, RequestedTickRate, TickDeltaTime))
+	{
+		ActorPortraitSceneTicker::TickWorld(PortraitWorld, TickDeltaTime);
+	}
+}
+
+bool FActorPortraitScene::ConsumeTickTime(float DeltaTime, float TickRate, float& OutTickDeltaTime)
+{
+	if (TickRate <= 0.f)
+	{
+		OutTickDeltaTime = DeltaTime;
+		return true;
+	}
+
+	// Accumulate time between ticks so the world advances by the time that has actually passed
+	TickAccumulator += DeltaTime;
+	if (TickAccumulator < 1.f / TickRate)
+	{
+		return false;
+	}
+
+	OutTickDeltaTime = TickAccumulator;
+	TickAccumulator  = 0.f;
+	return true;
+}
 
 void FActorPortraitScene::AddReferencedObjects(FReferenceCollector& Collector)
 {
@@ -227,6 +843,124 @@ void FActorPortraitScene::AddReferencedObjects(FReferenceCollector& Collector)
 	Collector.AddReferencedObject(DirectionalLightComponent);
 	Collector.AddReferencedObject(SkyLightComponent);
 	Collector.AddReferencedObject(CaptureComponent);
+	Collector.AddReferencedObject(PendingDirLightTemplate);
+	Collector.AddReferencedObject(PendingSkyLightTemplate);
+	Collector.AddReferencedObject(StageSkySphereActor);
+}
+
+FInstanceWorld::ConstructionValues FActorPortraitScene::MakeConstructionValues(const TSoftObjectPtr<UWorld>& WorldAsset, UClass* ActorClass, UClass* SkySphereClass, EPortraitWorldProfile WorldProfile, UGameInstance* OwningGameInstance)
+{
+	FInstanceWorld::ConstructionValues CVS = FInstanceWorld::ConstructionValues()
+		.SetWorldAsset(WorldAsset)
+		.SetOwningGameInstance(OwningGameInstance)
+		.SetProfilingActorClass(ActorClass)
+		.SetUseEngineWorldContext(!CVarPluginTickedWorlds.GetValueOnGameThread());
+
+	ApplyWorldProfile(CVS, WorldProfile, ActorClass, SkySphereClass);
+	return CVS;
+}
+
+void FActorPortraitScene::ApplyWorldProfile(FInstanceWorld::ConstructionValues& CVS, EPortraitWorldProfile WorldProfile, UClass* ActorClass, UClass* SkySphereClass)
+{
+	switch (WorldProfile)
+	{
+	case EPortraitWorldProfile::Full:
+		CVS.SetCreatePhysicsScene(true).SetCreateFXSystem(true).SetCreateAISystem(true).SetCreateNavigation(true);
+		break;
+
+	case EPortraitWorldProfile::Minimal:
+		CVS.SetCreatePhysicsScene(false).SetCreateFXSystem(false).SetCreateAISystem(false).SetCreateNavigation(false);
+		break;
+
+	case EPortraitWorldProfile::Auto:
+	{
+		// NOTE: Actors placed in the background world are not taken into account since the world isn't loaded yet
+		const FActorClassRequirements ActorRequirements     = GetActorClassRequirements(ActorClass);
+		const FActorClassRequirements SkySphereRequirements = GetActorClassRequirements(SkySphereClass);
+
+		CVS.SetCreatePhysicsScene(ActorRequirements.bNeedsPhysics || SkySphereRequirements.bNeedsPhysics)
+			.SetCreateFXSystem(ActorRequirements.bNeedsFX || SkySphereRequirements.bNeedsFX)
+			.SetCreateAISystem(ActorRequirements.bNeedsAI || SkySphereRequirements.bNeedsAI)
+			.SetCreateNavigation(ActorRequirements.bNeedsAI || SkySphereRequirements.bNeedsAI);
+		break;
+	}
+	}
+}
+
+bool FActorPortraitScene::SupportsActorClass(const FInstanceWorld::ConstructionValues& CVS, UClass* ActorClass)
+{
+	const FActorClassRequirements Requirements = GetActorClassRequirements(ActorClass);
+	return (CVS.bCreatePhysicsScene || !Requirements.bNeedsPhysics)
+		&& (CVS.bCreateFXSystem || !Requirements.bNeedsFX)
+		&& ((CVS.bCreateAISystem && CVS.bCreateNavigation) || !Requirements.bNeedsAI);
+}
+
+FActorPortraitScene::FActorClassRequirements FActorPortraitScene::GetActorClassRequirements(UClass* ActorClass)
+{
+	if (!ActorClass || !ActorClass->IsChildOf<AActor>())
+	{
+		return FActorClassRequirements();
+	}
+
+	static TMap<TObjectKey<UClass>, FActorClassRequirements> CachedRequirements;
+
+	// Recompiling a blueprint or reloading code can change the default components of a class without changing the class object
+	static bool bInvalidationRegistered = false;
+	if (!bInvalidationRegistered)
+	{
+		bInvalidationRegistered = true;
+
+		FCoreUObjectDelegates::ReloadCompleteDelegate.AddLambda([](EReloadCompleteReason) { CachedRequirements.Reset(); });
+#if WITH_EDITOR
+		if (GEditor)
+		{
+			GEditor->OnBlueprintCompiled().AddLambda([]() { CachedRequirements.Reset(); });
+		}
+#endif
+	}
+
+	if (const FActorClassRequirements* Cached = CachedRequirements.Find(ActorClass))
+	{
+		return *Cached;
+	}
+
+	FActorClassRequirements Requirements;
+
+	// AI controlled pawns need the AI system, and navigation to move around
+	if (const APawn* PawnCDO = Cast<APawn>(ActorClass->GetDefaultObject()))
+	{
+		Requirements.bNeedsAI = PawnCDO->AutoPossessAI != EAutoPossessAI::Disabled && PawnCDO->AIControllerClass != nullptr;
+	}
+
+	TArray<const UActorComponent*> Components;
+	AActor::GetActorClassDefaultComponents(ActorClass, Components);
+
+	for (const UActorComponent* Component : Components)
+	{
+		if (const UPrimitiveComponent* PrimitiveComponent = Cast<UPrimitiveComponent>(Component))
+		{
+			Requirements.bNeedsPhysics |= PrimitiveComponent->BodyInstance.bSimulatePhysics;
+		}
+
+		// Movement components sweep against the world which requires a physics scene
+		Requirements.bNeedsPhysics |= Component->IsA<UMovementComponent>();
+
+		Requirements.bNeedsFX |= Component->IsA<UFXSystemComponent>();
+
+		if (const UChildActorComponent* ChildActorComponent = Cast<UChildActorComponent>(Component))
+		{
+			if (ChildActorComponent->GetChildActorClass() != ActorClass)
+			{
+				const FActorClassRequirements ChildRequirements = GetActorClassRequirements(ChildActorComponent->GetChildActorClass());
+				Requirements.bNeedsPhysics |= ChildRequirements.bNeedsPhysics;
+				Requirements.bNeedsFX      |= ChildRequirements.bNeedsFX;
+				Requirements.bNeedsAI      |= ChildRequirements.bNeedsAI;
+			}
+		}
+	}
+
+	CachedRequirements.Add(ActorClass, Requirements);
+	return Requirements;
 }
 
 const TSet<FName>& FActorPortraitScene::PropertyBlacklist()
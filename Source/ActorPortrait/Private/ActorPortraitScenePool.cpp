@@ -0,0 +1,275 @@
+// Copyright Mans Isaksson. All Rights Reserved.
+
+#include "ActorPortraitScenePool.h"
+#include "ActorPortraitScene.h"
+#include "ActorPortraitModule.h"
+#include "ActorPortraitProjectSettings.h"
+#include "ActorPortraitTeardownQueue.h"
+
+#include "Algo/Count.h"
+#include "Engine/GameInstance.h"
+
+FActorPortraitScenePool& FActorPortraitScenePool::Get()
+{
+	static FActorPortraitScenePool ScenePool;
+	return ScenePool;
+}
+
+TSharedPtr<FActorPortraitScene> FActorPortraitScenePool::AcquireScene(const FInstanceWorld::ConstructionValues& CVS, UDirectionalLightComponent* DirLightTemplate, USkyLightComponent* SkyLightTemplate)
+{
+	check(IsInGameThread());
+
+	// Search from the back to pick the most recently used scene, it's the most likely to still have its resources resident
+	for (int32 Index = PooledScenes.Num() - 1; Index >= 0; --Index)
+	{
+		const TSharedPtr<FActorPortraitScene>& PooledScene = PooledScenes[Index].Scene;
+		if (!IsValid(PooledScene->GetWorld()) || !(PooledScene->GetConstructionValues() == CVS))
+		{
+			continue;
+		}
+
+		TSharedPtr<FActorPortraitScene> OutScene = PooledScene;
+		PooledScenes.RemoveAt(Index, EAllowShrinking::No);
+
+		OutScene->PrepareForReuse(DirLightTemplate, SkyLightTemplate, CVS.bShouldTickWorld);
+		OutScene->SetProfilingActorClass(CVS.ProfilingActorClass.Get());
+
+		UE_LOG(LogActorPortrait, Verbose, TEXT("Re-using pooled portrait scene for %s (%d scenes left in pool)"), *CVS.WorldAsset.ToString(), PooledScenes.Num());
+		return OutScene;
+	}
+
+	return MakeShared<FActorPortraitScene>(CVS, DirLightTemplate, SkyLightTemplate);
+}
+
+TSharedPtr<FActorPortraitScene> FActorPortraitScenePool::AcquireSharedStage(const FInstanceWorld::ConstructionValues& CVS, FName StageName, UDirectionalLightComponent* DirLightTemplate, USkyLightComponent* SkyLightTemplate)
+{
+	check(IsInGameThread());
+
+	const FSharedStageKey StageKey{ CVS, StageName, FActorPortraitScene::GetLightTemplatesHash(DirLightTemplate, SkyLightTemplate) };
+
+	if (TSharedPtr<FActorPortraitScene> SharedStage = SharedStages.FindRef(StageKey).Pin())
+	{
+		if (SharedStage->IsLoading() || IsValid(SharedStage->GetWorld()))
+		{
+			return SharedStage;
+		}
+	}
+
+	TSharedPtr<FActorPortraitScene> NewStage = AcquireScene(CVS, DirLightTemplate, SkyLightTemplate);
+	NewStage->SetIsSharedStage(true);
+	SharedStages.Add(StageKey, NewStage);
+
+	UE_LOG(LogActorPortrait, Verbose, TEXT("Created shared portrait stage %s for %s"), *StageName.ToString(), *CVS.WorldAsset.ToString());
+	return NewStage;
+}
+
+void FActorPortraitScenePool::ReleaseScene(TSharedPtr<FActorPortraitScene>&& Scene)
+{
+	check(IsInGameThread());
+
+	TSharedPtr<FActorPortraitScene> ReleasedScene = MoveTemp(Scene);
+
+	if (ReleasedScene.IsValid() && ReleasedScene->IsSharedStage())
+	{
+		if (ReleasedScene.GetSharedReferenceCount() > 1)
+		{
+			return; // Still used by other portraits
+		}
+
+		for (auto It = SharedStages.CreateIterator(); It; ++It)
+		{
+			if (!It.Value().IsValid() || It.Value().HasSameObject(ReleasedScene.Get()))
+			{
+				It.RemoveCurrent();
+			}
+		}
+	}
+
+	if (!ReleasedScene.IsValid() || !CanPoolScene(*ReleasedScene))
+	{
+		FActorPortraitTeardownQueue::Get().Enqueue(MoveTemp(ReleasedScene));
+		return;
+	}
+
+	const UActorPortraitProjectSettings& Settings = UActorPortraitProjectSettings::Get();
+
+	const FInstanceWorld::ConstructionValues& CVS = ReleasedScene->GetConstructionValues();
+	const int32 NumScenesForWorld = Algo::CountIf(PooledScenes, [&CVS](const FPooledScene& PooledScene)
+	{
+		return PooledScene.Scene->GetConstructionValues().WorldAsset == CVS.WorldAsset;
+	});
+
+	if (NumScenesForWorld >= Settings.MaxPooledScenesPerWorld)
+	{
+		FActorPortraitTeardownQueue::Get().Enqueue(MoveTemp(ReleasedScene));
+		return;
+	}
+
+	ReleasedScene->PrepareForPooling();
+	PooledScenes.Add(FPooledScene{ MoveTemp(ReleasedScene), FPlatformTime::Seconds() });
+
+	TrimPool();
+	StartTicking();
+}
+
+int32 FActorPortraitScenePool::PrewarmScenes(const FInstanceWorld::ConstructionValues& CVS, int32 NumScenes)
+{
+	check(IsInGameThread());
+
+	const UActorPortraitProjectSettings& Settings = UActorPortraitProjectSettings::Get();
+
+	const int32 NumPooledScenes = Algo::CountIf(PooledScenes, [&CVS](const FPooledScene& PooledScene)
+	{
+		return PooledScene.Scene->GetConstructionValues() == CVS;
+	});
+
+	const int32 NumScenesToCreate = FMath::Min(NumScenes, Settings.MaxPooledScenesPerWorld) - NumPooledScenes;
+	if (NumScenesToCreate <= 0)
+	{
+		return 0;
+	}
+
+	if (NumScenes > Settings.MaxPooledScenesPerWorld)
+	{
+		UE_LOG(LogActorPortrait, Warning, TEXT("Can only prewarm %d of the %d requested portrait scenes for %s, limited by MaxPooledScenesPerWorld"), Settings.MaxPooledScenesPerWorld, NumScenes, *CVS.WorldAsset.ToString());
+	}
+
+	FInstanceWorld::ConstructionValues PrewarmCVS = CVS;
+	PrewarmCVS.SetLoadAsync(false).SetShouldTickWorld(false);
+
+	int32 NumCreatedScenes = 0;
+	for (int32 Index = 0; Index < NumScenesToCreate; ++Index)
+	{
+		TSharedPtr<FActorPortraitScene> NewScene = MakeShared<FActorPortraitScene>(PrewarmCVS, nullptr, nullptr);
+		if (!CanPoolScene(*NewScene))
+		{
+			break; // Scene is destroyed when NewScene goes out of scope
+		}
+
+		NewScene->PrepareForPooling();
+		PooledScenes.Add(FPooledScene{ MoveTemp(NewScene), FPlatformTime::Seconds(), true });
+		NumCreatedScenes++;
+	}
+
+	UE_LOG(LogActorPortrait, Verbose, TEXT("Prewarmed %d portrait scenes for %s (%d scenes in pool)"), NumCreatedScenes, *CVS.WorldAsset.ToString(), PooledScenes.Num());
+
+	TrimPool();
+	StartTicking();
+
+	return NumCreatedScenes;
+}
+
+void FActorPortraitScenePool::Flush()
+{
+	check(IsInGameThread());
+
+	// Move the scenes out before destroying them, destroying a world may end up releasing other portrait scenes
+	TArray<FPooledScene> ScenesToDestroy = MoveTemp(PooledScenes);
+	PooledScenes.Reset();
+	ScenesToDestroy.Empty();
+}
+
+void FActorPortraitScenePool::Shutdown()
+{
+	if (TickerHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+		TickerHandle.Reset();
+	}
+
+	Flush();
+}
+
+bool FActorPortraitScenePool::CanPoolScene(const FActorPortraitScene& Scene) const
+{
+	const UActorPortraitProjectSettings& Settings = UActorPortraitProjectSettings::Get();
+	if (!Settings.bEnableScenePooling || Settings.MaxPooledScenes <= 0 || Settings.MaxPooledScenesPerWorld <= 0)
+	{
+		return false;
+	}
+
+	if (FActorPortraitModule::IsShuttingDown() || FActorPortraitModule::IsEndingPlay())
+	{
+		return false;
+	}
+
+	if (!IsValid(Scene.GetWorld()))
+	{
+		return false;
+	}
+
+	// Scenes created for a game instance are only valid as long as that game instance is
+	UGameInstance* OwningGameInstance = Scene.GetConstructionValues().OwningGameInstance;
+	if (OwningGameInstance != nullptr && !IsValid(OwningGameInstance))
+	{
+		return false;
+	}
+
+	return true;
+}
+
+void FActorPortraitScenePool::TrimPool()
+{
+	const UActorPortraitProjectSettings& Settings = UActorPortraitProjectSettings::Get();
+
+	const double IdleTimeout = Settings.PooledSceneIdleTimeout;
+	const double CurrentTime = FPlatformTime::Seconds();
+
+	TArray<TSharedPtr<FActorPortraitScene>> ScenesToDestroy;
+
+	for (int32 Index = PooledScenes.Num() - 1; Index >= 0; --Index)
+	{
+		const FPooledScene& PooledScene = PooledScenes[Index];
+
+		const bool bIsIdle = IdleTimeout > 0.0 && !PooledScene.bPrewarmed && CurrentTime - PooledScene.ReleaseTime > IdleTimeout;
+		if (bIsIdle || !CanPoolScene(*PooledScene.Scene))
+		{
+			ScenesToDestroy.Add(PooledScene.Scene);
+			PooledScenes.RemoveAt(Index, EAllowShrinking::No);
+		}
+	}
+
+	const int32 NumScenesOverBudget = PooledScenes.Num() - FMath::Max(Settings.MaxPooledScenes, 0);
+	for (int32 Index = 0; Index < NumScenesOverBudget; ++Index)
+	{
+		ScenesToDestroy.Add(PooledScenes[Index].Scene);
+	}
+
+	if (NumScenesOverBudget > 0)
+	{
+		PooledScenes.RemoveAt(0, NumScenesOverBudget, EAllowShrinking::No);
+	}
+
+	if (ScenesToDestroy.Num() > 0)
+	{
+		UE_LOG(LogActorPortrait, Verbose, TEXT("Destroying %d pooled portrait scenes (%d scenes left in pool)"), ScenesToDestroy.Num(), PooledScenes.Num());
+	}
+
+	for (TSharedPtr<FActorPortraitScene>& SceneToDestroy : ScenesToDestroy)
+	{
+		FActorPortraitTeardownQueue::Get().Enqueue(MoveTemp(SceneToDestroy));
+	}
+}
+
+void FActorPortraitScenePool::StartTicking()
+{
+	if (!TickerHandle.IsValid() && PooledScenes.Num() > 0)
+	{
+		TickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FActorPortraitScenePool::Tick), 1.f);
+	}
+}
+
+bool FActorPortraitScenePool::Tick(float DeltaTime)
+{
+	QUICK_SCOPE_CYCLE_COUNTER(STAT_ActorPortraitScenePool_Tick);
+
+	TrimPool();
+
+	if (PooledScenes.Num() == 0)
+	{
+		TickerHandle.Reset();
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,82 @@
+// Copyright Mans Isaksson. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+#include "InstanceWorld.h"
+
+class FActorPortraitScene;
+class UDirectionalLightComponent;
+class USkyLightComponent;
+
+/**
+ * Keeps portrait scenes alive after their widget has been destroyed so that new portraits using the same background world
+ * can re-use the already loaded and initialized world instead of creating a new one.
+ */
+class FActorPortraitScenePool
+{
+private:
+	struct FPooledScene
+	{
+		TSharedPtr<FActorPortraitScene> Scene;
+		double ReleaseTime = 0.0;
+
+		// Prewarmed scenes are kept until they are first used, regardless of the idle timeout
+		bool bPrewarmed = false;
+	};
+
+	struct FSharedStageKey
+	{
+		FInstanceWorld::ConstructionValues CVS;
+		FName StageName;
+
+		// The lights are stage wide, portraits only share a stage if their light templates are equal
+		uint32 LightTemplatesHash = 0;
+
+		friend bool operator==(const FSharedStageKey& A, const FSharedStageKey& B) { return A.StageName == B.StageName && A.LightTemplatesHash == B.LightTemplatesHash && A.CVS == B.CVS; }
+		friend uint32 GetTypeHash(const FSharedStageKey& Key) { return HashCombine(HashCombine(GetTypeHash(Key.StageName), Key.LightTemplatesHash), GetTypeHash(Key.CVS)); }
+	};
+
+	// Sorted by release time, the least recently used scene is first
+	TArray<FPooledScene> PooledScenes;
+
+	// Scenes currently shared by several portraits, owned by the portraits using them
+	TMap<FSharedStageKey, TWeakPtr<FActorPortraitScene>> SharedStages;
+
+	FTSTicker::FDelegateHandle TickerHandle;
+
+public:
+	static FActorPortraitScenePool& Get();
+
+	// Returns a pooled scene matching the construction values, or creates a new scene if none is available
+	TSharedPtr<FActorPortraitScene> AcquireScene(const FInstanceWorld::ConstructionValues& CVS, UDirectionalLightComponent* DirLightTemplate, USkyLightComponent* SkyLightTemplate);
+
+	// Returns the shared stage with the given name for the construction values and light templates, acquiring a new scene for the stage if there is none.
+	// Portraits with the same stage name but different light templates are placed on separate stages.
+	TSharedPtr<FActorPortraitScene> AcquireSharedStage(const FInstanceWorld::ConstructionValues& CVS, FName StageName, UDirectionalLightComponent* DirLightTemplate, USkyLightComponent* SkyLightTemplate);
+
+	// Returns the scene to the pool, or destroys it if it cannot be pooled. Shared stages are only returned once their last portrait releases them.
+	void ReleaseScene(TSharedPtr<FActorPortraitScene>&& Scene);
+
+	// Creates scenes for the construction values ahead of time and places them in the pool, until there are NumScenes pooled scenes for the construction values.
+	// The world is created synchronously, so this is best done while a loading screen is shown. Returns the number of created scenes.
+	int32 PrewarmScenes(const FInstanceWorld::ConstructionValues& CVS, int32 NumScenes);
+
+	// Destroys all pooled scenes
+	void Flush();
+
+	// Destroys all pooled scenes and stops trimming the pool
+	void Shutdown();
+
+	FORCEINLINE int32 Num() const { return PooledScenes.Num(); }
+
+private:
+	bool CanPoolScene(const FActorPortraitScene& Scene) const;
+
+	void TrimPool();
+
+	void StartTicking();
+
+	bool Tick(float DeltaTime);
+};
@@ -0,0 +1,121 @@
+// Copyright Mans Isaksson. All Rights Reserved.
+
+#include "ActorPortraitStats.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/Paths.h"
+
+CSV_DEFINE_CATEGORY(ActorPortrait, false);
+
+DEFINE_STAT(STAT_ActorPortraitPhase_PackageLoad);
+DEFINE_STAT(STAT_ActorPortraitPhase_SoftPathFixup);
+DEFINE_STAT(STAT_ActorPortraitPhase_InitWorld);
+DEFINE_STAT(STAT_ActorPortraitPhase_InitializeActorsForPlay);
+DEFINE_STAT(STAT_ActorPortraitPhase_BeginPlay);
+DEFINE_STAT(STAT_ActorPortraitPhase_SpawnPortraitActor);
+DEFINE_STAT(STAT_ActorPortraitPhase_SkyRecapture);
+DEFINE_STAT(STAT_ActorPortraitPhase_FirstCapture);
+DEFINE_STAT(STAT_ActorPortraitPhase_CleanupWorld);
+
+static TAutoConsoleVariable<FString> CVarPhaseTimingsCsv(
+	TEXT("ActorPortrait.PhaseTimingsCsv"),
+	TEXT(""),
+	TEXT("When set, the duration of every portrait creation and teardown phase is appended to this file in the profiling directory, ")
+	TEXT("tagged with the background world and actor class. The CSV profiler category ActorPortrait records the same phases without tags."));
+
+namespace ActorPortraitStats
+{
+	struct FPhaseTimingsWriter
+	{
+		FString FileName;
+		TUniquePtr<FArchive> Writer;
+
+		void Write(const TCHAR* PhaseName, const FActorPortraitPhaseContext& Context, double Seconds)
+		{
+			const FString& RequestedFileName = CVarPhaseTimingsCsv.GetValueOnGameThread();
+			if (RequestedFileName.IsEmpty())
+			{
+				Writer.Reset();
+				FileName.Reset();
+				return;
+			}
+
+			if (RequestedFileName != FileName)
+			{
+				FileName = RequestedFileName;
+
+				const FString FilePath = FPaths::Combine(FPaths::ProfilingDir(), FileName);
+				const bool bWriteHeader = !IFileManager::Get().FileExists(*FilePath);
+				Writer.Reset(IFileManager::Get().CreateFileWriter(*FilePath, FILEWRITE_Append | FILEWRITE_AllowRead));
+
+				if (Writer && bWriteHeader)
+				{
+					WriteLine(TEXT("Frame,Phase,World,ActorClass,Milliseconds"));
+				}
+			}
+
+			if (Writer)
+			{
+				WriteLine(FString::Printf(TEXT("%llu,%s,%s,%s,%.3f"),
+					GFrameCounter,
+					PhaseName,
+					*Context.WorldAsset.GetAssetName(),
+					Context.ActorClass ? *Context.ActorClass->GetName() : TEXT(""),
+					Seconds * 1000.0));
+				Writer->Flush();
+			}
+		}
+
+		void WriteLine(const FString& Line)
+		{
+			const FTCHARToUTF8 Utf8Line(*(Line + LINE_TERMINATOR));
+			Writer->Serialize(const_cast<ANSICHAR*>(Utf8Line.Get()), Utf8Line.Length());
+		}
+
+		static FPhaseTimingsWriter& Get()
+		{
+			static FPhaseTimingsWriter Instance;
+			return Instance;
+		}
+	};
+}
+
+FString FActorPortraitPhaseContext::ToString() const
+{
+	return FString::Printf(TEXT("%s, %s"),
+		WorldAsset.IsValid() ? *WorldAsset.GetAssetName() : TEXT("Empty World"),
+		ActorClass ? *ActorClass->GetName() : TEXT("No Actor"));
+}
+
+FActorPortraitPhaseScope::FActorPortraitPhaseScope(const TCHAR* InPhaseName, const FActorPortraitPhaseContext& InContext)
+	: PhaseName(InPhaseName)
+	, Context(InContext)
+	, StartTime(FPlatformTime::Seconds())
+{
+}
+
+FActorPortraitPhaseScope::~FActorPortraitPhaseScope()
+{
+	ReportPhase(PhaseName, Context, FPlatformTime::Seconds() - StartTime);
+}
+
+void FActorPortraitPhaseScope::ReportPhase(const TCHAR* PhaseName, const FActorPortraitPhaseContext& Context, double Seconds)
+{
+	UE_LOG(LogActorPortrait, VeryVerbose, TEXT("%s took %.3f ms (%s)"), PhaseName, Seconds * 1000.0, *Context.ToString());
+
+	if (IsInGameThread())
+	{
+		ActorPortraitStats::FPhaseTimingsWriter::Get().Write(PhaseName, Context, Seconds);
+	}
+}
+
+FString FActorPortraitPhaseScope::GetTraceEventName(const TCHAR* PhaseName, const FActorPortraitPhaseContext& Context)
+{
+#if CPUPROFILERTRACE_ENABLED
+	if (UE_TRACE_CHANNELEXPR_IS_ENABLED(CpuChannel))
+	{
+		return FString::Printf(TEXT("ActorPortrait %s (%s)"), PhaseName, *Context.ToString());
+	}
+#endif
+	return PhaseName;
+}
@@ -0,0 +1,66 @@
+// Copyright Mans Isaksson. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+#include "UObject/SoftObjectPath.h"
+
+#include "ActorPortraitModule.h"
+
+CSV_DECLARE_CATEGORY_EXTERN(ActorPortrait);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Package Load"),              STAT_ActorPortraitPhase_PackageLoad,             STATGROUP_ActorPortrait, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Soft Path Fixup"),           STAT_ActorPortraitPhase_SoftPathFixup,           STATGROUP_ActorPortrait, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Init World"),                STAT_ActorPortraitPhase_InitWorld,               STATGROUP_ActorPortrait, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Initialize Actors For Play"), STAT_ActorPortraitPhase_InitializeActorsForPlay, STATGROUP_ActorPortrait, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Begin Play"),                STAT_ActorPortraitPhase_BeginPlay,               STATGROUP_ActorPortrait, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Spawn Portrait Actor"),      STAT_ActorPortraitPhase_SpawnPortraitActor,      STATGROUP_ActorPortrait, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Sky Recapture"),             STAT_ActorPortraitPhase_SkyRecapture,            STATGROUP_ActorPortrait, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("First Capture"),             STAT_ActorPortraitPhase_FirstCapture,            STATGROUP_ActorPortrait, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Cleanup World"),             STAT_ActorPortraitPhase_CleanupWorld,            STATGROUP_ActorPortrait, );
+
+/** Identifies the content a portrait phase is working on, used to tag trace events and timing dumps */
+struct FActorPortraitPhaseContext
+{
+	FActorPortraitPhaseContext(const FSoftObjectPath& InWorldAsset, const UClass* InActorClass = nullptr)
+		: WorldAsset(InWorldAsset)
+		, ActorClass(InActorClass)
+	{
+	}
+
+	FSoftObjectPath WorldAsset;
+	const UClass* ActorClass;
+
+	FString ToString() const;
+};
+
+/**
+ * Times a single portrait phase. The scope is reported as a named Insights event tagged with the background world and actor class,
+ * and is appended to the timing dump when ActorPortrait.PhaseTimingsCsv is set.
+ */
+class FActorPortraitPhaseScope
+{
+public:
+	FActorPortraitPhaseScope(const TCHAR* InPhaseName, const FActorPortraitPhaseContext& InContext);
+	~FActorPortraitPhaseScope();
+
+	/** Reports a phase which could not be measured with a scope, such as an async package load */
+	static void ReportPhase(const TCHAR* PhaseName, const FActorPortraitPhaseContext& Context, double Seconds);
+
+	/** Name of the trace event for the phase, only includes the context when the cpu trace channel is enabled */
+	static FString GetTraceEventName(const TCHAR* PhaseName, const FActorPortraitPhaseContext& Context);
+
+private:
+	const TCHAR* PhaseName;
+	FActorPortraitPhaseContext Context;
+	double StartTime;
+};
+
+#define ACTOR_PORTRAIT_PHASE_SCOPE(Phase, Context) \
+	SCOPE_CYCLE_COUNTER(STAT_ActorPortraitPhase_##Phase); \
+	CSV_SCOPED_TIMING_STAT(ActorPortrait, Phase); \
+	TRACE_CPUPROFILER_EVENT_SCOPE_TEXT(*FActorPortraitPhaseScope::GetTraceEventName(TEXT(#Phase), Context)); \
+	FActorPortraitPhaseScope ActorPortraitPhaseScope_##Phase(TEXT(#Phase), Context)
@@ -0,0 +1,99 @@
+// Copyright Mans Isaksson. All Rights Reserved.
+
+#include "ActorPortraitTeardownQueue.h"
+#include "ActorPortraitModule.h"
+#include "ActorPortraitProjectSettings.h"
+#include "InstanceWorld.h"
+
+DECLARE_CYCLE_STAT(TEXT("Teardown Stages"), STAT_ActorPortraitTeardownQueue_Tick, STATGROUP_ActorPortrait);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Worlds Pending Teardown"), STAT_ActorPortraitTeardownQueue_Num, STATGROUP_ActorPortrait);
+
+FActorPortraitTeardownQueue& FActorPortraitTeardownQueue::Get()
+{
+	static FActorPortraitTeardownQueue Queue;
+	return Queue;
+}
+
+bool FActorPortraitTeardownQueue::IsEnabled()
+{
+	// World destruction has to be finished before the play session or the engine is torn down
+	if (FActorPortraitModule::IsShuttingDown() || FActorPortraitModule::IsEndingPlay())
+	{
+		return false;
+	}
+
+	return UActorPortraitProjectSettings::Get().SceneTeardownTimeBudget > 0.f;
+}
+
+void FActorPortraitTeardownQueue::Enqueue(TSharedPtr<FInstanceWorld>&& InstanceWorld)
+{
+	check(IsInGameThread());
+
+	TSharedPtr<FInstanceWorld> QueuedWorld = MoveTemp(InstanceWorld);
+
+	// Worlds which are still being loaded or constructed are cheap to destroy, and have nothing to tear down yet
+	if (!QueuedWorld.IsValid() || !IsEnabled() || QueuedWorld->IsLoading() || !QueuedWorld->GetWorld())
+	{
+		return; // Destroyed when QueuedWorld goes out of scope
+	}
+
+	InstanceWorlds.Add(MoveTemp(QueuedWorld));
+	SET_DWORD_STAT(STAT_ActorPortraitTeardownQueue_Num, InstanceWorlds.Num());
+
+	if (!TickerHandle.IsValid())
+	{
+		TickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FActorPortraitTeardownQueue::Tick));
+	}
+}
+
+void FActorPortraitTeardownQueue::Flush()
+{
+	check(IsInGameThread());
+
+	if (TickerHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+		TickerHandle.Reset();
+	}
+
+	// Move the worlds out before destroying them, destroying a world may end up releasing other portrait scenes
+	TArray<TSharedPtr<FInstanceWorld>> WorldsToDestroy = MoveTemp(InstanceWorlds);
+	InstanceWorlds.Reset();
+	WorldsToDestroy.Empty();
+
+	SET_DWORD_STAT(STAT_ActorPortraitTeardownQueue_Num, 0);
+}
+
+bool FActorPortraitTeardownQueue::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_ActorPortraitTeardownQueue_Tick);
+
+	const double Budget    = UActorPortraitProjectSettings::Get().SceneTeardownTimeBudget / 1000.0;
+	const double StartTime = FPlatformTime::Seconds();
+
+	int32 NumStagesRun = 0;
+
+	while (InstanceWorlds.Num() > 0 && (NumStagesRun == 0 || FPlatformTime::Seconds() - StartTime < Budget))
+	{
+		// A teardown stage may release other portrait scenes which are then added to the queue
+		TSharedPtr<FInstanceWorld> InstanceWorld = InstanceWorlds[0];
+
+		const bool bIsTornDown = InstanceWorld->TeardownNextStage();
+		NumStagesRun++;
+
+		if (bIsTornDown)
+		{
+			InstanceWorlds.RemoveAt(0);
+		}
+	}
+
+	SET_DWORD_STAT(STAT_ActorPortraitTeardownQueue_Num, InstanceWorlds.Num());
+
+	if (InstanceWorlds.Num() == 0)
+	{
+		TickerHandle.Reset();
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,38 @@
+// Copyright Mans Isaksson. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+
+class FInstanceWorld;
+
+/**
+ * Tears down released portrait worlds over the following frames instead of in the frame their widget was destroyed. Every frame teardown
+ * stages are run until the time budget from the project settings has been spent, at least one stage is run every frame. The queue is flushed
+ * synchronously when play in editor ends and when the engine shuts down.
+ */
+class FActorPortraitTeardownQueue
+{
+private:
+	TArray<TSharedPtr<FInstanceWorld>> InstanceWorlds;
+
+	FTSTicker::FDelegateHandle TickerHandle;
+
+public:
+	static FActorPortraitTeardownQueue& Get();
+
+	// True if teardown should be deferred, i.e. the per-frame budget is greater than zero and neither play nor the engine is ending
+	static bool IsEnabled();
+
+	// Takes over the instance world and tears it down over the following frames, or right away if deferred teardown is disabled
+	void Enqueue(TSharedPtr<FInstanceWorld>&& InstanceWorld);
+
+	// Finishes tearing down all queued instance worlds
+	void Flush();
+
+	FORCEINLINE int32 Num() const { return InstanceWorlds.Num(); }
+
+private:
+	bool Tick(float DeltaTime);
+};
@@ -0,0 +1,91 @@
+// Copyright Mans Isaksson. All Rights Reserved.
+
+#include "ActorPortraitTickManager.h"
+#include "ActorPortraitScene.h"
+#include "ActorPortraitModule.h"
+
+#include "Algo/StableSort.h"
+
+DECLARE_CYCLE_STAT(TEXT("Tick Plugin Ticked Worlds"), STAT_ActorPortraitTickManager_Tick, STATGROUP_ActorPortrait);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Plugin Ticked Worlds"), STAT_ActorPortraitTickManager_NumScenes, STATGROUP_ActorPortrait);
+
+FActorPortraitTickManager& FActorPortraitTickManager::Get()
+{
+	static FActorPortraitTickManager TickManager;
+	return TickManager;
+}
+
+void FActorPortraitTickManager::RegisterScene(FActorPortraitScene* Scene)
+{
+	check(IsInGameThread());
+	check(Scene);
+
+	Scenes.AddUnique(Scene);
+	bScenesNeedSorting = true;
+
+	// The core ticker runs outside of the world ticks, so the portrait worlds never tick while another world is in its tick
+	if (!TickerHandle.IsValid())
+	{
+		TickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FActorPortraitTickManager::Tick));
+	}
+}
+
+void FActorPortraitTickManager::UnregisterScene(FActorPortraitScene* Scene)
+{
+	check(IsInGameThread());
+
+	const int32 Index = Scenes.Find(Scene);
+	if (Index == INDEX_NONE)
+	{
+		return;
+	}
+
+	// A world tick can destroy portraits, keep the indices stable until the pass has finished
+	if (bIsTicking)
+	{
+		Scenes[Index] = nullptr;
+		return;
+	}
+
+	Scenes.RemoveAt(Index);
+
+	if (Scenes.Num() == 0 && TickerHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+		TickerHandle.Reset();
+	}
+}
+
+bool FActorPortraitTickManager::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_ActorPortraitTickManager_Tick);
+	SET_DWORD_STAT(STAT_ActorPortraitTickManager_NumScenes, Scenes.Num());
+
+	if (bScenesNeedSorting)
+	{
+		Algo::StableSortBy(Scenes, [](const FActorPortraitScene* Scene) { return Scene->GetTickPriority(); }, TGreater<>());
+		bScenesNeedSorting = false;
+	}
+
+	{
+		TGuardValue<bool> TickingGuard(bIsTicking, true);
+
+		for (int32 Index = 0; Index < Scenes.Num(); ++Index)
+		{
+			if (FActorPortraitScene* Scene = Scenes[Index])
+			{
+				Scene->TickManaged(DeltaTime);
+			}
+		}
+	}
+
+	Scenes.Remove(nullptr);
+
+	if (Scenes.Num() == 0)
+	{
+		TickerHandle.Reset();
+		return false;
+	}
+
+	return true;
+}
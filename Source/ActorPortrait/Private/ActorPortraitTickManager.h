@@ -0,0 +1,38 @@
+// Copyright Mans Isaksson. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+
+class FActorPortraitScene;
+
+/**
+ * Ticks the portrait worlds which were created without an engine world context. All of them are ticked in a single pass per frame,
+ * ordered by tick priority, so the engine's world context count and per-frame world iteration don't grow with the number of portraits.
+ */
+class FActorPortraitTickManager
+{
+private:
+	TArray<FActorPortraitScene*> Scenes;
+
+	FTSTicker::FDelegateHandle TickerHandle;
+
+	bool bScenesNeedSorting = false;
+	bool bIsTicking = false;
+
+public:
+	static FActorPortraitTickManager& Get();
+
+	void RegisterScene(FActorPortraitScene* Scene);
+
+	void UnregisterScene(FActorPortraitScene* Scene);
+
+	// Re-sorts the scenes before the next tick, called when the tick priority of a registered scene changes
+	FORCEINLINE void MarkPrioritiesDirty() { bScenesNeedSorting = true; }
+
+	FORCEINLINE int32 Num() const { return Scenes.Num(); }
+
+private:
+	bool Tick(float DeltaTime);
+};
@@ -0,0 +1,64 @@
+// Copyright Mans Isaksson. All Rights Reserved.
+
+#include "ActorPortraitWorldTickDispatcher.h"
+#include "ActorPortraitScene.h"
+
+#include "Engine/World.h"
+
+FActorPortraitWorldTickDispatcher& FActorPortraitWorldTickDispatcher::Get()
+{
+	static FActorPortraitWorldTickDispatcher Dispatcher;
+	return Dispatcher;
+}
+
+void FActorPortraitWorldTickDispatcher::RegisterScene(const UWorld* World, FActorPortraitScene* Scene)
+{
+	check(IsInGameThread());
+	check(World && Scene);
+
+	Scenes.Add(World, Scene);
+
+	// Only bound while there are portrait scenes, so the game world doesn't pay for the dispatch when no portraits exist
+	if (!WorldTickStartHandle.IsValid())
+	{
+		WorldTickStartHandle = FWorldDelegates::OnWorldTickStart.AddRaw(this, &FActorPortraitWorldTickDispatcher::OnWorldTickStart);
+		WorldTickEndHandle   = FWorldDelegates::OnWorldTickEnd.AddRaw(this, &FActorPortraitWorldTickDispatcher::OnWorldTickEnd);
+	}
+}
+
+void FActorPortraitWorldTickDispatcher::UnregisterScene(FActorPortraitScene* Scene)
+{
+	check(IsInGameThread());
+
+	for (auto It = Scenes.CreateIterator(); It; ++It)
+	{
+		if (It.Value() == Scene)
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	if (Scenes.Num() == 0 && WorldTickStartHandle.IsValid())
+	{
+		FWorldDelegates::OnWorldTickStart.Remove(WorldTickStartHandle);
+		FWorldDelegates::OnWorldTickEnd.Remove(WorldTickEndHandle);
+		WorldTickStartHandle.Reset();
+		WorldTickEndHandle.Reset();
+	}
+}
+
+void FActorPortraitWorldTickDispatcher::OnWorldTickStart(UWorld* InWorld, ELevelTick TickType, float DeltaSeconds)
+{
+	if (FActorPortraitScene* const* Scene = Scenes.Find(InWorld))
+	{
+		(*Scene)->OnWorldTickStart(InWorld, TickType, DeltaSeconds);
+	}
+}
+
+void FActorPortraitWorldTickDispatcher::OnWorldTickEnd(UWorld* InWorld, ELevelTick TickType, float DeltaSeconds)
+{
+	if (FActorPortraitScene* const* Scene = Scenes.Find(InWorld))
+	{
+		(*Scene)->OnWorldTickEnd(InWorld, TickType, DeltaSeconds);
+	}
+}
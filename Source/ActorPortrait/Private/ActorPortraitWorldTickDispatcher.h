@@ -0,0 +1,40 @@
+// Copyright Mans Isaksson. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineBaseTypes.h"
+
+class FActorPortraitScene;
+class UWorld;
+
+/**
+ * Routes the world tick start and end events to the portrait scene owning the ticking world. Binding a single handler and looking
+ * the world up keeps the cost per world tick constant, instead of every portrait scene being invoked for every world that ticks.
+ */
+class FActorPortraitWorldTickDispatcher
+{
+private:
+	TMap<const UWorld*, FActorPortraitScene*> Scenes;
+
+	FDelegateHandle WorldTickStartHandle;
+	FDelegateHandle WorldTickEndHandle;
+
+public:
+	static FActorPortraitWorldTickDispatcher& Get();
+
+	// Starts routing the tick events of the world to the scene, the scene must be unregistered before its world is destroyed
+	void RegisterScene(const UWorld* World, FActorPortraitScene* Scene);
+
+	void UnregisterScene(FActorPortraitScene* Scene);
+
+	FORCEINLINE int32 Num() const { return Scenes.Num(); }
+
+private:
+	// Benchmarks the handlers against the per-scene handlers they replace
+	friend class FActorPortraitWorldTickDispatchBenchmark;
+
+	void OnWorldTickStart(UWorld* InWorld, ELevelTick TickType, float DeltaSeconds);
+
+	void OnWorldTickEnd(UWorld* InWorld, ELevelTick TickType, float DeltaSeconds);
+};
@@ -6,24 +6,120 @@
 #include "EngineUtils.h"
 #include "Engine/Engine.h"
 #include "Engine/World.h"
+#include "Components/ActorComponent.h"
 #include "Engine/TextureCube.h"
 #include "Engine/LevelStreaming.h"
 #include "Engine/WorldComposition.h"
 #include "ShaderCompiler.h"
 #include "AudioDevice.h"
 #include "UObject/Package.h"
+#include "UObject/LinkerInstancingContext.h"
+#include "Misc/PackagePath.h"
+#include "Async/ParallelFor.h"
+#include "Algo/NoneOf.h"
+#include "HAL/IConsoleManager.h"
+#include "Containers/Ticker.h"
+#include "UObject/PropertyIterator.h"
+#include "UObject/UnrealType.h"
+#include "UObject/PropertyOptional.h"
 
 #include "ActorPortraitModule.h"
+#include "ActorPortraitProjectSettings.h"
+#include "ActorPortraitStats.h"
+#include "ActorPortraitConstructionQueue.h"
 
 DEFINE_LOG_CATEGORY_STATIC(LogInstanceWorld, Log, All);
 
+DECLARE_DWORD_COUNTER_STAT(TEXT("Live Instance Worlds"), STAT_ActorPortrait_LiveInstanceWorlds, STATGROUP_ActorPortrait);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Instance Ids Waiting For GC"), STAT_ActorPortrait_ReleasedInstanceIds, STATGROUP_ActorPortrait);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Free Instance Ids"), STAT_ActorPortrait_FreeInstanceIds, STATGROUP_ActorPortrait);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Highest Instance Id"), STAT_ActorPortrait_HighestInstanceId, STATGROUP_ActorPortrait);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Instance Package Names"), STAT_ActorPortrait_InstancePackageNames, STATGROUP_ActorPortrait);
+
+static TAutoConsoleVariable<bool> CVarParallelSoftPathFixup(
+	TEXT("ActorPortrait.ParallelSoftPathFixup"),
+	true,
+	TEXT("Whether to redirect the soft object paths of instanced background worlds on worker threads."));
+
+static TAutoConsoleVariable<bool> CVarSerializeSoftPathFixup(
+	TEXT("ActorPortrait.SerializeSoftPathFixup"),
+	true,
+	TEXT("Whether to redirect the soft object paths of instanced background worlds by serializing every object (single threaded) instead of only visiting reflected soft object properties.\n")
+	TEXT("Disable to visit the reflected properties on worker threads, which is faster but misses soft object paths written by custom Serialize implementations."));
+
+static TAutoConsoleVariable<bool> CVarBatchComponentRegistration(
+	TEXT("ActorPortrait.BatchComponentRegistration"),
+	true,
+	TEXT("Whether to batch the primitive registration of background world actors during world initialization, creating their scene proxies in parallel."));
+
+namespace InstanceWorldContexts
+{
+	// World contexts of instance worlds created without an engine world context. These are never added to the engine's world list,
+	// so the engine doesn't iterate or tick the worlds.
+	static TMap<TObjectKey<UWorld>, TUniquePtr<FWorldContext>> PrivateWorldContexts;
+
+	static FWorldContext& CreateWorldContext(UWorld* InWorld, bool bUseEngineWorldContext)
+	{
+		if (bUseEngineWorldContext)
+		{
+			return GEngine->CreateNewWorldContext(EWorldType::GamePreview);
+		}
+
+		TUniquePtr<FWorldContext>& WorldContext = PrivateWorldContexts.Add(InWorld, MakeUnique<FWorldContext>());
+		WorldContext->WorldType = EWorldType::GamePreview;
+		return *WorldContext;
+	}
+
+	static FWorldContext& GetWorldContextChecked(UWorld* InWorld)
+	{
+		if (TUniquePtr<FWorldContext>* WorldContext = PrivateWorldContexts.Find(InWorld))
+		{
+			return **WorldContext;
+		}
+
+		return GEngine->GetWorldContextFromWorldChecked(InWorld);
+	}
+
+	static void DestroyWorldContext(UWorld* InWorld)
+	{
+		if (PrivateWorldContexts.Remove(InWorld) == 0)
+		{
+			GEngine->DestroyWorldContext(InWorld);
+		}
+	}
+}
+
+/** A background world loaded once and duplicated in memory for every instance world using it */
+struct FInstanceWorldTemplate
+{
+	TObjectPtr<UWorld> World = nullptr;
+
+	FString WorldPackageName;
+
+	/** Paths (relative to the world) of the objects which need their soft object paths redirected when instanced */
+	TArray<FString> ObjectsWithSoftReferences;
+
+	int32 NumUsers = 0;
+
+	// Time the last user released the template, unused templates are kept loaded for BackgroundWorldTemplateIdleTimeout
+	double ReleaseTime = 0.0;
+
+	bool bIsLoading = false;
+	int32 LoadRequestId = INDEX_NONE;
+	TArray<TFunction<void(const FInstanceWorldTemplate*)>> PendingCallbacks;
+};
+
 struct FInstanceWorldHelpers
 {
 	static const FString InstancePrefix;
+	static const FString TemplatePrefix;
 
-	/** Package names currently being duplicated, needed by FixupForInstance */
+	/** Package names currently being duplicated, needed by FSoftPathInstanceFixup */
 	static TSet<FName> InstancePackageNames;
 
+	/** The package names each live instance has added to InstancePackageNames */
+	static TMap<int32, TArray<FName>> InstancePackageNamesById;
+
 	static FString ConvertToInstancePackageName(const FString& PackageName, int32 InstanceID)
 	{
 		const FString PackageAssetName = FPackageName::GetLongPackageAssetName(PackageName);
@@ -46,9 +142,29 @@ struct FInstanceWorldHelpers
 		return FString::Printf(TEXT("%s_%d_"), *InstancePrefix, InstanceID);
 	}
 
-	static void AddInstancePackageName(FName NewPIEPackageName)
+	static void AddInstancePackageName(FName NewPIEPackageName, int32 InstanceID)
+	{
+		bool bIsAlreadyInSet = false;
+		InstancePackageNames.Add(NewPIEPackageName, &bIsAlreadyInSet);
+
+		if (!bIsAlreadyInSet)
+		{
+			InstancePackageNamesById.FindOrAdd(InstanceID).Add(NewPIEPackageName);
+		}
+	}
+
+	/** Unregisters all package names added for the instance, returning them */
+	static TArray<FName> RemoveInstancePackageNames(int32 InstanceID)
 	{
-		InstancePackageNames.Add(NewPIEPackageName);
+		TArray<FName> RemovedPackageNames;
+		InstancePackageNamesById.RemoveAndCopyValue(InstanceID, RemovedPackageNames);
+
+		for (const FName& PackageName : RemovedPackageNames)
+		{
+			InstancePackageNames.Remove(PackageName);
+		}
+
+		return RemovedPackageNames;
 	}
 
 	static FString StripPrefixFromPackageName(const FString& PrefixedName, const FString& Prefix)
@@ -83,12 +199,12 @@ struct FInstanceWorldHelpers
 
 			FString InstancePackageName = FInstanceWorldHelpers::ConvertToInstancePackageName(Tile.PackageName.ToString(), InstanceID);
 			Tile.PackageName = FName(*InstancePackageName);
-			FInstanceWorldHelpers::AddInstancePackageName(Tile.PackageName);
+			FInstanceWorldHelpers::AddInstancePackageName(Tile.PackageName, InstanceID);
 			for (FName& LODPackageName : Tile.LODPackageNames)
 			{
 				FString InstanceLODPackageName = FInstanceWorldHelpers::ConvertToInstancePackageName(LODPackageName.ToString(), InstanceID);
 				LODPackageName = FName(*InstanceLODPackageName);
-				FInstanceWorldHelpers::AddInstancePackageName(LODPackageName);
+				FInstanceWorldHelpers::AddInstancePackageName(LODPackageName, InstanceID);
 			}
 		}
 	}
@@ -104,7 +220,7 @@ struct FInstanceWorldHelpers
 		}
 
 		FName PlayWorldStreamingPackageName = FName(*FInstanceWorldHelpers::ConvertToInstancePackageName(StreamingLevel->GetWorldAssetPackageName(), InstanceID));
-		FInstanceWorldHelpers::AddInstancePackageName(PlayWorldStreamingPackageName);
+		FInstanceWorldHelpers::AddInstancePackageName(PlayWorldStreamingPackageName, InstanceID);
 		StreamingLevel->SetWorldAssetByPackageName(PlayWorldStreamingPackageName);
 
 		// Rename LOD levels if any
@@ -119,89 +235,335 @@ struct FInstanceWorldHelpers
 				// Apply Instance prefix to package name			
 				const FName NonPrefixedLODPackageName = LODPackageName;
 				LODPackageName = FName(*FInstanceWorldHelpers::ConvertToInstancePackageName(LODPackageName.ToString(), InstanceID));
-				FInstanceWorldHelpers::AddInstancePackageName(LODPackageName);
+				FInstanceWorldHelpers::AddInstancePackageName(LODPackageName, InstanceID);
 			}
 		}
 	}
 
-	static void RedirectObjectSoftReferencesToInstance(UObject* Object, int32 InstanceID)
+	/** Rewrites soft object paths pointing at the source packages of an instance world to point at the instance packages instead */
+	struct FSoftPathInstanceFixup
 	{
-		struct FSoftPathInstanceFixupSerializer : public FArchiveUObject
+		int32 InstanceID;
+		FString InstancePackagePrefix;
+
+		/** Source package -> instance package, NAME_None if the package is already an instance package */
+		TMap<FName, FName> InstancePackageNameCache;
+
+		/** Source asset name -> instance asset name */
+		TMap<FName, FName> InstanceAssetNameCache;
+
+		FSoftPathInstanceFixup(int32 InInstanceID)
+			: InstanceID(InInstanceID)
+			, InstancePackagePrefix(BuildInstancePackagePrefix(InInstanceID))
+		{
+		}
+
+		void FixupForInstance(FSoftObjectPath& SoftPath)
 		{
-			int32 InstanceID;
+			if (InstanceID == INDEX_NONE || SoftPath.IsNull())
+			{
+				return;
+			}
 
-			FSoftPathInstanceFixupSerializer(int32 InInstanceID)
-				: InstanceID(InInstanceID)
+			const FTopLevelAssetPath AssetPath = SoftPath.GetAssetPath();
+
+			// NAME_None if this reference has already been fixed up for instance
+			const FName InstancePackage = GetInstancePackageName(AssetPath.GetPackageName());
+			if (InstancePackage.IsNone())
+			{
+				return;
+			}
+
+			// Name of the ULevel subobject of UWorld, set in InitializeNewWorld
+			const bool bIsChildOfLevel = SoftPath.GetSubPathString().StartsWith(TEXT("PersistentLevel."));
+
+			// Only redirect if this an already registered Instance package or this looks like a level subobject reference
+			if (!bIsChildOfLevel && !InstancePackageNames.Contains(InstancePackage))
 			{
-				this->SetIsSaving(true);
+				return;
 			}
 
-			static void FixupForInstance(FSoftObjectPath& SoftPath, int32 InstanceID)
+			// NOTE: For some reason, we get the INST_X prefix on both the package and the object in the editor so we need to prefix the asset name as well.
+			const FName InstanceAssetName = GEngine->IsEditor() ? GetInstanceAssetName(AssetPath.GetAssetName()) : AssetPath.GetAssetName();
+
+			SoftPath = FSoftObjectPath(FTopLevelAssetPath(InstancePackage, InstanceAssetName), SoftPath.GetSubPathString());
+		}
+
+		void FixupObject(UObject* Object)
+		{
+			for (TPropertyValueIterator<FProperty> It(Object->GetClass(), Object); It; ++It)
 			{
-				if (InstanceID != INDEX_NONE && !SoftPath.IsNull())
+				const FProperty* Property = It.Key();
+
+				if (Property->IsA<FSoftObjectProperty>())
 				{
-					const FString Path = SoftPath.ToString();
+					FSoftObjectPtr* SoftObjectPtr = (FSoftObjectPtr*)It.Value();
 
-					// Determine if this reference has already been fixed up for instance
-					if (!HasInstancePrefix(Path))
+					FSoftObjectPath SoftPath = SoftObjectPtr->ToSoftObjectPath();
+					FixupForInstance(SoftPath);
+
+					if (SoftPath != SoftObjectPtr->ToSoftObjectPath())
 					{
-						// Name of the ULevel subobject of UWorld, set in InitializeNewWorld
-						const bool bIsChildOfLevel = SoftPath.GetSubPathString().StartsWith(TEXT("PersistentLevel."));
-
-						const FString ShortPackageOuterAndName = FPackageName::GetLongPackageAssetName(Path);
-
-						FString InstancePath;
-						if (GEngine->IsEditor())
-						{
-							// NOTE: For some reason, we get the INST_X prefix on both the package and the object in the editor so we need to some some extra fiddling with the path.
-							FString PackageName;
-							FString ObjectName;
-							ShortPackageOuterAndName.Split(".", &PackageName, &ObjectName);
-							const FString PrefixedPackageName = FString::Printf(TEXT("%s%s"), *FInstanceWorldHelpers::BuildInstancePackagePrefix(InstanceID), *PackageName);
-							const FString PrefixedObjectName = FString::Printf(TEXT("%s%s"), *FInstanceWorldHelpers::BuildInstancePackagePrefix(InstanceID), *ObjectName);
-							const FString PrefixedShortPackageOuterAndName = FString::Printf(TEXT("%s.%s"), *PrefixedPackageName, *PrefixedObjectName);
-							InstancePath = FString::Printf(TEXT("%s/%s"), *FPackageName::GetLongPackagePath(Path), *PrefixedShortPackageOuterAndName);
-						}
-						else
-						{
-							InstancePath = FString::Printf(TEXT("%s/%s%s"), *FPackageName::GetLongPackagePath(Path), *FInstanceWorldHelpers::BuildInstancePackagePrefix(InstanceID), *ShortPackageOuterAndName);
-						}
-
-						const FName InstancePackage = (!bIsChildOfLevel ? FName(*FPackageName::ObjectPathToPackageName(InstancePath)) : NAME_None);
-
-						// Duplicate if this an already registered Instance package or this looks like a level subobject reference
-						if (bIsChildOfLevel || InstancePackageNames.Contains(InstancePackage))
-						{
-							// Need to prepend Instance prefix, as we're in a Instance world and this refers to an object in an Instance package
-							SoftPath.SetPath(MoveTemp(InstancePath));
-						}
+						*SoftObjectPtr = FSoftObjectPtr(SoftPath);
 					}
 				}
-			};
+				else if (IsSoftObjectPathStruct(Property))
+				{
+					FixupForInstance(*(FSoftObjectPath*)It.Value());
+					It.SkipRecursiveProperty();
+				}
+			}
+		}
+
+	private:
+		FName GetInstancePackageName(FName PackageName)
+		{
+			if (const FName* CachedName = InstancePackageNameCache.Find(PackageName))
+			{
+				return *CachedName;
+			}
+
+			const FString PackageNameString = PackageName.ToString();
 
-			FArchive& operator<<(FSoftObjectPath& Value)
+			const FName InstancePackageName = HasInstancePrefix(PackageNameString) 
+				? NAME_None
+				: FName(*FString::Printf(TEXT("%s/%s%s"), *FPackageName::GetLongPackagePath(PackageNameString), *InstancePackagePrefix, *FPackageName::GetLongPackageAssetName(PackageNameString)));
+
+			InstancePackageNameCache.Add(PackageName, InstancePackageName);
+			return InstancePackageName;
+		}
+
+		FName GetInstanceAssetName(FName AssetName)
+		{
+			if (const FName* CachedName = InstanceAssetNameCache.Find(AssetName))
 			{
-				FixupForInstance(Value, InstanceID);
-				return *this;
+				return *CachedName;
 			}
-		};
 
+			const FName InstanceAssetName = FName(*(InstancePackagePrefix + AssetName.ToString()));
+
+			InstanceAssetNameCache.Add(AssetName, InstanceAssetName);
+			return InstanceAssetName;
+		}
+	};
+
+	/** Fixes up soft object paths written by custom Serialize implementations as well, used when ActorPortrait.SerializeSoftPathFixup is enabled */
+	struct FSoftPathInstanceFixupSerializer : public FArchiveUObject
+	{
+		FSoftPathInstanceFixup& Fixup;
+
+		FSoftPathInstanceFixupSerializer(FSoftPathInstanceFixup& InFixup)
+			: Fixup(InFixup)
+		{
+			this->SetIsSaving(true);
+		}
+
+		FArchive& operator<<(FSoftObjectPath& Value)
+		{
+			Fixup.FixupForInstance(Value);
+			return *this;
+		}
+	};
+
+	static bool IsSoftObjectPathStruct(const FProperty* Property)
+	{
+		const FStructProperty* StructProperty = CastField<FStructProperty>(Property);
+		return StructProperty 
+			&& (StructProperty->Struct == TBaseStructure<FSoftObjectPath>::Get() || StructProperty->Struct == TBaseStructure<FSoftClassPath>::Get());
+	}
+
+	/** Returns true if any of the reflected properties of the struct can hold a soft object path, cached per struct. Game thread only. */
+	static bool CanContainSoftObjectPaths(const UStruct* Struct)
+	{
+		check(IsInGameThread());
+
+		static TMap<TObjectKey<UStruct>, bool> CachedResults;
+		if (const bool* CachedResult = CachedResults.Find(Struct))
+		{
+			return *CachedResult;
+		}
+
+		// Guards against recursive structs, overwritten below
+		CachedResults.Add(Struct, false);
+
+		bool bCanContainSoftObjectPaths = false;
+		for (TFieldIterator<FProperty> It(Struct); It && !bCanContainSoftObjectPaths; ++It)
+		{
+			bCanContainSoftObjectPaths = CanContainSoftObjectPaths(*It);
+		}
+
+		CachedResults.Add(Struct, bCanContainSoftObjectPaths);
+		return bCanContainSoftObjectPaths;
+	}
+
+	static bool CanContainSoftObjectPaths(const FProperty* Property)
+	{
+		if (Property->IsA<FSoftObjectProperty>() || IsSoftObjectPathStruct(Property))
+		{
+			return true;
+		}
+		else if (const FStructProperty* StructProperty = CastField<FStructProperty>(Property))
+		{
+			return CanContainSoftObjectPaths(StructProperty->Struct);
+		}
+		else if (const FArrayProperty* ArrayProperty = CastField<FArrayProperty>(Property))
+		{
+			return CanContainSoftObjectPaths(ArrayProperty->Inner);
+		}
+		else if (const FSetProperty* SetProperty = CastField<FSetProperty>(Property))
+		{
+			return CanContainSoftObjectPaths(SetProperty->ElementProp);
+		}
+		else if (const FMapProperty* MapProperty = CastField<FMapProperty>(Property))
+		{
+			return CanContainSoftObjectPaths(MapProperty->KeyProp) || CanContainSoftObjectPaths(MapProperty->ValueProp);
+		}
+		else if (const FOptionalProperty* OptionalProperty = CastField<FOptionalProperty>(Property))
+		{
+			return CanContainSoftObjectPaths(OptionalProperty->GetValueProperty());
+		}
+
+		return false;
+	}
+
+	/** Redirects the soft object paths of the objects, spreading the work across worker threads when enabled */
+	static void RedirectSoftReferencesToInstance(TConstArrayView<UObject*> Objects, int32 InstanceID)
+	{
+		QUICK_SCOPE_CYCLE_COUNTER(STAT_InstanceWorld_RedirectSoftReferences);
+
+		if (CVarSerializeSoftPathFixup.GetValueOnGameThread())
+		{
+			FSoftPathInstanceFixup Fixup(InstanceID);
+			FSoftPathInstanceFixupSerializer FixupSerializer(Fixup);
+			for (UObject* Object : Objects)
+			{
+				Object->Serialize(FixupSerializer);
+			}
+			return;
+		}
+
+		// Only visit objects which can hold soft object paths at all
+		TArray<UObject*> ObjectsToFixup;
+		ObjectsToFixup.Reserve(Objects.Num());
+		for (UObject* Object : Objects)
+		{
+			if (CanContainSoftObjectPaths(Object->GetClass()))
+			{
+				ObjectsToFixup.Add(Object);
+			}
+		}
+
+		// Each task gets its own fixup so the name caches don't have to be shared between threads
+		TArray<FSoftPathInstanceFixup> TaskFixups;
+		const EParallelForFlags ParallelForFlags = CVarParallelSoftPathFixup.GetValueOnGameThread() ? EParallelForFlags::Unbalanced : EParallelForFlags::ForceSingleThread;
+
+		ParallelForWithTaskContext(TEXT("RedirectSoftReferencesToInstance"), TaskFixups, ObjectsToFixup.Num(), 
+			[InstanceID](int32 ContextIndex, int32 NumContexts) { return FSoftPathInstanceFixup(InstanceID); },
+			[&ObjectsToFixup](FSoftPathInstanceFixup& Fixup, int32 Index) { Fixup.FixupObject(ObjectsToFixup[Index]); },
+			ParallelForFlags);
+	}
+
+	static void RedirectObjectSoftReferencesToInstance(UObject* Object, int32 InstanceID)
+	{
 		/*
 			TODO: Do we want to recursively fix up all sub-objects?
 		*/
 
-		FSoftPathInstanceFixupSerializer FixupSerializer(InstanceID);
+		TArray<UObject*> ObjectsToFixup;
+		GetObjectsWithOuter(Object, ObjectsToFixup);
+		ObjectsToFixup.Add(Object);
+
+		RedirectSoftReferencesToInstance(ObjectsToFixup, InstanceID);
+	}
+
+	/** Returns the paths (relative to the world) of all objects in the persistent level which hold soft object paths */
+	static TArray<FString> FindObjectsWithSoftReferences(UWorld* World)
+	{
+		TArray<FString> OutObjectPaths;
+
+		TArray<UObject*> ObjectsToScan;
+		GetObjectsWithOuter(World->PersistentLevel, ObjectsToScan);
+		ObjectsToScan.Add(World->PersistentLevel);
+
+		// Custom Serialize implementations can write soft object paths the reflected properties don't show
+		const bool bSerialize = CVarSerializeSoftPathFixup.GetValueOnGameThread();
+
+		for (UObject* Object : ObjectsToScan)
+		{
+			if ((bSerialize || CanContainSoftObjectPaths(Object->GetClass())) && HasSoftObjectPaths(Object))
+			{
+				OutObjectPaths.Add(Object->GetPathName(World));
+			}
+		}
+
+		return OutObjectPaths;
+	}
+
+	static bool HasSoftObjectPaths(UObject* Object)
+	{
+		if (CVarSerializeSoftPathFixup.GetValueOnGameThread())
+		{
+			// Finds out whether the object serializes any soft object paths, without modifying them
+			struct FSoftPathScanner : public FArchiveUObject
+			{
+				bool bFoundSoftPath = false;
+
+				FSoftPathScanner() { this->SetIsSaving(true); }
+
+				FArchive& operator<<(FSoftObjectPath& Value)
+				{
+					bFoundSoftPath |= !Value.IsNull();
+					return *this;
+				}
+			} Scanner;
+
+			Object->Serialize(Scanner);
+			return Scanner.bFoundSoftPath;
+		}
+
+		for (TPropertyValueIterator<FProperty> It(Object->GetClass(), Object); It; ++It)
+		{
+			if (It.Key()->IsA<FSoftObjectProperty>())
+			{
+				if (!((const FSoftObjectPtr*)It.Value())->IsNull())
+				{
+					return true;
+				}
+			}
+			else if (IsSoftObjectPathStruct(It.Key()))
+			{
+				if (!((const FSoftObjectPath*)It.Value())->IsNull())
+				{
+					return true;
+				}
+				It.SkipRecursiveProperty();
+			}
+		}
+
+		return false;
+	}
+
+	/** Same as RedirectObjectSoftReferencesToInstance but only visits the objects known to hold soft object paths */
+	static void RedirectObjectSoftReferencesToInstance(UWorld* World, const TArray<FString>& ObjectsWithSoftReferences, int32 InstanceID)
+	{
+		TArray<UObject*> ObjectsToFixup;
+		ObjectsToFixup.Reserve(ObjectsWithSoftReferences.Num());
 
-		TArray<UObject*> SubObjects;
-		GetObjectsWithOuter(Object, SubObjects);
-		for (UObject* SubObject : SubObjects)
-			SubObject->Serialize(FixupSerializer);
+		for (const FString& ObjectPath : ObjectsWithSoftReferences)
+		{
+			if (UObject* Object = StaticFindObject(UObject::StaticClass(), World, *ObjectPath))
+			{
+				ObjectsToFixup.Add(Object);
+			}
+		}
 
-		Object->Serialize(FixupSerializer);
+		RedirectSoftReferencesToInstance(ObjectsToFixup, InstanceID);
 	}
 
-	static void RenameToInstanceWorld(UWorld* World, int32 InstanceID)
+	static void RenameToInstanceWorld(UWorld* World, int32 InstanceID, const FActorPortraitPhaseContext& PhaseContext, const TArray<FString>* ObjectsWithSoftReferences = nullptr)
 	{
+		ACTOR_PORTRAIT_PHASE_SCOPE(SoftPathFixup, PhaseContext);
+
 		if (World->WorldComposition)
 		{
 			FInstanceWorldHelpers::ReinitializeWorldCompositionForInstance(World->WorldComposition, InstanceID);
@@ -212,7 +574,14 @@ struct FInstanceWorldHelpers
 			RenameSteamingLevelForInstance(LevelStreaming, InstanceID);
 		}
 
-		FInstanceWorldHelpers::RedirectObjectSoftReferencesToInstance(World->PersistentLevel, InstanceID);
+		if (ObjectsWithSoftReferences)
+		{
+			FInstanceWorldHelpers::RedirectObjectSoftReferencesToInstance(World, *ObjectsWithSoftReferences, InstanceID);
+		}
+		else
+		{
+			FInstanceWorldHelpers::RedirectObjectSoftReferencesToInstance(World->PersistentLevel, InstanceID);
+		}
 	}
 
 	static void DeleteInstanceWorldPackage(UPackage* InstanceWorldPackage)
@@ -248,30 +617,84 @@ struct FInstanceWorldHelpers
 		InstanceWorldPackage->MarkAsGarbage();
 	}
 
-	static UWorld* CreateInstanceWorldByLoadingFromPackage(const FSoftObjectPath& WorldAsset, int32 InstanceID)
+	static UWorld* CreateInstanceWorldByLoadingFromPackage(const FSoftObjectPath& WorldAsset, int32 InstanceID, const UClass* ProfilingActorClass)
+	{
+		const FString WorldPackageName = UWorld::RemovePIEPrefix(FPackageName::ObjectPathToPackageName(WorldAsset.ToString()));
+		const FString InstancePackageName = FInstanceWorldHelpers::ConvertToInstancePackageName(WorldPackageName, InstanceID);
+
+		PreLoadInstanceWorldPackage(InstancePackageName, InstanceID);
+
+		// Loads the contents of "WorldPackageName" into a new package "NewWorldPackage"
+		UPackage* InstancePackage = CreatePackage(*InstancePackageName);
+		InstancePackage->SetFlags(EObjectFlags::RF_Transient);
+
+		UPackage* NewWorldPackage = nullptr;
+		{
+			ACTOR_PORTRAIT_PHASE_SCOPE(PackageLoad, FActorPortraitPhaseContext(WorldAsset, ProfilingActorClass));
+			NewWorldPackage = LoadPackage(InstancePackage, *WorldPackageName, LOAD_None);
+		}
+
+		return PostLoadInstanceWorldPackage(NewWorldPackage, WorldAsset, InstancePackageName, InstanceID, ProfilingActorClass);
+	}
+
+	/** Starts loading the world package through the async loader, OnWorldLoaded is called on the game thread once loading has completed (with nullptr on failure) */
+	static int32 CreateInstanceWorldByLoadingFromPackageAsync(const FSoftObjectPath& WorldAsset, int32 InstanceID, TWeakObjectPtr<UClass> ProfilingActorClass, TFunction<void(UWorld*)> OnWorldLoaded)
 	{
 		const FString WorldPackageName = UWorld::RemovePIEPrefix(FPackageName::ObjectPathToPackageName(WorldAsset.ToString()));
 		const FString InstancePackageName = FInstanceWorldHelpers::ConvertToInstancePackageName(WorldPackageName, InstanceID);
 
+		PreLoadInstanceWorldPackage(InstancePackageName, InstanceID);
+
+		// Loads the contents of "WorldPackageName" into a new package "InstancePackageName", the same way instanced streaming levels are loaded
+		FLinkerInstancingContext InstancingContext;
+		InstancingContext.AddPackageMapping(FName(*WorldPackageName), FName(*InstancePackageName));
+
+		FLoadPackageAsyncDelegate CompletionDelegate = FLoadPackageAsyncDelegate::CreateLambda(
+			[WorldAsset, InstancePackageName, InstanceID, ProfilingActorClass, OnWorldLoaded = MoveTemp(OnWorldLoaded)](const FName& PackageName, UPackage* LoadedPackage, EAsyncLoadingResult::Type Result)
+			{
+				UWorld* NewWorld = PostLoadInstanceWorldPackage(Result == EAsyncLoadingResult::Succeeded ? LoadedPackage : nullptr, WorldAsset, InstancePackageName, InstanceID, ProfilingActorClass.Get());
+				OnWorldLoaded(NewWorld);
+			});
+
+		return LoadPackageAsync(FPackagePath::FromPackageNameChecked(WorldPackageName), FName(*InstancePackageName), MoveTemp(CompletionDelegate), PKG_ContainsMap, INDEX_NONE, 0, &InstancingContext);
+	}
+
+	static void PreLoadInstanceWorldPackage(const FString& InstancePackageName, int32 InstanceID)
+	{
 		// Set the world type in the static map, so that UWorld::PostLoad can set the world type
 		UWorld::WorldTypePreLoadMap.FindOrAdd(*InstancePackageName) = EWorldType::GamePreview;
-		FInstanceWorldHelpers::AddInstancePackageName(*InstancePackageName);
+		FInstanceWorldHelpers::AddInstancePackageName(*InstancePackageName, InstanceID);
 
 		UPackage* ExistingPackage = FindPackage(nullptr, *InstancePackageName);
 		checkf(ExistingPackage == nullptr, TEXT("Instance world package already exists. Package: %s"), *InstancePackageName);
+	}
 
-		// Loads the contents of "WorldPackageName" into a new package "NewWorldPackage"
-		UPackage* InstancePackage = CreatePackage(*InstancePackageName);
-		InstancePackage->SetFlags(EObjectFlags::RF_Transient);
-		UPackage* NewWorldPackage = LoadPackage(InstancePackage, *WorldPackageName, LOAD_None);
+	static UWorld* PostLoadInstanceWorldPackage(UPackage* NewWorldPackage, const FSoftObjectPath& WorldAsset, const FString& InstancePackageName, int32 InstanceID, const UClass* ProfilingActorClass)
+	{
+		UWorld* NewWorld = FindLoadedWorld(NewWorldPackage, WorldAsset, InstancePackageName);
+		if (!NewWorld)
+		{
+			return nullptr;
+		}
+
+		FInstanceWorldHelpers::RenameToInstanceWorld(NewWorld, InstanceID, FActorPortraitPhaseContext(WorldAsset, ProfilingActorClass));
+
+		return NewWorld;
+	}
 
+	/** Finds the world in a package loaded into InstancePackageName, deleting the instance package on failure */
+	static UWorld* FindLoadedWorld(UPackage* NewWorldPackage, const FSoftObjectPath& WorldAsset, const FString& InstancePackageName)
+	{
 		// Clean up the world type list now that PostLoad has occurred
 		UWorld::WorldTypePreLoadMap.Remove(*InstancePackageName);
 
+		UPackage* InstancePackage = FindPackage(nullptr, *InstancePackageName);
+
 		if (NewWorldPackage == nullptr)
 		{
-			UE_LOG(LogInstanceWorld, Error, TEXT("Failed to load world package %s"), *WorldPackageName);
-			DeleteInstanceWorldPackage(InstancePackage);
+			UE_LOG(LogInstanceWorld, Error, TEXT("Failed to load world package %s"), *WorldAsset.GetLongPackageName());
+			if (InstancePackage)
+				DeleteInstanceWorldPackage(InstancePackage);
 			return nullptr;
 		}
 
@@ -284,76 +707,621 @@ struct FInstanceWorldHelpers
 			if (NewWorld)
 			{
 				NewWorldPackage = NewWorld->GetOutermost();
-				DeleteInstanceWorldPackage(InstancePackage);
+				if (InstancePackage)
+					DeleteInstanceWorldPackage(InstancePackage);
 			}
 		}
 
 		if (!NewWorld)
 		{
 			UE_LOG(LogInstanceWorld, Error, TEXT("Could not find a world in package %s"), *InstancePackageName);
-			DeleteInstanceWorldPackage(InstancePackage);
+			if (InstancePackage)
+				DeleteInstanceWorldPackage(InstancePackage);
 			return nullptr;
 		}
 
 		if (!NewWorld->PersistentLevel)
 		{
 			UE_LOG(LogInstanceWorld, Error, TEXT("Loaded world does not contain a PersistentLevel %s"), *WorldAsset.ToString());
-			DeleteInstanceWorldPackage(InstancePackage);
+			if (InstancePackage)
+				DeleteInstanceWorldPackage(InstancePackage);
 			return nullptr;
 		}
 
-		FInstanceWorldHelpers::RenameToInstanceWorld(NewWorld, InstanceID);
-
 		return NewWorld;
 	}
-};
-
-const FString FInstanceWorldHelpers::InstancePrefix     = TEXT("INST");
-TSet<FName> FInstanceWorldHelpers::InstancePackageNames = {};
 
-void UInstanceWorldLevelStreamingFixer::SetStreamingLevel(ULevelStreaming* InLevelStreaming, int32 InInstanceID)
-{
-	if (!IsValid(InLevelStreaming))
+	static FString GetWorldPackageName(const FSoftObjectPath& WorldAsset)
 	{
-		UE_LOG(LogInstanceWorld, Error, TEXT("UInstanceWorldLevelStreamingFixer::SetStreamingLevel, received invalid LevelStreaming"));
-		return;
+		return UWorld::RemovePIEPrefix(FPackageName::ObjectPathToPackageName(WorldAsset.ToString()));
 	}
 
-	if (InInstanceID == INDEX_NONE)
+	static FString BuildTemplatePackageName(const FString& WorldPackageName)
 	{
-		UE_LOG(LogInstanceWorld, Error, TEXT("UInstanceWorldLevelStreamingFixer::SetStreamingLevel, received invalid instance world index"));
-		return;
+		// Unique per template, so a template which is reloaded can't collide with a previous template still waiting to be garbage collected
+		static int32 TemplateId = 0;
+		return FString::Printf(TEXT("%s/%s_%d_%s"), *FPackageName::GetLongPackagePath(WorldPackageName), *TemplatePrefix, ++TemplateId, *FPackageName::GetLongPackageAssetName(WorldPackageName));
 	}
 
-	LevelStreaming = InLevelStreaming;
-	InstanceID = InInstanceID;
-	LevelStreaming->OnLevelShown.AddDynamic(this, &UInstanceWorldLevelStreamingFixer::OnLevelShown);
-}
-
-void UInstanceWorldLevelStreamingFixer::OnLevelShown()
-{
-	if (!IsValid(LevelStreaming))
+	static void DestroyLoadedWorld(UWorld* LoadedWorld)
 	{
-		UE_LOG(LogInstanceWorld, Error, TEXT("UInstanceWorldLevelStreamingFixer::OnLevelShown, LevelStreaming has been destroyed"));
-		return;
+		// Used for worlds which were loaded but never initialized
+		LoadedWorld->MarkObjectsPendingKill();
+		LoadedWorld->MarkAsGarbage();
+		DeleteInstanceWorldPackage(LoadedWorld->GetOutermost());
 	}
 
-	FInstanceWorldHelpers::RedirectObjectSoftReferencesToInstance(LevelStreaming->GetLoadedLevel(), InstanceID);
-}
+	/** Logs the cost of initializing a world, and how much was saved compared to worlds created with all subsystems */
+	static void ReportWorldCreation(UWorld* World, const FInstanceWorld::ConstructionValues& CVS, double InitTime, int64 InitMemory)
+	{
+		struct FWorldCreationStats
+		{
+			double TotalTime = 0.0;
+			double TotalMemory = 0.0;
+			int32 NumWorlds = 0;
 
-FInstanceWorld::FInstanceWorld(const ConstructionValues& CVS)
-{
-	InstanceId = GenerateUniqueInstanceWorldId();
+			double AverageTime() const { return NumWorlds > 0 ? TotalTime / NumWorlds : 0.0; }
+			double AverageMemory() const { return NumWorlds > 0 ? TotalMemory / NumWorlds : 0.0; }
+		};
 
-	double StartTime = 0.f;
+		// Indexed by which optional subsystems were created
+		static FWorldCreationStats CreationStats[16];
 
-	const FSoftObjectPath& WorldAssetPath = CVS.WorldAsset.ToSoftObjectPath();
-	bWorldWasLoadedFromPackage = WorldAssetPath.IsValid();
+		const uint32 SubsystemFlags = (CVS.bCreatePhysicsScene << 0) | (CVS.bCreateFXSystem << 1) | (CVS.bCreateAISystem << 2) | (CVS.bCreateNavigation << 3);
+		constexpr uint32 AllSubsystemFlags = 0xF;
+
+		FWorldCreationStats& Stats = CreationStats[SubsystemFlags];
+		Stats.TotalTime   += InitTime;
+		Stats.TotalMemory += InitMemory;
+		Stats.NumWorlds++;
+
+		UE_LOG(LogInstanceWorld, Verbose, TEXT("Initialized instance world %s in %.2f ms using %.2f MB (Physics: %d, FX: %d, AI: %d, Navigation: %d)"), 
+			*World->GetName(), InitTime * 1000.0, InitMemory / (1024.0 * 1024.0), CVS.bCreatePhysicsScene, CVS.bCreateFXSystem, CVS.bCreateAISystem, CVS.bCreateNavigation);
+
+		const FWorldCreationStats& FullStats = CreationStats[AllSubsystemFlags];
+		if (SubsystemFlags != AllSubsystemFlags && FullStats.NumWorlds > 0)
+		{
+			UE_LOG(LogInstanceWorld, Verbose, TEXT("Worlds without all subsystems saved on average %.2f ms and %.2f MB per world (%d worlds compared to %d worlds with all subsystems)"),
+				(FullStats.AverageTime() - Stats.AverageTime()) * 1000.0, (FullStats.AverageMemory() - Stats.AverageMemory()) / (1024.0 * 1024.0), Stats.NumWorlds, FullStats.NumWorlds);
+		}
+	}
+
+	static UWorld* CreateInstanceWorldFromTemplate(const FInstanceWorldTemplate& Template, int32 InstanceID, const FActorPortraitPhaseContext& PhaseContext)
+	{
+		QUICK_SCOPE_CYCLE_COUNTER(STAT_InstanceWorld_DuplicateTemplate);
+
+		UWorld* TemplateWorld = Template.World;
+		check(IsValid(TemplateWorld));
+
+		const FString InstancePackageName = FInstanceWorldHelpers::ConvertToInstancePackageName(Template.WorldPackageName, InstanceID);
+
+		PreLoadInstanceWorldPackage(InstancePackageName, InstanceID);
+
+		UPackage* InstancePackage = CreatePackage(*InstancePackageName);
+		InstancePackage->SetFlags(EObjectFlags::RF_Transient);
+		InstancePackage->SetLoadedPath(TemplateWorld->GetOutermost()->GetLoadedPath());
+
+		// Match the world name we would have gotten by loading the package, in the editor UWorld::PostLoad renames the world after its package
+		const FName InstanceWorldName = GIsEditor ? FName(*FPackageName::GetLongPackageAssetName(InstancePackageName)) : TemplateWorld->GetFName();
+
+		FObjectDuplicationParameters Parameters(TemplateWorld, InstancePackage);
+		Parameters.DestName      = InstanceWorldName;
+		Parameters.DestClass     = TemplateWorld->GetClass();
+		Parameters.DuplicateMode = EDuplicateMode::World;
+		Parameters.PortFlags     = PPF_Duplicate;
+
+		UWorld* NewWorld = Cast<UWorld>(StaticDuplicateObjectEx(Parameters));
+
+		UWorld::WorldTypePreLoadMap.Remove(*InstancePackageName);
+
+		if (!NewWorld || !NewWorld->PersistentLevel)
+		{
+			UE_LOG(LogInstanceWorld, Error, TEXT("Failed to duplicate template world %s"), *TemplateWorld->GetPathName());
+			DeleteInstanceWorldPackage(InstancePackage);
+			return nullptr;
+		}
+
+		NewWorld->WorldType = EWorldType::GamePreview;
+
+		FInstanceWorldHelpers::RenameToInstanceWorld(NewWorld, InstanceID, PhaseContext, &Template.ObjectsWithSoftReferences);
+
+		return NewWorld;
+	}
+};
+
+class FInstanceWorldTemplateCache : public FGCObject
+{
+private:
+	TMap<FName, TSharedRef<FInstanceWorldTemplate>> Templates;
+
+	FTSTicker::FDelegateHandle TickerHandle;
+
+public:
+	static FInstanceWorldTemplateCache& Get()
+	{
+		static FInstanceWorldTemplateCache TemplateCache;
+		return TemplateCache;
+	}
+
+	bool IsTemplateLoaded(const FSoftObjectPath& WorldAsset) const
+	{
+		const TSharedRef<FInstanceWorldTemplate>* Template = Templates.Find(FName(*FInstanceWorldHelpers::GetWorldPackageName(WorldAsset)));
+		return Template && !(*Template)->bIsLoading && IsValid((*Template)->World);
+	}
+
+	/** 
+	 * Adds a user to the template of WorldAsset, loading the template if needed. 
+	 * OnTemplateReady is called once the template has loaded (nullptr on failure), right away if the template is already loaded or if bLoadAsync is false.
+	 * Returns the key to pass to ReleaseTemplate once the user is done with the template.
+	 */
+	FName AcquireTemplate(const FSoftObjectPath& WorldAsset, bool bLoadAsync, TFunction<void(const FInstanceWorldTemplate*)> OnTemplateReady)
+	{
+		const FString WorldPackageName = FInstanceWorldHelpers::GetWorldPackageName(WorldAsset);
+		const FName TemplateKey = FName(*WorldPackageName);
+
+		TSharedRef<FInstanceWorldTemplate>* ExistingTemplate = Templates.Find(TemplateKey);
+		TSharedRef<FInstanceWorldTemplate> Template = ExistingTemplate ? *ExistingTemplate : Templates.Add(TemplateKey, MakeShared<FInstanceWorldTemplate>());
+		Template->WorldPackageName = WorldPackageName;
+		Template->NumUsers++;
+
+		if (Template->bIsLoading)
+		{
+			if (bLoadAsync)
+			{
+				Template->PendingCallbacks.Add(MoveTemp(OnTemplateReady));
+				return TemplateKey;
+			}
+
+			// Finishes the template load, which will invoke all pending callbacks
+			FlushAsyncLoading(Template->LoadRequestId);
+		}
+		else if (!IsValid(Template->World))
+		{
+			if (bLoadAsync)
+			{
+				Template->PendingCallbacks.Add(MoveTemp(OnTemplateReady));
+				LoadTemplateAsync(Template, WorldAsset);
+				return TemplateKey;
+			}
+
+			LoadTemplate(Template, WorldAsset);
+		}
+
+		OnTemplateReady(IsValid(Template->World) ? &Template.Get() : nullptr);
+		return TemplateKey;
+	}
+
+	void ReleaseTemplate(FName TemplateKey)
+	{
+		TSharedRef<FInstanceWorldTemplate>* Template = Templates.Find(TemplateKey);
+		if (!Template)
+		{
+			return;
+		}
+
+		// Templates still loading are released once loading has completed
+		if (--(*Template)->NumUsers <= 0 && !(*Template)->bIsLoading)
+		{
+			OnTemplateUnused(*Template);
+		}
+	}
+
+	// Destroys all templates which aren't used by any instance world
+	void Flush()
+	{
+		if (TickerHandle.IsValid())
+		{
+			FTSTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+			TickerHandle.Reset();
+		}
+
+		TrimUnusedTemplates(true);
+	}
+
+	// ~Begin FGCObject interface
+	virtual void AddReferencedObjects(FReferenceCollector& Collector) override
+	{
+		for (TPair<FName, TSharedRef<FInstanceWorldTemplate>>& Template : Templates)
+		{
+			Collector.AddReferencedObject(Template.Value->World);
+		}
+	}
+
+	virtual FString GetReferencerName() const override
+	{
+		return TEXT("FInstanceWorldTemplateCache");
+	}
+	// ~End FGCObject interface
+
+private:
+
+	void LoadTemplate(const TSharedRef<FInstanceWorldTemplate>& Template, const FSoftObjectPath& WorldAsset)
+	{
+		QUICK_SCOPE_CYCLE_COUNTER(STAT_InstanceWorld_LoadTemplate);
+
+		const FString TemplatePackageName = FInstanceWorldHelpers::BuildTemplatePackageName(Template->WorldPackageName);
+		PreLoadTemplatePackage(TemplatePackageName);
+
+		UPackage* TemplatePackage = CreatePackage(*TemplatePackageName);
+		TemplatePackage->SetFlags(EObjectFlags::RF_Transient);
+
+		UPackage* LoadedPackage = nullptr;
+		{
+			ACTOR_PORTRAIT_PHASE_SCOPE(PackageLoad, FActorPortraitPhaseContext(WorldAsset));
+			LoadedPackage = LoadPackage(TemplatePackage, *Template->WorldPackageName, LOAD_None);
+		}
+
+		OnTemplateLoaded(Template, FInstanceWorldHelpers::FindLoadedWorld(LoadedPackage, WorldAsset, TemplatePackageName));
+	}
+
+	void LoadTemplateAsync(const TSharedRef<FInstanceWorldTemplate>& Template, const FSoftObjectPath& WorldAsset)
+	{
+		const FString TemplatePackageName = FInstanceWorldHelpers::BuildTemplatePackageName(Template->WorldPackageName);
+		PreLoadTemplatePackage(TemplatePackageName);
+
+		Template->bIsLoading = true;
+
+		// NOTE: No linker instancing context here, we want the soft object paths in the template to keep pointing at the source package
+		// since they are redirected to each instance package when the template is duplicated.
+		TWeakPtr<FInstanceWorldTemplate> WeakTemplate = Template;
+		const int32 RequestId = LoadPackageAsync(FPackagePath::FromPackageNameChecked(Template->WorldPackageName), FName(*TemplatePackageName), FLoadPackageAsyncDelegate::CreateLambda(
+			[this, WeakTemplate, WorldAsset, TemplatePackageName](const FName& PackageName, UPackage* LoadedPackage, EAsyncLoadingResult::Type Result)
+			{
+				UWorld* LoadedWorld = FInstanceWorldHelpers::FindLoadedWorld(Result == EAsyncLoadingResult::Succeeded ? LoadedPackage : nullptr, WorldAsset, TemplatePackageName);
+
+				if (TSharedPtr<FInstanceWorldTemplate> PinnedTemplate = WeakTemplate.Pin())
+				{
+					OnTemplateLoaded(PinnedTemplate.ToSharedRef(), LoadedWorld);
+				}
+				else if (LoadedWorld)
+				{
+					FInstanceWorldHelpers::DestroyLoadedWorld(LoadedWorld);
+				}
+			}), PKG_ContainsMap);
+
+		if (Template->bIsLoading)
+		{
+			Template->LoadRequestId = RequestId;
+		}
+	}
+
+	void OnTemplateLoaded(const TSharedRef<FInstanceWorldTemplate>& Template, UWorld* LoadedWorld)
+	{
+		Template->bIsLoading    = false;
+		Template->LoadRequestId = INDEX_NONE;
+		Template->World         = LoadedWorld;
+
+		if (LoadedWorld)
+		{
+			Template->ObjectsWithSoftReferences = FInstanceWorldHelpers::FindObjectsWithSoftReferences(LoadedWorld);
+			UE_LOG(LogInstanceWorld, Verbose, TEXT("Loaded template world %s (%d objects with soft references)"), *Template->WorldPackageName, Template->ObjectsWithSoftReferences.Num());
+		}
+
+		TArray<TFunction<void(const FInstanceWorldTemplate*)>> Callbacks = MoveTemp(Template->PendingCallbacks);
+		for (TFunction<void(const FInstanceWorldTemplate*)>& Callback : Callbacks)
+		{
+			Callback(LoadedWorld ? &Template.Get() : nullptr);
+		}
+
+		if (Template->NumUsers <= 0)
+		{
+			OnTemplateUnused(Template);
+		}
+	}
+
+	// Keeps the template loaded for a while, portraits are often destroyed and re-created shortly after (e.g. by list views)
+	void OnTemplateUnused(const TSharedRef<FInstanceWorldTemplate>& Template)
+	{
+		const float IdleTimeout = UActorPortraitProjectSettings::Get().BackgroundWorldTemplateIdleTimeout;
+		if (IdleTimeout <= 0.f || !IsValid(Template->World) || FActorPortraitModule::IsShuttingDown())
+		{
+			DestroyTemplate(*Template);
+			Templates.Remove(FName(*Template->WorldPackageName));
+			return;
+		}
+
+		Template->ReleaseTime = FPlatformTime::Seconds();
+
+		if (!TickerHandle.IsValid())
+		{
+			TickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FInstanceWorldTemplateCache::Tick), 1.f);
+		}
+	}
+
+	// Destroys the unused templates which have been idle for longer than the timeout, or all unused templates if bForce is true. Returns the number of unused templates left.
+	int32 TrimUnusedTemplates(bool bForce)
+	{
+		const double IdleTimeout = UActorPortraitProjectSettings::Get().BackgroundWorldTemplateIdleTimeout;
+		const double CurrentTime = FPlatformTime::Seconds();
+
+		int32 NumUnusedTemplates = 0;
+
+		for (auto It = Templates.CreateIterator(); It; ++It)
+		{
+			FInstanceWorldTemplate& Template = It->Value.Get();
+			if (Template.NumUsers > 0 || Template.bIsLoading)
+			{
+				continue;
+			}
+
+			if (bForce || CurrentTime - Template.ReleaseTime > IdleTimeout)
+			{
+				UE_LOG(LogInstanceWorld, Verbose, TEXT("Destroying unused template world %s"), *Template.WorldPackageName);
+				DestroyTemplate(Template);
+				It.RemoveCurrent();
+				continue;
+			}
+
+			NumUnusedTemplates++;
+		}
+
+		return NumUnusedTemplates;
+	}
+
+	bool Tick(float DeltaTime)
+	{
+		QUICK_SCOPE_CYCLE_COUNTER(STAT_InstanceWorldTemplateCache_Tick);
+
+		if (TrimUnusedTemplates(false) == 0)
+		{
+			TickerHandle.Reset();
+			return false;
+		}
+
+		return true;
+	}
+
+	static void PreLoadTemplatePackage(const FString& TemplatePackageName)
+	{
+		// Templates are never initialized, they are only used as the source for duplication
+		UWorld::WorldTypePreLoadMap.FindOrAdd(*TemplatePackageName) = EWorldType::Inactive;
+	}
+
+	static void DestroyTemplate(FInstanceWorldTemplate& Template)
+	{
+		if (IsValid(Template.World))
+		{
+			FInstanceWorldHelpers::DestroyLoadedWorld(Template.World);
+		}
+
+		Template.World = nullptr;
+		Template.ObjectsWithSoftReferences.Empty();
+	}
+};
+
+const FString FInstanceWorldHelpers::InstancePrefix     = TEXT("INST");
+const FString FInstanceWorldHelpers::TemplatePrefix     = TEXT("TMPL");
+TSet<FName> FInstanceWorldHelpers::InstancePackageNames = {};
+TMap<int32, TArray<FName>> FInstanceWorldHelpers::InstancePackageNamesById = {};
+
+/**
+ * Hands out instance ids, recycling the ids of destroyed instance worlds. An id is only re-used once every package registered for it
+ * has been purged by the garbage collector, so a new instance can't collide with a package still waiting to be collected. The packages
+ * are checked after the purge rather than after reachability analysis, garbage packages can still be found until they have been purged.
+ * Sub-level packages which were still streaming in when the world was released don't exist yet, the id is also held until their loads
+ * have completed (and the packages have been purged) or been cancelled.
+ */
+class FInstanceWorldIdRegistry
+{
+private:
+	struct FReleasedInstanceId
+	{
+		int32 InstanceId;
+		TArray<FName> PackageNames;
+	};
+
+	int32 HighestInstanceId = 0;
+	int32 NumLiveInstances = 0;
+	TArray<int32> FreeInstanceIds;
+	TArray<FReleasedInstanceId> ReleasedInstanceIds;
+
+	FDelegateHandle PostPurgeGarbageHandle;
+
+public:
+	static FInstanceWorldIdRegistry& Get()
+	{
+		static FInstanceWorldIdRegistry Registry;
+		return Registry;
+	}
+
+	int32 AcquireInstanceId()
+	{
+		check(IsInGameThread());
+
+		NumLiveInstances++;
+
+		const int32 InstanceId = FreeInstanceIds.Num() > 0 ? FreeInstanceIds.Pop(EAllowShrinking::No) : ++HighestInstanceId;
+		UpdateStats();
+		return InstanceId;
+	}
+
+	void ReleaseInstanceId(int32 InstanceId)
+	{
+		check(IsInGameThread());
+
+		NumLiveInstances--;
+
+		ReleasedInstanceIds.Add(FReleasedInstanceId{ InstanceId, FInstanceWorldHelpers::RemoveInstancePackageNames(InstanceId) });
+
+		if (!PostPurgeGarbageHandle.IsValid())
+		{
+			PostPurgeGarbageHandle = FCoreUObjectDelegates::GetPostPurgeGarbageDelegate().AddRaw(this, &FInstanceWorldIdRegistry::OnPostPurgeGarbage);
+		}
+
+		UpdateStats();
+	}
+
+	void DumpToLog() const
+	{
+		UE_LOG(LogInstanceWorld, Display, TEXT("Instance worlds: %d live, %d ids waiting for garbage collection, %d free ids, %d ids handed out, %d registered instance package names"), 
+			NumLiveInstances, ReleasedInstanceIds.Num(), FreeInstanceIds.Num(), HighestInstanceId, FInstanceWorldHelpers::InstancePackageNames.Num());
+	}
+
+private:
+	void OnPostPurgeGarbage()
+	{
+		for (int32 Index = ReleasedInstanceIds.Num() - 1; Index >= 0; --Index)
+		{
+			const bool bAllPackagesCollected = Algo::NoneOf(ReleasedInstanceIds[Index].PackageNames, [](const FName& PackageName)
+			{
+				return FindPackage(nullptr, *PackageName.ToString()) != nullptr || GetAsyncLoadPercentage(PackageName) >= 0.f;
+			});
+
+			if (bAllPackagesCollected)
+			{
+				FreeInstanceIds.Add(ReleasedInstanceIds[Index].InstanceId);
+				ReleasedInstanceIds.RemoveAtSwap(Index, EAllowShrinking::No);
+			}
+		}
+
+		if (ReleasedInstanceIds.Num() == 0)
+		{
+			FCoreUObjectDelegates::GetPostPurgeGarbageDelegate().Remove(PostPurgeGarbageHandle);
+			PostPurgeGarbageHandle.Reset();
+		}
+
+		UpdateStats();
+	}
+
+	void UpdateStats() const
+	{
+		SET_DWORD_STAT(STAT_ActorPortrait_LiveInstanceWorlds, NumLiveInstances);
+		SET_DWORD_STAT(STAT_ActorPortrait_ReleasedInstanceIds, ReleasedInstanceIds.Num());
+		SET_DWORD_STAT(STAT_ActorPortrait_FreeInstanceIds, FreeInstanceIds.Num());
+		SET_DWORD_STAT(STAT_ActorPortrait_HighestInstanceId, HighestInstanceId);
+		SET_DWORD_STAT(STAT_ActorPortrait_InstancePackageNames, FInstanceWorldHelpers::InstancePackageNames.Num());
+	}
+};
+
+static FAutoConsoleCommand DumpInstanceWorldRegistryCommand(
+	TEXT("ActorPortrait.DumpInstanceWorlds"),
+	TEXT("Logs the number of live instance worlds, instance ids and registered instance package names. Useful to verify they stay flat over long sessions."),
+	FConsoleCommandDelegate::CreateLambda([]() { FInstanceWorldIdRegistry::Get().DumpToLog(); }));
+
+void UInstanceWorldLevelStreamingFixer::SetStreamingLevel(ULevelStreaming* InLevelStreaming, int32 InInstanceID)
+{
+	if (!IsValid(InLevelStreaming))
+	{
+		UE_LOG(LogInstanceWorld, Error, TEXT("UInstanceWorldLevelStreamingFixer::SetStreamingLevel, received invalid LevelStreaming"));
+		return;
+	}
+
+	if (InInstanceID == INDEX_NONE)
+	{
+		UE_LOG(LogInstanceWorld, Error, TEXT("UInstanceWorldLevelStreamingFixer::SetStreamingLevel, received invalid instance world index"));
+		return;
+	}
+
+	LevelStreaming = InLevelStreaming;
+	InstanceID = InInstanceID;
+	LevelStreaming->OnLevelShown.AddDynamic(this, &UInstanceWorldLevelStreamingFixer::OnLevelShown);
+}
+
+void UInstanceWorldLevelStreamingFixer::OnLevelShown()
+{
+	if (!IsValid(LevelStreaming))
+	{
+		UE_LOG(LogInstanceWorld, Error, TEXT("UInstanceWorldLevelStreamingFixer::OnLevelShown, LevelStreaming has been destroyed"));
+		return;
+	}
+
+	ACTOR_PORTRAIT_PHASE_SCOPE(SoftPathFixup, FActorPortraitPhaseContext(LevelStreaming->GetWorldAsset().ToSoftObjectPath()));
+	FInstanceWorldHelpers::RedirectObjectSoftReferencesToInstance(LevelStreaming->GetLoadedLevel(), InstanceID);
+}
+
+FInstanceWorld::FInstanceWorld(const ConstructionValues& CVS)
+	: WorldConstructionValues(CVS)
+{
+	InstanceId = FInstanceWorldIdRegistry::Get().AcquireInstanceId();
+
+	double StartTime = 0.f;
+
+	const FSoftObjectPath& WorldAssetPath = CVS.WorldAsset.ToSoftObjectPath();
+	bWorldWasLoadedFromPackage = WorldAssetPath.IsValid();
+
+	const bool bUseWorldTemplate = bWorldWasLoadedFromPackage && UActorPortraitProjectSettings::Get().bUseBackgroundWorldTemplates;
+
+	// Instancing an already loaded template is done synchronously since there is nothing to wait for
+	if (bWorldWasLoadedFromPackage && CVS.bLoadAsync && !(bUseWorldTemplate && FInstanceWorldTemplateCache::Get().IsTemplateLoaded(WorldAssetPath)))
+	{
+		bIsLoading = true;
+		LoadRequestToken = MakeShared<bool>(true);
+
+		StartTime = FPlatformTime::Seconds();
+
+		TWeakPtr<bool> WeakLoadRequestToken = LoadRequestToken;
+
+		if (bUseWorldTemplate)
+		{
+			TemplateKey = FInstanceWorldTemplateCache::Get().AcquireTemplate(WorldAssetPath, true, [this, WeakLoadRequestToken, StartTime](const FInstanceWorldTemplate* Template)
+			{
+				// Don't bother duplicating the template if the instance world was destroyed before the load completed
+				if (WeakLoadRequestToken.IsValid())
+				{
+					const FActorPortraitPhaseContext PhaseContext(WorldConstructionValues.WorldAsset.ToSoftObjectPath(), WorldConstructionValues.ProfilingActorClass.Get());
+					FinishAsyncWorldLoad(Template ? FInstanceWorldHelpers::CreateInstanceWorldFromTemplate(*Template, InstanceId, PhaseContext) : nullptr, StartTime);
+				}
+			});
+		}
+		else
+		{
+			bIsLoadingPackage = true;
+			FInstanceWorldHelpers::CreateInstanceWorldByLoadingFromPackageAsync(WorldAssetPath, InstanceId, CVS.ProfilingActorClass, [this, WeakLoadRequestToken, StartTime, LoadingInstanceId = InstanceId](UWorld* LoadedWorld)
+			{
+				if (!WeakLoadRequestToken.IsValid())
+				{
+					// The instance world was destroyed before the load completed, get rid of the loaded world
+					if (LoadedWorld)
+					{
+						FInstanceWorldHelpers::DestroyLoadedWorld(LoadedWorld);
+					}
+
+					// The id was kept by the destroyed instance world until the packages loaded for it have been destroyed
+					FInstanceWorldIdRegistry::Get().ReleaseInstanceId(LoadingInstanceId);
+					return;
+				}
+
+				FinishAsyncWorldLoad(LoadedWorld, StartTime);
+			});
+		}
+
+		return;
+	}
+
+	if (CVS.bTimeSliceConstruction && FActorPortraitConstructionQueue::IsEnabled())
+	{
+		bIsLoading = true;
+		LoadRequestToken = MakeShared<bool>(true);
+
+		StartTime = FPlatformTime::Seconds();
+
+		// Creating the world is the first stage, loading the package (or duplicating the template) can't be split up any further
+		FActorPortraitConstructionQueue::Get().Enqueue(LoadRequestToken, { [this, bUseWorldTemplate, StartTime]()
+		{
+			UWorld* CreatedWorld = bWorldWasLoadedFromPackage
+				? CreateWorldFromAsset(WorldConstructionValues.WorldAsset.ToSoftObjectPath(), bUseWorldTemplate)
+				: CreateEmptyWorld(InstanceId);
+
+			if (!CreatedWorld)
+			{
+				UE_LOG(LogInstanceWorld, Error, TEXT("Failed to create instanced world from %s"), *WorldConstructionValues.WorldAsset.ToString());
+
+				bIsLoading = false;
+				LoadRequestToken.Reset();
+				OnWorldLoaded();
+				return;
+			}
+
+			QueueTimeSlicedInitWorld(CreatedWorld, StartTime);
+		}});
+
+		return;
+	}
 
 	if (bWorldWasLoadedFromPackage)
 	{
 		StartTime = FPlatformTime::Seconds();
-		World = CreateWorldFromAsset(WorldAssetPath, InstanceId);
+		World = CreateWorldFromAsset(WorldAssetPath, bUseWorldTemplate);
 
 		if (!World)
 		{
@@ -375,19 +1343,196 @@ FInstanceWorld::FInstanceWorld(const ConstructionValues& CVS)
 	}
 }
 
+void FInstanceWorld::FinishAsyncWorldLoad(UWorld* LoadedWorld, double StartTime)
+{
+	check(IsInGameThread());
+
+	bIsLoadingPackage = false;
+	LoadRequestToken.Reset();
+
+	const FSoftObjectPath& WorldAssetPath = WorldConstructionValues.WorldAsset.ToSoftObjectPath();
+
+	if (LoadedWorld && WorldConstructionValues.bTimeSliceConstruction && FActorPortraitConstructionQueue::IsEnabled())
+	{
+		RegisterLevelStreamingFixers(LoadedWorld, InstanceId);
+
+		// The async load can't be scoped, report the wall time of the load request. The world is initialized in the following frames.
+		FActorPortraitPhaseScope::ReportPhase(TEXT("AsyncPackageLoad"), FActorPortraitPhaseContext(WorldAssetPath, WorldConstructionValues.ProfilingActorClass.Get()), FPlatformTime::Seconds() - StartTime);
+
+		QueueTimeSlicedInitWorld(LoadedWorld, StartTime);
+		return;
+	}
+
+	bIsLoading = false;
+
+	if (LoadedWorld)
+	{
+		RegisterLevelStreamingFixers(LoadedWorld, InstanceId);
+
+		World = LoadedWorld;
+		InitWorld(World, bWorldWasLoadedFromPackage, WorldConstructionValues);
+
+		double StopTime = FPlatformTime::Seconds();
+		UE_LOG(LogInstanceWorld, Verbose, TEXT("Took %f seconds to async LoadMap(%s)"), StopTime - StartTime, *WorldAssetPath.GetAssetName());
+
+		// The async load can't be scoped, report the wall time from the load request until the world was ready
+		FActorPortraitPhaseScope::ReportPhase(TEXT("AsyncPackageLoad"), FActorPortraitPhaseContext(WorldAssetPath, WorldConstructionValues.ProfilingActorClass.Get()), StopTime - StartTime);
+	}
+	else
+	{
+		UE_LOG(LogInstanceWorld, Error, TEXT("Failed to create instanced world from %s"), *WorldAssetPath.ToString());
+	}
+
+	OnWorldLoaded();
+}
+
+void FInstanceWorld::QueueTimeSlicedInitWorld(UWorld* CreatedWorld, double StartTime)
+{
+	check(IsInGameThread());
+
+	ConstructingWorld             = CreatedWorld;
+	bConstructingWorldInitialized = false;
+	ConstructingWorldStats        = FInitWorldStats();
+
+	if (!LoadRequestToken.IsValid())
+	{
+		LoadRequestToken = MakeShared<bool>(true);
+	}
+
+	auto MakeInitWorldStage = [this](EInitWorldStage Stage) -> FActorPortraitConstructionQueue::FStage
+	{
+		return [this, Stage]()
+		{
+			InitWorldStage(ConstructingWorld, bWorldWasLoadedFromPackage, WorldConstructionValues, Stage, ConstructingWorldStats);
+			bConstructingWorldInitialized = true;
+		};
+	};
+
+	FActorPortraitConstructionQueue::Get().Enqueue(LoadRequestToken,
+	{
+		MakeInitWorldStage(EInitWorldStage::InitializeWorld),
+		MakeInitWorldStage(EInitWorldStage::InitializeActorsForPlay),
+		MakeInitWorldStage(EInitWorldStage::BeginPlay),
+		[this, StartTime]()
+		{
+			World             = ConstructingWorld;
+			ConstructingWorld = nullptr;
+			bIsLoading        = false;
+			LoadRequestToken.Reset();
+
+			UE_LOG(LogInstanceWorld, Verbose, TEXT("Took %f seconds to time-sliced LoadMap(%s), %f seconds of which were spent initializing the world"),
+				FPlatformTime::Seconds() - StartTime, *WorldConstructionValues.WorldAsset.ToSoftObjectPath().GetAssetName(), ConstructingWorldStats.Time);
+
+			OnWorldLoaded();
+		}
+	});
+}
+
 FInstanceWorld::~FInstanceWorld()
 {
-	for (UActorComponent* ActorComponent : Components)
+	// A pending package load still uses the instance id, the load callback releases the id once the loaded world has been destroyed
+	const bool bReleaseInstanceId = !bIsLoadingPackage;
+
+	// Invalidates any pending async load and the remaining stages of a time-sliced construction
+	LoadRequestToken.Reset();
+
+	if (ConstructingWorld)
+	{
+		if (bConstructingWorldInitialized)
+		{
+			CleanupWorld(ConstructingWorld, bWorldWasLoadedFromPackage, WorldConstructionValues);
+		}
+		else
+		{
+			FInstanceWorldHelpers::DestroyLoadedWorld(ConstructingWorld);
+			ConstructingWorld = nullptr;
+		}
+	}
+
+	// Finishes the teardown of worlds which weren't (fully) torn down by FActorPortraitTeardownQueue
+	while (!TeardownNextStage())
+	{
+	}
+
+	if (!TemplateKey.IsNone())
+	{
+		FInstanceWorldTemplateCache::Get().ReleaseTemplate(TemplateKey);
+		TemplateKey = NAME_None;
+	}
+
+	if (bReleaseInstanceId)
+	{
+		FInstanceWorldIdRegistry::Get().ReleaseInstanceId(InstanceId);
+	}
+}
+
+bool FInstanceWorld::TeardownNextStage()
+{
+	check(IsInGameThread());
+
+	switch (TeardownStage)
+	{
+	case ETeardownStage::DestroyComponents:
+		OnBeginTeardown();
+
+		if (World)
+		{
+			World->SetShouldTick(false);
+		}
+
+		for (UActorComponent* ActorComponent : Components)
+		{
+			ActorComponent->DestroyComponent();
+		}
+		Components.Empty();
+		break;
+
+	case ETeardownStage::BeginTearingDown:
+	case ETeardownStage::EndPlay:
+	case ETeardownStage::DestroyWorld:
+		CleanupWorldStage(World, bWorldWasLoadedFromPackage, WorldConstructionValues, TeardownStage);
+		break;
+
+	default:
+		return true;
+	}
+
+	TeardownStage = (ETeardownStage)((int32)TeardownStage + 1);
+	return TeardownStage == ETeardownStage::Done;
+}
+
+bool FInstanceWorld::AreStreamingLevelsReady() const
+{
+	if (!World)
 	{
-		ActorComponent->DestroyComponent();
+		return false;
 	}
-	Components.Empty();
-	CleanupWorld(World, bWorldWasLoadedFromPackage);
+
+	for (ULevelStreaming* LevelStreaming : World->GetStreamingLevels())
+	{
+		if (!LevelStreaming)
+		{
+			continue;
+		}
+
+		if (LevelStreaming->ShouldBeLoaded() && !LevelStreaming->IsLevelLoaded())
+		{
+			return false;
+		}
+
+		if (LevelStreaming->ShouldBeVisible() && !LevelStreaming->IsLevelVisible())
+		{
+			return false;
+		}
+	}
+
+	return !World->IsVisibilityRequestPending();
 }
 
 void FInstanceWorld::AddReferencedObjects(FReferenceCollector& Collector)
 {
 	Collector.AddReferencedObject(World);
+	Collector.AddReferencedObject(ConstructingWorld);
 	Collector.AddReferencedObjects(Components);
 }
 
@@ -396,22 +1541,46 @@ FString FInstanceWorld::GetReferencerName() const
 	return FString::Printf(TEXT("FInstanceWorld_%d"), InstanceId);
 }
 
-UWorld* FInstanceWorld::CreateWorldFromAsset(const FSoftObjectPath& InWorldAssetPath, int32 InstanceId)
+void FInstanceWorld::FlushUnusedWorldTemplates()
 {
-	UWorld* World = FInstanceWorldHelpers::CreateInstanceWorldByLoadingFromPackage(InWorldAssetPath, InstanceId);
-	if (!World)
+	FInstanceWorldTemplateCache::Get().Flush();
+}
+
+UWorld* FInstanceWorld::CreateWorldFromAsset(const FSoftObjectPath& InWorldAssetPath, bool bUseWorldTemplate)
+{
+	UWorld* NewWorld = nullptr;
+
+	if (bUseWorldTemplate)
+	{
+		TemplateKey = FInstanceWorldTemplateCache::Get().AcquireTemplate(InWorldAssetPath, false, [this, &NewWorld](const FInstanceWorldTemplate* Template)
+		{
+			const FActorPortraitPhaseContext PhaseContext(InWorldAssetPath, WorldConstructionValues.ProfilingActorClass.Get());
+			NewWorld = Template ? FInstanceWorldHelpers::CreateInstanceWorldFromTemplate(*Template, InstanceId, PhaseContext) : nullptr;
+		});
+	}
+	else
+	{
+		NewWorld = FInstanceWorldHelpers::CreateInstanceWorldByLoadingFromPackage(InWorldAssetPath, InstanceId, WorldConstructionValues.ProfilingActorClass.Get());
+	}
+
+	if (!NewWorld)
 	{
 		return nullptr;
 	}
 
+	RegisterLevelStreamingFixers(NewWorld, InstanceId);
+
+	return NewWorld;
+}
+
+void FInstanceWorld::RegisterLevelStreamingFixers(UWorld* InWorld, int32 InstanceId)
+{
 	// Register LevelStreamingFixers (Will fixup the sub-level references one the levels are loaded/shown)
-	for (ULevelStreaming* LevelStreaming : World->GetStreamingLevels())
+	for (ULevelStreaming* LevelStreaming : InWorld->GetStreamingLevels())
 	{
 		if (UInstanceWorldLevelStreamingFixer* LevelStreamingFixer = NewObject<UInstanceWorldLevelStreamingFixer>(LevelStreaming))
 			LevelStreamingFixer->SetStreamingLevel(LevelStreaming, InstanceId);
 	}
-
-	return World;
 }
 
 UWorld* FInstanceWorld::CreateEmptyWorld(int32 InstanceId)
@@ -453,239 +1622,338 @@ void FInstanceWorld::RemoveComponentFromWorld(UActorComponent* Component)
 }
 
 void FInstanceWorld::InitWorld(UWorld* InWorld, bool bWorldLoadedFromPackage, const ConstructionValues& CVS)
+{
+	FInitWorldStats Stats;
+	for (int32 Stage = 0; Stage < (int32)EInitWorldStage::Num; ++Stage)
+	{
+		InitWorldStage(InWorld, bWorldLoadedFromPackage, CVS, (EInitWorldStage)Stage, Stats);
+	}
+}
+
+void FInstanceWorld::InitWorldStage(UWorld* InWorld, bool bWorldLoadedFromPackage, const ConstructionValues& CVS, EInitWorldStage Stage, FInitWorldStats& Stats)
 {
 	// Mimics the initialization that ocurs in UEngine::LoadMap with some modifications made to make it work with non-game worlds.
+	// The initialization is split into stages so time-sliced construction can run them in separate frames, the stages must be run in order.
+
+	const FActorPortraitPhaseContext PhaseContext(CVS.WorldAsset.ToSoftObjectPath(), CVS.ProfilingActorClass.Get());
 
-	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::GamePreview);
-	WorldContext.SetCurrentWorld(InWorld);
+	const double StartTime = FPlatformTime::Seconds();
+	const uint64 StartMemory = FPlatformMemory::GetStats().UsedPhysical;
 
 	FURL URL;
 	if (bWorldLoadedFromPackage)
 	{
 		URL.Map = InWorld->GetOutermost()->GetName();
 	}
-	WorldContext.LastURL = URL;
 
-	if (!WorldContext.World()->bIsWorldInitialized)
+	switch (Stage)
 	{
-		UWorld::InitializationValues IVS = UWorld::InitializationValues()
-			.InitializeScenes(true)
-			.AllowAudioPlayback(CVS.bAllowAudioPlayback)
-			.RequiresHitProxies(false) // Only Need hit proxies in an editor scene
-			.CreatePhysicsScene(CVS.bCreatePhysicsScene)
-			.CreateNavigation(false)
-			.CreateAISystem(false)
-			.ShouldSimulatePhysics(CVS.bShouldSimulatePhysics)
-			.EnableTraceCollision(false)
-			.CreateFXSystem(CVS.bCreateFXSystem);
+	case EInitWorldStage::InitializeWorld:
+	{
+		ACTOR_PORTRAIT_PHASE_SCOPE(InitWorld, PhaseContext);
 
-		if (bWorldLoadedFromPackage)
+		FWorldContext& WorldContext = InstanceWorldContexts::CreateWorldContext(InWorld, CVS.bUseEngineWorldContext);
+		WorldContext.SetCurrentWorld(InWorld);
+
+		WorldContext.LastURL = URL;
+
+		if (!WorldContext.World()->bIsWorldInitialized)
 		{
-			WorldContext.World()->InitWorld(IVS);
+			UWorld::InitializationValues IVS = UWorld::InitializationValues()
+				.InitializeScenes(true)
+				.AllowAudioPlayback(CVS.bAllowAudioPlayback)
+				.RequiresHitProxies(false) // Only Need hit proxies in an editor scene
+				.CreatePhysicsScene(CVS.bCreatePhysicsScene)
+				.CreateNavigation(false)
+				.CreateAISystem(false)
+				.ShouldSimulatePhysics(CVS.bShouldSimulatePhysics)
+				.EnableTraceCollision(false)
+				.CreateFXSystem(CVS.bCreateFXSystem);
+
+			if (bWorldLoadedFromPackage)
+			{
+				WorldContext.World()->InitWorld(IVS);
+			}
+			else
+			{
+				WorldContext.World()->InitializeNewWorld(IVS);
+			}
 		}
-		else
+
+		if (CVS.OwningGameInstance != nullptr)
 		{
-			WorldContext.World()->InitializeNewWorld(IVS);
+			InWorld->SetGameInstance(CVS.OwningGameInstance);
+			WorldContext.OwningGameInstance = CVS.OwningGameInstance;
 		}
-	}
-
-	if (CVS.OwningGameInstance != nullptr)
-	{
-		InWorld->SetGameInstance(CVS.OwningGameInstance);
-		WorldContext.OwningGameInstance = CVS.OwningGameInstance;
-	}
 
-	if (FAudioDevice* AudioDevice = WorldContext.World()->GetAudioDeviceRaw())
-	{
-		AudioDevice->SetDefaultBaseSoundMix(WorldContext.World()->GetWorldSettings()->DefaultBaseSoundMix);
-	}
+		if (FAudioDevice* AudioDevice = WorldContext.World()->GetAudioDeviceRaw())
+		{
+			AudioDevice->SetDefaultBaseSoundMix(WorldContext.World()->GetWorldSettings()->DefaultBaseSoundMix);
+		}
 
-	if (bWorldLoadedFromPackage)
-	{
-		const TCHAR* MutatorString = URL.GetOption(TEXT("Mutator="), TEXT(""));
-		if (MutatorString)
+		if (bWorldLoadedFromPackage)
 		{
-			TArray<FString> Mutators;
-			FString(MutatorString).ParseIntoArray(Mutators, TEXT(","), true);
+			// UEngine::LoadPackagesFully looks the world context up in the engine's world list. A private world context is freshly created and
+			// has no packages to fully load registered, so there is nothing for it to load.
+			const bool bLoadPackagesFully = CVS.bUseEngineWorldContext;
+
+			const TCHAR* MutatorString = URL.GetOption(TEXT("Mutator="), TEXT(""));
+			if (MutatorString && bLoadPackagesFully)
+			{
+				TArray<FString> Mutators;
+				FString(MutatorString).ParseIntoArray(Mutators, TEXT(","), true);
+
+				for (int32 MutatorIndex = 0; MutatorIndex < Mutators.Num(); MutatorIndex++)
+				{
+					GEngine->LoadPackagesFully(WorldContext.World(), FULLYLOAD_Mutator, Mutators[MutatorIndex]);
+				}
+			}
 
-			for (int32 MutatorIndex = 0; MutatorIndex < Mutators.Num(); MutatorIndex++)
+			// Process global shader results before we try to render anything
+			// Do this before we register components, as USkinnedMeshComponents require the GPU skin cache global shaders when creating render state.
+			if (GShaderCompilingManager)
 			{
-				GEngine->LoadPackagesFully(WorldContext.World(), FULLYLOAD_Mutator, Mutators[MutatorIndex]);
+				GShaderCompilingManager->ProcessAsyncResults(false, true);
+			}
+
+			{
+				QUICK_SCOPE_CYCLE_COUNTER(STAT_LoadInstanceMap_LoadPackagesFully);
+
+				// load any per-map packages
+				check(WorldContext.World()->PersistentLevel);
+				if (bLoadPackagesFully)
+				{
+					GEngine->LoadPackagesFully(WorldContext.World(), FULLYLOAD_Map, WorldContext.World()->PersistentLevel->GetOutermost()->GetName());
+				}
+
+				// NOTE: Flushing the level streaming here froze the game in shipping. "Always loaded" sub-levels are instead streamed in 
+				// asynchronously, SActorPortrait holds off capturing until FActorPortraitScene::UpdateStreamingLevels reports them ready.
+				//WorldContext.World()->FlushLevelStreaming(EFlushLevelStreamingType::Visibility);
+
+				if (!GIsEditor && !IsRunningDedicatedServer())
+				{
+					// If requested, duplicate dynamic levels here after the source levels are created.
+					WorldContext.World()->DuplicateRequestedLevels(FName(*URL.Map));
+				}
 			}
 		}
 
-		// Process global shader results before we try to render anything
-		// Do this before we register components, as USkinnedMeshComponents require the GPU skin cache global shaders when creating render state.
-		if (GShaderCompilingManager)
+		// Note that AI system will be created only if ai-system-creation conditions are met
+		if (CVS.bCreateAISystem)
 		{
-			GShaderCompilingManager->ProcessAsyncResults(false, true);
+			WorldContext.World()->CreateAISystem();
 		}
+		break;
+	}
 
-		{
-			QUICK_SCOPE_CYCLE_COUNTER(STAT_LoadInstanceMap_LoadPackagesFully);
+	case EInitWorldStage::InitializeActorsForPlay:
+	{
+		FWorldContext& WorldContext = InstanceWorldContexts::GetWorldContextChecked(InWorld);
 
-			// load any per-map packages
-			check(WorldContext.World()->PersistentLevel);
-			GEngine->LoadPackagesFully(WorldContext.World(), FULLYLOAD_Map, WorldContext.World()->PersistentLevel->GetOutermost()->GetName());
+		// Initialize gameplay for the level.
+		{
+			ACTOR_PORTRAIT_PHASE_SCOPE(InitializeActorsForPlay, PhaseContext);
 
-			// TODO: Causing the game to freeze in shipping
-			// Make sure "always loaded" sub-levels are fully loaded
-			//WorldContext.World()->FlushLevelStreaming(EFlushLevelStreamingType::Visibility);
+			if (CVarBatchComponentRegistration.GetValueOnGameThread())
+			{
+				// Collects all the Scene->AddPrimitive calls made while registering the level components and executes them in one batch,
+				// creating the scene proxies in parallel.
+				FRegisterComponentContext Context(WorldContext.World());
+				WorldContext.World()->InitializeActorsForPlay(URL, true, &Context);
 
-			if (!GIsEditor && !IsRunningDedicatedServer())
+				QUICK_SCOPE_CYCLE_COUNTER(STAT_InstanceWorld_ProcessRegisterComponentContext);
+				Context.Process();
+			}
+			else
 			{
-				// If requested, duplicate dynamic levels here after the source levels are created.
-				WorldContext.World()->DuplicateRequestedLevels(FName(*URL.Map));
+				WorldContext.World()->InitializeActorsForPlay(URL, true, nullptr);
 			}
 		}
-	}
 
-	// Note that AI system will be created only if ai-system-creation conditions are met
-	WorldContext.World()->CreateAISystem();
+		// calling it after InitializeActorsForPlay has been called to have all potential bounding boxed initialized
+		if (CVS.bCreateNavigation)
+		{
+			FNavigationSystem::AddNavigationSystemToWorld(*WorldContext.World(), FNavigationSystemRunMode::GameMode);
+		}
+		break;
+	}
 
-	// Initialize gameplay for the level.
+	case EInitWorldStage::BeginPlay:
 	{
-		// NOTE: We cannot use the FRegisterComponentContext since the Process function is not exposed.
-		// The only thing FRegisterComponentContext does is to batch all the Scene->AddPrimitive calls and then executs them in parallel.
-		// This could perhaps be a nice optimization but we need to figure out how to call FRegisterComponentContext::Process.
-		//FRegisterComponentContext Context(WorldContext.World());
-		//WorldContext.World()->InitializeActorsForPlay(URL, true, &Context);
-		//Context.Process();
+		FWorldContext& WorldContext = InstanceWorldContexts::GetWorldContextChecked(InWorld);
 
-		WorldContext.World()->InitializeActorsForPlay(URL, true, nullptr);
-	}
-
-	// calling it after InitializeActorsForPlay has been called to have all potential bounding boxed initialized
-	FNavigationSystem::AddNavigationSystemToWorld(*WorldContext.World(), FNavigationSystemRunMode::GameMode);
+		// Remember the URL. Put this before spawning player controllers so that
+		// a player controller can get the map name during initialization and
+		// have it be correct
+		WorldContext.LastURL = URL;
+		WorldContext.LastURL.Map = URL.Map;
+		WorldContext.LastRemoteURL = URL;
 
-	// Remember the URL. Put this before spawning player controllers so that
-	// a player controller can get the map name during initialization and
-	// have it be correct
-	WorldContext.LastURL = URL;
-	WorldContext.LastURL.Map = URL.Map;
-	WorldContext.LastRemoteURL = URL;
+		{
+			ACTOR_PORTRAIT_PHASE_SCOPE(BeginPlay, PhaseContext);
 
-	WorldContext.World()->BeginPlay();
+			WorldContext.World()->BeginPlay();
 
-	// Copy from AWorldSettings::NotifyBeginPlay
-	{
-		if (!WorldContext.World()->GetBegunPlay())
-		{
-			for (FActorIterator It(WorldContext.World()); It; ++It)
+			// Copy from AWorldSettings::NotifyBeginPlay
+			if (!WorldContext.World()->GetBegunPlay())
 			{
-				It->DispatchBeginPlay(bWorldLoadedFromPackage);
+				for (FActorIterator It(WorldContext.World()); It; ++It)
+				{
+					It->DispatchBeginPlay(bWorldLoadedFromPackage);
+				}
+
+				WorldContext.World()->SetBegunPlay(true);
 			}
+		}
+
+		if (bWorldLoadedFromPackage)
+		{
+			WorldContext.World()->bWorldWasLoadedThisTick = true;
 
-			WorldContext.World()->SetBegunPlay(true);
+			ACTOR_PORTRAIT_PHASE_SCOPE(SkyRecapture, PhaseContext);
+			WorldContext.World()->UpdateAllSkyCaptures();
 		}
+	
+		WorldContext.World()->SetShouldTick(CVS.bShouldTickWorld);
+		break;
 	}
 
-	if (bWorldLoadedFromPackage)
+	default:
+		checkNoEntry();
+		break;
+	}
+
+	Stats.Time   += FPlatformTime::Seconds() - StartTime;
+	Stats.Memory += (int64)FPlatformMemory::GetStats().UsedPhysical - (int64)StartMemory;
+
+	if (Stage == EInitWorldStage::BeginPlay)
 	{
-		WorldContext.World()->bWorldWasLoadedThisTick = true;
-		WorldContext.World()->UpdateAllSkyCaptures();
+		FInstanceWorldHelpers::ReportWorldCreation(InWorld, CVS, Stats.Time, Stats.Memory);
+
+		// TODO: Does it make sense to call this?
+		// WorldContext.OwningGameInstance->LoadComplete(StopTime - StartTime, *URL.Map);
 	}
-	
-	WorldContext.World()->SetShouldTick(CVS.bShouldTickWorld);
+}
 
-	// TODO: Does it make sense to call this?
-	// WorldContext.OwningGameInstance->LoadComplete(StopTime - StartTime, *URL.Map);
+void FInstanceWorld::CleanupWorld(TObjectPtr<UWorld>& InWorld, bool bWorldLoadedFromPackage, const ConstructionValues& CVS)
+{
+	for (int32 Stage = (int32)ETeardownStage::BeginTearingDown; Stage < (int32)ETeardownStage::Done; ++Stage)
+	{
+		CleanupWorldStage(InWorld, bWorldLoadedFromPackage, CVS, (ETeardownStage)Stage);
+	}
 }
 
-void FInstanceWorld::CleanupWorld(TObjectPtr<UWorld>& InWorld, bool bWorldLoadedFromPackage)
+void FInstanceWorld::CleanupWorldStage(TObjectPtr<UWorld>& InWorld, bool bWorldLoadedFromPackage, const ConstructionValues& CVS, ETeardownStage Stage)
 {
 	// Mimics the cleanup that ocurs in UEngine::LoadMap with some modifications made to make it work with non-game worlds.
+	// The cleanup is split into stages so deferred teardown can run them in separate frames, the stages must be run in order.
 	
 	if (!GEngine || !IsValid(InWorld))
 	{
 		return;
 	}
 
-	FWorldContext& WorldContext = GEngine->GetWorldContextFromWorldChecked(InWorld);
+	ACTOR_PORTRAIT_PHASE_SCOPE(CleanupWorld, FActorPortraitPhaseContext(CVS.WorldAsset.ToSoftObjectPath(), CVS.ProfilingActorClass.Get()));
 
-	if (bWorldLoadedFromPackage)
+	FWorldContext& WorldContext = InstanceWorldContexts::GetWorldContextChecked(InWorld);
+
+	switch (Stage)
+	{
+	case ETeardownStage::BeginTearingDown:
 	{
-		// clean up any per-map loaded packages for the map we are leaving
-		if (WorldContext.World() && WorldContext.World()->PersistentLevel)
+		if (bWorldLoadedFromPackage)
 		{
-			GEngine->CleanupPackagesToFullyLoad(WorldContext, FULLYLOAD_Map, WorldContext.World()->PersistentLevel->GetOutermost()->GetName());
-		}
-
-		// cleanup the existing per-game pacakges
-		// @todo: It should be possible to not unload/load packages if we are going from/to the same GameMode.
-		//        would have to save the game pathname here and pass it in to SetGameMode below
-		GEngine->CleanupPackagesToFullyLoad(WorldContext, FULLYLOAD_Game_PreLoadClass, TEXT(""));
-		GEngine->CleanupPackagesToFullyLoad(WorldContext, FULLYLOAD_Game_PostLoadClass, TEXT(""));
-		GEngine->CleanupPackagesToFullyLoad(WorldContext, FULLYLOAD_Mutator, TEXT(""));
-	}
+			// clean up any per-map loaded packages for the map we are leaving
+			if (WorldContext.World() && WorldContext.World()->PersistentLevel)
+			{
+				GEngine->CleanupPackagesToFullyLoad(WorldContext, FULLYLOAD_Map, WorldContext.World()->PersistentLevel->GetOutermost()->GetName());
+			}
 
-	WorldContext.World()->BeginTearingDown();
+			// cleanup the existing per-game pacakges
+			// @todo: It should be possible to not unload/load packages if we are going from/to the same GameMode.
+			//        would have to save the game pathname here and pass it in to SetGameMode below
+			GEngine->CleanupPackagesToFullyLoad(WorldContext, FULLYLOAD_Game_PreLoadClass, TEXT(""));
+			GEngine->CleanupPackagesToFullyLoad(WorldContext, FULLYLOAD_Game_PostLoadClass, TEXT(""));
+			GEngine->CleanupPackagesToFullyLoad(WorldContext, FULLYLOAD_Mutator, TEXT(""));
+		}
 
-	// Make sure there are no pending visibility requests.
-	WorldContext.World()->bIsLevelStreamingFrozen = false;
-	WorldContext.World()->SetShouldForceUnloadStreamingLevels(true);
-	WorldContext.World()->FlushLevelStreaming();
+		WorldContext.World()->BeginTearingDown();
 
-	for (FActorIterator ActorIt(WorldContext.World()); ActorIt; ++ActorIt)
-	{
-		ActorIt->RouteEndPlay(EEndPlayReason::RemovedFromWorld);
+		// Make sure there are no pending visibility requests.
+		WorldContext.World()->bIsLevelStreamingFrozen = false;
+		WorldContext.World()->SetShouldForceUnloadStreamingLevels(true);
+		WorldContext.World()->FlushLevelStreaming();
+		break;
 	}
 
-	// Do this after destroying pawns/playercontrollers, in case that spawns new things (e.g. dropped weapons)
-	WorldContext.World()->DestroyWorld(true);
-
-	// Stop all audio to remove references to current level.
-	if (FAudioDevice* AudioDevice = WorldContext.World()->GetAudioDeviceRaw())
+	case ETeardownStage::EndPlay:
 	{
-		AudioDevice->Flush(WorldContext.World());
-		AudioDevice->SetTransientPrimaryVolume(1.0f);
+		for (FActorIterator ActorIt(WorldContext.World()); ActorIt; ++ActorIt)
+		{
+			ActorIt->RouteEndPlay(EEndPlayReason::RemovedFromWorld);
+		}
+		break;
 	}
 
-	if (bWorldLoadedFromPackage)
+	case ETeardownStage::DestroyWorld:
 	{
-		// Delete the instance world package if we've created one. This will delete all sub-objects of this package, including the world.
-		FInstanceWorldHelpers::DeleteInstanceWorldPackage(WorldContext.World()->GetOutermost());
-	}
+		// Do this after destroying pawns/playercontrollers, in case that spawns new things (e.g. dropped weapons)
+		WorldContext.World()->DestroyWorld(true);
 
-	// Make sure we're cleaning up all the sub-/streaming levels
-	{
-		// If the world is not part of a package, mark everything else contained in the world to be deleted
-		for (auto LevelIt(WorldContext.World()->GetLevelIterator()); LevelIt; ++LevelIt)
+		// Stop all audio to remove references to current level.
+		if (FAudioDevice* AudioDevice = WorldContext.World()->GetAudioDeviceRaw())
 		{
-			const ULevel* Level = *LevelIt;
-			if (Level)
-			{
-				CastChecked<UWorld>(Level->GetOuter())->MarkObjectsPendingKill();
-			}
+			AudioDevice->Flush(WorldContext.World());
+			AudioDevice->SetTransientPrimaryVolume(1.0f);
+		}
+
+		if (bWorldLoadedFromPackage)
+		{
+			// Delete the instance world package if we've created one. This will delete all sub-objects of this package, including the world.
+			FInstanceWorldHelpers::DeleteInstanceWorldPackage(WorldContext.World()->GetOutermost());
 		}
 
-		for (ULevelStreaming* LevelStreaming : WorldContext.World()->GetStreamingLevels())
+		// Make sure we're cleaning up all the sub-/streaming levels
 		{
-			// If an unloaded levelstreaming still has a loaded level we need to mark its objects to be deleted as well
-			if (LevelStreaming->GetLoadedLevel() && (!LevelStreaming->ShouldBeLoaded() || !LevelStreaming->ShouldBeVisible()))
+			// If the world is not part of a package, mark everything else contained in the world to be deleted
+			for (auto LevelIt(WorldContext.World()->GetLevelIterator()); LevelIt; ++LevelIt)
 			{
-				CastChecked<UWorld>(LevelStreaming->GetLoadedLevel()->GetOuter())->MarkObjectsPendingKill();
+				const ULevel* Level = *LevelIt;
+				if (Level)
+				{
+					CastChecked<UWorld>(Level->GetOuter())->MarkObjectsPendingKill();
+				}
 			}
-		}
 
-		WorldContext.World()->MarkAsGarbage();
-	}
+			for (ULevelStreaming* LevelStreaming : WorldContext.World()->GetStreamingLevels())
+			{
+				// If an unloaded levelstreaming still has a loaded level we need to mark its objects to be deleted as well
+				if (LevelStreaming->GetLoadedLevel() && (!LevelStreaming->ShouldBeLoaded() || !LevelStreaming->ShouldBeVisible()))
+				{
+					CastChecked<UWorld>(LevelStreaming->GetLoadedLevel()->GetOuter())->MarkObjectsPendingKill();
+				}
+			}
+
+			WorldContext.World()->MarkAsGarbage();
+		}
 	
-	GEngine->DestroyWorldContext(InWorld);
+		InstanceWorldContexts::DestroyWorldContext(InWorld);
 
-	InWorld = nullptr;
+		InWorld = nullptr;
 
-	// Need to collect garbage to delete the old world so we don't accidentally create a new world with the same name as the one we juat destroyed,
-	// because if it's still around by then the engine will assert.
-	if (!IsGarbageCollecting() && !FActorPortraitModule::IsShuttingDown() && !FActorPortraitModule::IsEndingPlay())
-	{
-		CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS, false);
+		// Instance ids are recycled, but only once every package of the previous instance has been purged by the garbage collector, so a new world
+		// can't collide with one that is still waiting to be collected. Instead of forcing a full GC for every destroyed world we just request one,
+		// multiple requests made during the same frame are coalesced by the engine into a single collection (see InstanceWorldGarbageCollectionTest).
+		if (!FActorPortraitModule::IsShuttingDown() && !FActorPortraitModule::IsEndingPlay())
+		{
+			GEngine->ForceGarbageCollection(false);
+		}
+		// GEngine->TrimMemory(); // TODO: Should we also clear render resources for this world by calling GEngine->TrimMemory instead?
+		break;
 	}
-	// GEngine->TrimMemory(); // TODO: Should we also clear render resources for this world by calling GEngine->TrimMemory instead?
-}
 
-int32 FInstanceWorld::GenerateUniqueInstanceWorldId()
-{
-	static int32 StaticInstanceId = 0;
-	return ++StaticInstanceId;
+	default:
+		checkNoEntry();
+		break;
+	}
 }
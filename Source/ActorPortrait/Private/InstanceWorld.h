@@ -34,8 +34,34 @@ private:
 	TObjectPtr<UWorld> World = nullptr;
 	int32 InstanceId = 0;
 	bool bWorldWasLoadedFromPackage = false;
+	bool bIsLoading = false;
 	TArray<TObjectPtr<UActorComponent>> Components;
 
+	// Kept alive for as long as this instance world is interested in the result of its async load request
+	TSharedPtr<bool> LoadRequestToken;
+
+	// Key of the world template this world was duplicated from, NAME_None if the world was not created from a template
+	FName TemplateKey = NAME_None;
+
+	// True while a (non-template) world package is being loaded asynchronously for this instance world
+	bool bIsLoadingPackage = false;
+
+	enum class ETeardownStage : uint8
+	{
+		DestroyComponents,
+		BeginTearingDown,
+		EndPlay,
+		DestroyWorld,
+		Done
+	};
+
+	// Next stage to run when tearing down the world
+	ETeardownStage TeardownStage = ETeardownStage::DestroyComponents;
+
+	// World which is being initialized by time-sliced construction, moved to World once all the stages have run
+	TObjectPtr<UWorld> ConstructingWorld = nullptr;
+	bool bConstructingWorldInitialized = false;
+
 public:
 	struct ConstructionValues
 	{
@@ -45,6 +71,11 @@ public:
 			, bShouldSimulatePhysics(false)
 			, bShouldTickWorld(true)
 			, bCreateFXSystem(true)
+			, bCreateAISystem(true)
+			, bCreateNavigation(true)
+			, bLoadAsync(false)
+			, bUseEngineWorldContext(true)
+			, bTimeSliceConstruction(false)
 		{
 		}
 
@@ -53,21 +84,63 @@ public:
 		uint32 bShouldSimulatePhysics:1;
 		uint32 bShouldTickWorld:1;
 		uint32 bCreateFXSystem:1;
+		uint32 bCreateAISystem:1;
+		uint32 bCreateNavigation:1;
+		uint32 bLoadAsync:1;
+
+		// When false the world is not registered as an engine world context, the engine won't iterate or tick it and the owner is responsible for ticking it
+		uint32 bUseEngineWorldContext:1;
+
+		// Whether to spread the construction of the world over several frames using FActorPortraitConstructionQueue, the world is reported as loading until it has finished
+		uint32 bTimeSliceConstruction:1;
 
 		TSubclassOf<class AGameModeBase> DefaultGameMode;
 		class UGameInstance* OwningGameInstance = nullptr;
 
 		TSoftObjectPtr<UWorld> WorldAsset;
 
+		// Class of the actor the world is created for, only used to tag profiling data and ignored when comparing construction values
+		TWeakObjectPtr<UClass> ProfilingActorClass;
+
 		ConstructionValues& AllowAudioPlayback(const bool bAllow) { bAllowAudioPlayback = bAllow; return *this; }
 		ConstructionValues& SetCreatePhysicsScene(const bool bCreate) { bCreatePhysicsScene = bCreate; return *this; }
 		ConstructionValues& ShouldSimulatePhysics(const bool bInShouldSimulatePhysics) { bShouldSimulatePhysics = bInShouldSimulatePhysics; return *this; }
 		ConstructionValues& SetShouldTickWorld(const bool bInShouldTickWorld) { bShouldTickWorld = bInShouldTickWorld; return *this; }
 		ConstructionValues& SetCreateFXSystem(const bool bInCreateFXSystem) { bCreateFXSystem = bInCreateFXSystem; return *this; }
+		ConstructionValues& SetCreateAISystem(const bool bInCreateAISystem) { bCreateAISystem = bInCreateAISystem; return *this; }
+		ConstructionValues& SetCreateNavigation(const bool bInCreateNavigation) { bCreateNavigation = bInCreateNavigation; return *this; }
+		ConstructionValues& SetLoadAsync(const bool bInLoadAsync) { bLoadAsync = bInLoadAsync; return *this; }
+		ConstructionValues& SetUseEngineWorldContext(const bool bInUseEngineWorldContext) { bUseEngineWorldContext = bInUseEngineWorldContext; return *this; }
+		ConstructionValues& SetTimeSliceConstruction(const bool bInTimeSliceConstruction) { bTimeSliceConstruction = bInTimeSliceConstruction; return *this; }
 
 		ConstructionValues& SetDefaultGameMode(TSubclassOf<class AGameModeBase> GameMode) { DefaultGameMode = GameMode; return *this; }
 		ConstructionValues& SetOwningGameInstance(class UGameInstance* InGameInstance) { OwningGameInstance = InGameInstance; return *this; }
 		ConstructionValues& SetWorldAsset(TSoftObjectPtr<UWorld> InWorldAsset) { WorldAsset = InWorldAsset; return *this; }
+		ConstructionValues& SetProfilingActorClass(UClass* InActorClass) { ProfilingActorClass = InActorClass; return *this; }
+
+		// Two worlds created with equal construction values are interchangeable. bShouldTickWorld, bLoadAsync, bTimeSliceConstruction and ProfilingActorClass are ignored since they don't affect the created world.
+		friend bool operator==(const ConstructionValues& A, const ConstructionValues& B)
+		{
+			return A.bAllowAudioPlayback == B.bAllowAudioPlayback
+				&& A.bCreatePhysicsScene == B.bCreatePhysicsScene
+				&& A.bShouldSimulatePhysics == B.bShouldSimulatePhysics
+				&& A.bCreateFXSystem == B.bCreateFXSystem
+				&& A.bCreateAISystem == B.bCreateAISystem
+				&& A.bCreateNavigation == B.bCreateNavigation
+				&& A.bUseEngineWorldContext == B.bUseEngineWorldContext
+				&& A.DefaultGameMode == B.DefaultGameMode
+				&& A.OwningGameInstance == B.OwningGameInstance
+				&& A.WorldAsset == B.WorldAsset;
+		}
+
+		friend uint32 GetTypeHash(const ConstructionValues& CVS)
+		{
+			const uint32 Flags = (CVS.bAllowAudioPlayback << 0) | (CVS.bCreatePhysicsScene << 1) | (CVS.bShouldSimulatePhysics << 2) | (CVS.bCreateFXSystem << 3) | (CVS.bCreateAISystem << 4) | (CVS.bCreateNavigation << 5) | (CVS.bUseEngineWorldContext << 6);
+			uint32 Hash = GetTypeHash(CVS.WorldAsset.ToSoftObjectPath());
+			Hash = HashCombine(Hash, GetTypeHash(CVS.DefaultGameMode.Get()));
+			Hash = HashCombine(Hash, GetTypeHash(CVS.OwningGameInstance));
+			return HashCombine(Hash, Flags);
+		}
 	};
 
 	FInstanceWorld(const ConstructionValues& CVS = ConstructionValues());
@@ -82,19 +155,75 @@ public:
 
 	FORCEINLINE FSceneInterface* GetScene() const { return World ? World->Scene : nullptr; }
 
+	FORCEINLINE const ConstructionValues& GetConstructionValues() const { return WorldConstructionValues; }
+
+	// The actor class the world is reported with by the phase timings, updated when a pooled world is re-used for another actor class
+	FORCEINLINE void SetProfilingActorClass(UClass* InActorClass) { WorldConstructionValues.ProfilingActorClass = InActorClass; }
+
+	// True while the world package is being loaded asynchronously or the world is being constructed over several frames, GetWorld will return nullptr until loading has completed
+	FORCEINLINE bool IsLoading() const { return bIsLoading; }
+
+	// True once every streaming level which should be loaded has finished loading, and is visible if it should be visible
+	bool AreStreamingLevelsReady() const;
+
+	// Runs the next stage of tearing down the world, returns true once the world has been completely torn down. Stages which haven't been run
+	// when the instance world is destroyed are run by the destructor, so teardown can be spread over several frames before releasing the instance world.
+	bool TeardownNextStage();
+
+	FORCEINLINE bool IsTearingDown() const { return TeardownStage != ETeardownStage::DestroyComponents; }
+
 	virtual void AddComponentToWorld(class UActorComponent* Component);
 
 	virtual void RemoveComponentFromWorld(class UActorComponent* Component);
 
+	// Destroys the background world templates which are kept loaded while no instance world is using them
+	static void FlushUnusedWorldTemplates();
+
+protected:
+
+	// Called once an asynchronously loaded world has finished loading and has been initialized, GetWorld returns nullptr if loading failed
+	virtual void OnWorldLoaded() {}
+
+	// Called before the first teardown stage, while the world is still intact
+	virtual void OnBeginTeardown() {}
+
 private:
 
-	static UWorld* CreateWorldFromAsset(const FSoftObjectPath& InWorldAssetPath, int32 InstanceId);
+	ConstructionValues WorldConstructionValues;
+
+	enum class EInitWorldStage : uint8
+	{
+		InitializeWorld,
+		InitializeActorsForPlay,
+		BeginPlay,
+		Num
+	};
+
+	// Cost of initializing a world, summed over its stages
+	struct FInitWorldStats
+	{
+		double Time = 0.0;
+		int64 Memory = 0;
+	};
+
+	FInitWorldStats ConstructingWorldStats;
+
+	void FinishAsyncWorldLoad(UWorld* LoadedWorld, double StartTime);
+
+	// Queues the initialization stages of the created world, the world is made available once the last stage has run
+	void QueueTimeSlicedInitWorld(UWorld* CreatedWorld, double StartTime);
+
+	UWorld* CreateWorldFromAsset(const FSoftObjectPath& InWorldAssetPath, bool bUseWorldTemplate);
+
+	static void RegisterLevelStreamingFixers(UWorld* InWorld, int32 InstanceId);
 
 	static UWorld* CreateEmptyWorld(int32 InstanceId);
 
 	static void InitWorld(UWorld* InWorld, bool bWorldLoadedFromPackage, const ConstructionValues& CVS);
 
-	static void CleanupWorld(TObjectPtr<UWorld>& InWorld, bool bWorldLoadedFromPackage);
+	static void InitWorldStage(UWorld* InWorld, bool bWorldLoadedFromPackage, const ConstructionValues& CVS, EInitWorldStage Stage, FInitWorldStats& Stats);
+
+	static void CleanupWorld(TObjectPtr<UWorld>& InWorld, bool bWorldLoadedFromPackage, const ConstructionValues& CVS);
 
-	static int32 GenerateUniqueInstanceWorldId();
+	static void CleanupWorldStage(TObjectPtr<UWorld>& InWorld, bool bWorldLoadedFromPackage, const ConstructionValues& CVS, ETeardownStage Stage);
 };
\ No newline at end of file
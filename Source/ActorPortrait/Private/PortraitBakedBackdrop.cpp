@@ -0,0 +1,96 @@
+// Copyright Mans Isaksson. All Rights Reserved.
+
+#include "PortraitBakedBackdrop.h"
+#include "ActorPortraitModule.h"
+#include "InstanceWorld.h"
+
+#include "Engine/TextureCube.h"
+
+#if WITH_EDITOR
+#include "Components/SceneCaptureComponentCube.h"
+#include "Engine/TextureRenderTargetCube.h"
+#include "ContentStreaming.h"
+#include "ShaderCompiler.h"
+#include "RenderingThread.h"
+#include "UObject/Package.h"
+#endif
+
+#if WITH_EDITOR
+bool UPortraitBakedBackdrop::BakeBackdrop()
+{
+	if (SourceWorld.IsNull())
+	{
+		UE_LOG(LogActorPortrait, Warning, TEXT("Can't bake backdrop %s, it has no source world"), *GetPathName());
+		return false;
+	}
+
+	// The world is only rendered once, it doesn't need anything but a scene
+	FInstanceWorld BakeWorld(FInstanceWorld::ConstructionValues()
+		.SetWorldAsset(SourceWorld)
+		.SetCreatePhysicsScene(false)
+		.SetCreateAISystem(false)
+		.SetCreateNavigation(false)
+		.SetShouldTickWorld(false));
+
+	UWorld* World = BakeWorld.GetWorld();
+	if (!IsValid(World))
+	{
+		UE_LOG(LogActorPortrait, Warning, TEXT("Can't bake backdrop %s, failed to load %s"), *GetPathName(), *SourceWorld.ToString());
+		return false;
+	}
+
+	World->FlushLevelStreaming(EFlushLevelStreamingType::Full);
+
+	UTextureRenderTargetCube* RenderTarget = NewObject<UTextureRenderTargetCube>(GetTransientPackage(), NAME_None, RF_Transient);
+	RenderTarget->Init(Resolution, PF_FloatRGBA);
+	RenderTarget->UpdateResourceImmediate(true);
+
+	USceneCaptureComponentCube* CaptureComponent = NewObject<USceneCaptureComponentCube>(GetTransientPackage(), NAME_None, RF_Transient);
+	CaptureComponent->bCaptureEveryFrame = false;
+	CaptureComponent->bCaptureOnMovement = false;
+	CaptureComponent->TextureTarget      = RenderTarget;
+	CaptureComponent->SetRelativeLocation(CaptureLocation);
+	BakeWorld.AddComponentToWorld(CaptureComponent);
+
+	// Make sure the capture sees the final materials and fully streamed textures
+	if (GShaderCompilingManager)
+	{
+		GShaderCompilingManager->FinishAllCompilation();
+	}
+	IStreamingManager::Get().StreamAllResources(0.f);
+
+	CaptureComponent->CaptureScene();
+	FlushRenderingCommands();
+
+	const FString CubeMapName = GetName() + TEXT("_CubeMap");
+
+	// Move the previous bake out of the way so the new cube map can take its name
+	if (UTextureCube* PreviousCubeMap = FindObject<UTextureCube>(this, *CubeMapName))
+	{
+		PreviousCubeMap->Rename(nullptr, GetTransientPackage(), REN_DontCreateRedirectors | REN_NonTransactional);
+		PreviousCubeMap->MarkAsGarbage();
+	}
+
+	Modify();
+	CubeMap = RenderTarget->ConstructTextureCube(this, CubeMapName, RF_Public);
+
+	BakeWorld.RemoveComponentFromWorld(CaptureComponent);
+	RenderTarget->ReleaseResource();
+
+	if (!IsValid(CubeMap))
+	{
+		UE_LOG(LogActorPortrait, Warning, TEXT("Failed to create the cube map of backdrop %s"), *GetPathName());
+		return false;
+	}
+
+	MarkPackageDirty();
+
+	UE_LOG(LogActorPortrait, Display, TEXT("Baked %s into backdrop %s (%dx%d per face)"), *SourceWorld.ToString(), *GetPathName(), Resolution, Resolution);
+	return true;
+}
+
+void UPortraitBakedBackdrop::Bake()
+{
+	BakeBackdrop();
+}
+#endif
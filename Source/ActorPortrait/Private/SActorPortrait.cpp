@@ -4,6 +4,13 @@
 #include "ActorPortraitModule.h"
 #include "ActorPortraitInterface.h"
 #include "ActorPortraitScene.h"
+#include "ActorPortraitScenePool.h"
+#include "ActorPortraitProjectSettings.h"
+#include "ActorPortraitStats.h"
+#include "ActorPortraitConstructionQueue.h"
+#include "ActorPortraitCaptureScheduler.h"
+#include "ActorPortraitRenderTargetPool.h"
+#include "ActorPortraitAtlas.h"
 
 #include "Components/LineBatchComponent.h"
 #include "Components/SkyLightComponent.h"
@@ -19,6 +26,7 @@
 #include "Engine/TextureRenderTarget2D.h"
 #include "Engine/SkeletalMesh.h"
 #include "Framework/Application/SlateApplication.h"
+#include "Containers/Ticker.h"
 #include "UObject/Package.h"
 
 #include "EngineUtils.h"
@@ -30,17 +38,33 @@
 
 class FActorPortraitSceneSet
 {
-	TMap<UWorld*, TWeakPtr<SActorPortrait>> PortraitWorlds;
+	// Shared stages are used by several widgets, a world is registered until the last of them leaves it
+	TMap<UWorld*, TArray<TWeakPtr<SActorPortrait>, TInlineAllocator<1>>> PortraitWorlds;
 
 public:
 	FORCEINLINE void Add(UWorld* World, TWeakPtr<SActorPortrait> PortraitWidget)
 	{
-		PortraitWorlds.Add(World, PortraitWidget);
+		PortraitWorlds.FindOrAdd(World).AddUnique(PortraitWidget);
 	}
 
-	FORCEINLINE void Remove(UWorld* World)
+	FORCEINLINE void Remove(UWorld* World, const SActorPortrait* PortraitWidget)
 	{
-		PortraitWorlds.Remove(World);
+		auto* RegisteredWidgets = PortraitWorlds.Find(World);
+		if (!RegisteredWidgets)
+		{
+			return;
+		}
+
+		// Widgets being destroyed can no longer be pinned, drop them along with the leaving widget
+		RegisteredWidgets->RemoveAll([PortraitWidget](const TWeakPtr<SActorPortrait>& RegisteredWidget)
+		{
+			return !RegisteredWidget.IsValid() || RegisteredWidget.HasSameObject(PortraitWidget);
+		});
+
+		if (RegisteredWidgets->Num() == 0)
+		{
+			PortraitWorlds.Remove(World);
+		}
 	}
 
 	FORCEINLINE bool Contains(UWorld* World) const
@@ -50,15 +74,61 @@ public:
 
 	FORCEINLINE TWeakPtr<SActorPortrait> FindPortraitWidgetFromWorld(UWorld* World)
 	{
-		auto* PortraitWidget = PortraitWorlds.Find(World);
-		if (PortraitWidget)
+		if (auto* RegisteredWidgets = PortraitWorlds.Find(World))
 		{
-			return *PortraitWidget;
+			for (const TWeakPtr<SActorPortrait>& RegisteredWidget : *RegisteredWidgets)
+			{
+				if (RegisteredWidget.IsValid())
+				{
+					return RegisteredWidget;
+				}
+			}
 		}
 		return TWeakPtr<SActorPortrait>(nullptr);
 	}
 } PortraitWorlds;
 
+// Slate only ticks the portraits it paints, hidden portraits are paused from the core ticker which runs every frame
+class FHiddenPortraitWatcher
+{
+	TArray<SActorPortrait*> Portraits;
+	FTSTicker::FDelegateHandle TickerHandle;
+
+public:
+	void Add(SActorPortrait* PortraitWidget)
+	{
+		Portraits.AddUnique(PortraitWidget);
+
+		if (!TickerHandle.IsValid())
+		{
+			TickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FHiddenPortraitWatcher::Tick));
+		}
+	}
+
+	void Remove(SActorPortrait* PortraitWidget)
+	{
+		Portraits.RemoveSingleSwap(PortraitWidget);
+
+		if (Portraits.Num() == 0 && TickerHandle.IsValid())
+		{
+			FTSTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+			TickerHandle.Reset();
+		}
+	}
+
+private:
+	bool Tick(float DeltaTime)
+	{
+		QUICK_SCOPE_CYCLE_COUNTER(STAT_HiddenPortraitWatcher_Tick);
+
+		for (SActorPortrait* PortraitWidget : TArray<SActorPortrait*, TInlineAllocator<32>>(Portraits))
+		{
+			PortraitWidget->PauseIfHiddenFromView();
+		}
+		return true;
+	}
+} HiddenPortraits;
+
 void SActorPortrait::Construct(const FArguments& InArgs)
 {
 	PortraitUserData               = InArgs._PortraitUserData;
@@ -71,11 +141,25 @@ void SActorPortrait::Construct(const FArguments& InArgs)
 	MouseCaptureMode               = InArgs._MouseCaptureMode;
 	bLockDuringCapture             = InArgs._bLockDuringCapture;
 	bTickWorld                     = InArgs._bTickWorld;
+	TickRate                       = InArgs._TickRate;
+	TimeDilation                   = InArgs._TimeDilation;
+	TickPriority                   = InArgs._TickPriority;
 	bRealTime                      = InArgs._bRealTime;
+	MaxCaptureRate                 = InArgs._MaxCaptureRate;
 	bShouldShowMouseCursor         = InArgs._bShouldShowMouseCursor;
 	CaptureSource                  = InArgs._CaptureSource;
 	RenderMaterial                 = InArgs._RenderMaterial;
 	RenderMaterialTextureParameter = InArgs._RenderMaterialTextureParameter;
+	bLoadWorldAsync                = InArgs._bLoadWorldAsync;
+	PlaceholderBrush               = InArgs._PlaceholderBrush;
+	SharedStageName                = InArgs._SharedStageName;
+	WorldProfile                   = InArgs._WorldProfile;
+	bWaitForStreamingLevels        = InArgs._bWaitForStreamingLevels;
+	StreamingLevelsTimeout         = InArgs._StreamingLevelsTimeout;
+	bPruneBackgroundActors         = InArgs._bPruneBackgroundActors;
+	BackgroundPruneDistance        = InArgs._BackgroundPruneDistance;
+	bRenderToAtlas                 = InArgs._bRenderToAtlas;
+	RenderTargetFormat             = InArgs._RenderTargetFormat;
 
 	OnInputTouchEvent              = InArgs._OnInputTouchEvent;
 	OnTouchGestureEvent            = InArgs._OnTouchGestureEvent;
@@ -91,9 +175,15 @@ void SActorPortrait::Construct(const FArguments& InArgs)
 	OnSpawnPortraitActorEvent      = InArgs._OnSpawnPortraitActorEvent;
 	PreSpawnPortraitActorEvent     = InArgs._PreSpawnPortraitActorEvent;
 	PostCameraResetEvent           = InArgs._PostCameraResetEvent;
+	OnPortraitSceneLoadedEvent     = InArgs._OnPortraitSceneLoadedEvent;
+	OnPortraitReadyEvent           = InArgs._OnPortraitReadyEvent;
 
 	SetContent(InArgs._Content.Widget);
 
+	// Give the portrait a chance to be painted before it's considered hidden
+	LastVisibleFrameNumber = GFrameCounter;
+	HiddenPortraits.Add(this);
+
 	RecreatePortraitScene(InArgs._WorldAsset, InArgs._PortraitActorClass, InArgs._PortraitActorTransform, InArgs._SkySphereClass, InArgs._DirectionalLightTemplate, InArgs._SkyLightTemplate, InArgs._OwningGameInstance);
 }
 
@@ -106,8 +196,11 @@ SActorPortrait::~SActorPortrait()
 		RenderMaterialInstance->MarkAsGarbage();
 	}
 
-	PortraitWorlds.Remove(GetPortraitWorld());
-	PortraitScene.Reset();
+	PortraitWorlds.Remove(GetPortraitWorld(), this);
+	HiddenPortraits.Remove(this);
+	ReleasePortraitScene();
+	ReleaseRenderTarget();
+	SetCappedCaptureRate(0.f, 0.0);
 }
 
 void SActorPortrait::Tick(const FGeometry& AllottedGeometry, const double CurrentTime, const float DeltaTime)
@@ -116,9 +209,35 @@ void SActorPortrait::Tick(const FGeometry& AllottedGeometry, const double Curren
 
 	UpdateCachedGeometry(AllottedGeometry);
 
-	// If real-time, always re-draw the portrait
+	// Atlas pages are repacked and grown as portraits come and go
+	if (AtlasAllocationId != INDEX_NONE && AtlasGeneration != FActorPortraitAtlas::Get().GetGeneration())
+	{
+		UpdateAtlasBrush();
+	}
+
 	const bool bIsRealTime = bRealTime.Get();
-	if (bIsRealTime)
+
+	// Slate ticks portraits it doesn't repaint (cached by invalidation), only resume once the portrait has actually been painted visibly since it was paused
+	if (bIsPausedWhileHidden && (LastVisibleFrameNumber > PausedFrameNumber || !UActorPortraitProjectSettings::Get().bPauseHiddenPortraits))
+	{
+		SetPausedWhileHidden(false);
+	}
+
+	// Hidden portraits don't capture or tick their world until they are painted again
+	if (bIsPausedWhileHidden)
+	{
+		// Portraits in an invalidation panel are only painted when invalidated, give them a chance to show they are visible again
+		if (bIsRealTime || bRenderStateDirty)
+		{
+			Invalidate(EInvalidateWidgetReason::Paint);
+		}
+		return;
+	}
+
+	// If real-time, always re-draw the portrait, unless its capture rate is capped
+	SetCappedCaptureRate(bIsRealTime ? FMath::Max(MaxCaptureRate.Get(), 0.f) : 0.f, CurrentTime);
+
+	if (bIsRealTime && (CappedCaptureRate <= 0.f || ConsumeCappedCapture(CurrentTime, DeltaTime)))
 	{
 		MarkRenderStateDirty();
 	}
@@ -129,18 +248,21 @@ void SActorPortrait::Tick(const FGeometry& AllottedGeometry, const double Curren
 		return;
 	}
 
-	PortraitWorld->SetShouldTick(bTickWorld.Get());
+	PortraitScene->TickScene(DeltaTime, bTickWorld.Get(), TickRate.Get(), TimeDilation.Get(), TickPriority.Get());
 
-	#if WITH_EDITOR // Ticking is handled by UGameEngine::Tick in non-editor builds
-	PortraitScene->EditorTick(DeltaTime);
-	#endif
+	if (!bIsPortraitReady)
+	{
+		UpdatePortraitReady();
+	}
 
 	USceneCaptureComponent2D* CaptureComponent = GetCaptureComponent();
 
-	if (bRenderStateDirty && IsValid(CaptureComponent))
+	// Captures are held off until the sub-levels have streamed in, UpdatePortraitReady marks the render state dirty once they have
+	if (bRenderStateDirty && IsValid(CaptureComponent) && bIsPortraitReady)
 	{
 		const FIntPoint NewRenderSize = GetRenderSizeXY();
-		if (CaptureComponent->TextureTarget == nullptr || NewRenderSize.X != CaptureComponent->TextureTarget->SizeX || NewRenderSize.Y != CaptureComponent->TextureTarget->SizeY)
+		if (CaptureComponent->TextureTarget == nullptr || CaptureComponent->TextureTarget != RenderTarget || NewRenderSize != RenderSize
+			|| RenderTarget->RenderTargetFormat != GetResolvedRenderTargetFormat())
 		{
 			ResizeRenderTarget(NewRenderSize);
 
@@ -151,7 +273,7 @@ void SActorPortrait::Tick(const FGeometry& AllottedGeometry, const double Curren
 		CaptureComponent->PostProcessSettings = ViewInfo.PostProcessSettings;
 		CaptureComponent->PostProcessBlendWeight = ViewInfo.PostProcessBlendWeight;
 		CaptureComponent->CaptureSource = CaptureSource.Get();
-		CaptureComponent->bCaptureEveryFrame = bIsRealTime; // Improves performance to have this true if we're capturing every frame
+		CaptureComponent->bCaptureEveryFrame = bIsRealTime && CappedCaptureRate <= 0.f; // Improves performance to have this true if we're capturing every frame
 
 		ViewInfo.AspectRatio = NewRenderSize.X > 0 && NewRenderSize.Y > 0 ? (float)NewRenderSize.X / (float)NewRenderSize.Y : 1.f;
 		ViewInfo.bConstrainAspectRatio = false;
@@ -164,10 +286,7 @@ void SActorPortrait::Tick(const FGeometry& AllottedGeometry, const double Curren
 		ViewInfo.PostProcessSettings.VignetteIntensity           = 0.f;
 #endif
 
-		if (FSceneInterface* Scene = PortraitWorld->Scene)
-		{
-			LastFrameNumber = Scene->GetFrameNumber();
-		}
+		LastFrameNumber = GFrameCounter;
 	}
 
 	const bool bFlushViewInfoToCaptureComponent = IsValid(CaptureComponent) && (bCameraNeedsReset || bRenderStateDirty);
@@ -183,26 +302,57 @@ void SActorPortrait::Tick(const FGeometry& AllottedGeometry, const double Curren
 	if (bFlushViewInfoToCaptureComponent)
 	{
 		CaptureComponent->SetCameraView(ViewInfo);
+		UpdateCaptureProjection(CaptureComponent);
 	}
 }
 
 int32 SActorPortrait::OnPaint(const FPaintArgs& Args, const FGeometry& AllottedGeometry, const FSlateRect& MyCullingRect, FSlateWindowElementList& OutDrawElements, int32 LayerId, const FWidgetStyle& InWidgetStyle, bool bParentEnabled) const
 {
-	if (FSceneInterface* Scene = PortraitScene->GetScene())
+	if (PortraitScene.IsValid() && LastFrameNumber == GFrameCounter && LastCapturedFrameNumber != GFrameCounter)
 	{
-		if (LastFrameNumber == Scene->GetFrameNumber())
+		LastCapturedFrameNumber = GFrameCounter;
+
+		if (bPendingFirstCapture)
 		{
-			GetPortraitWorld()->SendAllEndOfFrameUpdates();
-			Scene->IncrementFrameNumber();
-			PortraitScene->UpdateCaptureComponentCaptureContents();
+			bPendingFirstCapture = false;
+
+			ACTOR_PORTRAIT_PHASE_SCOPE(FirstCapture, GetPhaseContext());
+			PortraitScene->UpdateCaptureContents(GetCaptureComponent());
+		}
+		else
+		{
+			// Rendered together with the captures of the other portraits, the first capture is rendered right away so the portrait shows up without delay
+			FActorPortraitCaptureScheduler::Get().RequestCapture(PortraitScene, GetCaptureComponent());
+		}
+	}
+
+	// While loading, draw the placeholder brush if there is one, otherwise keep drawing the last rendered frame
+	const FSlateBrush* DrawBrush = &Brush;
+	if (IsPortraitSceneLoading() || (PortraitScene.IsValid() && PortraitScene->GetWorld() && !bIsPortraitReady))
+	{
+		const FSlateBrush* Placeholder = PlaceholderBrush.Get();
+		if (Placeholder != nullptr && Placeholder->DrawAs != ESlateBrushDrawType::NoDrawType)
+		{
+			DrawBrush = Placeholder;
 		}
 	}
 
 	const bool bIsEnabled = ShouldBeEnabled(bParentEnabled);
 
 	const ESlateDrawEffect DrawEffects = bIsEnabled ? ESlateDrawEffect::None : ESlateDrawEffect::DisabledEffect;
-	const FLinearColor FinalColorAndOpacity(InWidgetStyle.GetColorAndOpacityTint() * ColorAndOpacity.Get().GetColor(InWidgetStyle) * Brush.GetTint(InWidgetStyle));
-	FSlateDrawElement::MakeBox(OutDrawElements, LayerId, AllottedGeometry.ToPaintGeometry(), &Brush, DrawEffects, FinalColorAndOpacity);
+	const FLinearColor PortraitColorAndOpacity(InWidgetStyle.GetColorAndOpacityTint() * ColorAndOpacity.Get().GetColor(InWidgetStyle));
+	const FLinearColor FinalColorAndOpacity(PortraitColorAndOpacity * DrawBrush->GetTint(InWidgetStyle));
+
+	if (PortraitColorAndOpacity.A > 0.f && FSlateRect::DoRectanglesIntersect(MyCullingRect, AllottedGeometry.GetRenderBoundingRect()))
+	{
+		LastVisibleFrameNumber = GFrameCounter;
+	}
+
+	// The render target of a portrait released while hidden may already be drawn by another portrait, draw nothing until it's captured again
+	if (DrawBrush != &Brush || Brush.GetResourceObject() != nullptr)
+	{
+		FSlateDrawElement::MakeBox(OutDrawElements, LayerId, AllottedGeometry.ToPaintGeometry(), DrawBrush, DrawEffects, FinalColorAndOpacity);
+	}
 
 	return SCompoundWidget::OnPaint(Args, AllottedGeometry, MyCullingRect, OutDrawElements, LayerId, InWidgetStyle, bIsEnabled);
 }
@@ -703,6 +853,10 @@ void SActorPortrait::AddReferencedObjects(FReferenceCollector& Collector)
 	Collector.AddReferencedObject(PortraitActor);
 	Collector.AddReferencedObject(PortraitUserData);
 	Collector.AddReferencedObject(RenderMaterial);
+	Collector.AddReferencedObject(PendingActorClass);
+	Collector.AddReferencedObject(PendingSkySphereClass);
+	Collector.AddReferencedObject(StageCaptureComponent);
+	Collector.AddReferencedObject(RenderTarget);
 	Brush.AddReferencedObjects(Collector);
 }
 
@@ -740,6 +894,7 @@ void SActorPortrait::SetRenderMaterial(UMaterialInterface* InRenderMaterial, FNa
 		RenderMaterial = InRenderMaterial;
 		RenderMaterialTextureParameter = InRenderMaterialTextureParameter;
 		RecreateRenderMaterial();
+		UpdateAtlasAllocation();
 	}
 }
 
@@ -783,12 +938,33 @@ void SActorPortrait::SetRealTime(const TAttribute<bool>& InRealTime)
 	bRealTime = InRealTime;
 }
 
+void SActorPortrait::SetMaxCaptureRate(const TAttribute<float>& InMaxCaptureRate)
+{
+	MaxCaptureRate = InMaxCaptureRate;
+}
+
 void SActorPortrait::SetTickWorld(const TAttribute<bool>& InTickWorld)
 {
 	bTickWorld = InTickWorld;
 
+	// A throttled world is only ticked by the portrait scene, see FActorPortraitScene::TickScene
 	if (UWorld* PortraitWorld = GetPortraitWorld())
-		PortraitWorld->SetShouldTick(bTickWorld.Get());
+		PortraitWorld->SetShouldTick(bTickWorld.Get() && TickRate.Get() <= 0.f);
+}
+
+void SActorPortrait::SetTickRate(const TAttribute<float>& InTickRate)
+{
+	TickRate = InTickRate;
+}
+
+void SActorPortrait::SetTimeDilation(const TAttribute<float>& InTimeDilation)
+{
+	TimeDilation = InTimeDilation;
+}
+
+void SActorPortrait::SetTickPriority(const TAttribute<int32>& InTickPriority)
+{
+	TickPriority = InTickPriority;
 }
 
 void SActorPortrait::SetCaptureSource(const TAttribute<ESceneCaptureSource>& InCaptrueSource)
@@ -796,6 +972,15 @@ void SActorPortrait::SetCaptureSource(const TAttribute<ESceneCaptureSource>& InC
 	SetAttributeWithSideEffect(CaptureSource, InCaptrueSource, &SActorPortrait::MarkRenderStateDirty);
 }
 
+void SActorPortrait::SetRenderTargetFormat(EPortraitRenderTargetFormat InRenderTargetFormat)
+{
+	if (RenderTargetFormat != InRenderTargetFormat)
+	{
+		RenderTargetFormat = InRenderTargetFormat;
+		MarkRenderStateDirty();
+	}
+}
+
 void SActorPortrait::SetPortraitSize(const TAttribute<FVector2D>& InPortraitSize)
 {
 	SetAttribute(PortraitSize, InPortraitSize, EInvalidateWidgetReason::Layout);
@@ -817,6 +1002,44 @@ void SActorPortrait::SetResolutionScale(const TAttribute<float>& InResolutionSca
 	SetAttributeWithSideEffect(ResolutionScale, InResolutionScale, &SActorPortrait::MarkRenderStateDirty);
 }
 
+void SActorPortrait::SetPlaceholderBrush(const TAttribute<const FSlateBrush*>& InPlaceholderBrush)
+{
+	SetAttribute(PlaceholderBrush, InPlaceholderBrush, EInvalidateWidgetReason::Paint);
+}
+
+void SActorPortrait::SetSharedStageName(FName InSharedStageName)
+{
+	SharedStageName = InSharedStageName;
+}
+
+void SActorPortrait::SetWorldProfile(EPortraitWorldProfile InWorldProfile)
+{
+	WorldProfile = InWorldProfile;
+}
+
+void SActorPortrait::SetBackgroundPruning(bool bInPruneBackgroundActors, float InBackgroundPruneDistance)
+{
+	if (bPruneBackgroundActors != bInPruneBackgroundActors || BackgroundPruneDistance != InBackgroundPruneDistance)
+	{
+		bPruneBackgroundActors  = bInPruneBackgroundActors;
+		BackgroundPruneDistance = InBackgroundPruneDistance;
+
+		UpdateBackgroundPruning();
+		MarkRenderStateDirty();
+	}
+}
+
+void SActorPortrait::SetRenderToAtlas(bool bInRenderToAtlas)
+{
+	if (bRenderToAtlas != bInRenderToAtlas)
+	{
+		bRenderToAtlas = bInRenderToAtlas;
+
+		UpdateAtlasAllocation();
+		MarkRenderStateDirty();
+	}
+}
+
 void SActorPortrait::ResetCamera()
 {
 	UWorld* PortraitWorld = GetPortraitWorld();
@@ -830,7 +1053,7 @@ void SActorPortrait::ResetCamera()
 		return;
 	}
 
-	OrbitOrigin = FVector::ZeroVector;
+	OrbitOrigin = GetStageSlotLocation();
 
 	// Clear any debug lines that may have been drawn by enabling CameraSettings.bDrawDebug
 	constexpr const UWorld::ELineBatcherType LineBatchersToFlush[] = 
@@ -1196,7 +1419,7 @@ void SActorPortrait::ResetCamera()
 	}
 	else
 	{
-		NewViewInfo.Location   = CameraSettings.CustomCameraLocation;
+		NewViewInfo.Location   = CameraSettings.CustomCameraLocation + GetStageSlotLocation();
 		NewViewInfo.Rotation   = CameraSettings.CustomCameraRotation;
 		NewViewInfo.OrthoWidth = CameraSettings.CustomOrthoWidth;
 	}
@@ -1220,6 +1443,8 @@ void SActorPortrait::ResetCamera()
 	SetCameraProjection(NewViewInfo.ProjectionMode, NewViewInfo.FOV, NewViewInfo.OrthoWidth, false);
 
 	PostCameraResetEvent.ExecuteIfBound();
+
+	UpdateBackgroundPruning();
 }
 
 void SActorPortrait::RotateActor(float RotateX, float RotateY)
@@ -1251,6 +1476,9 @@ const FVector& SActorPortrait::GetCameraOrbitOrigin() const
 void SActorPortrait::SetCameraOrbitOrigin(const FVector& NewOrbitOrigin)
 {
 	OrbitOrigin = NewOrbitOrigin;
+
+	// The orbit origin is moved every frame while panning, only prune again once the camera can reach past the pruned volume
+	UpdateBackgroundPruning(true);
 }
 
 void SActorPortrait::OrbitCamera(float OrbitX, float OrbitY)
@@ -1322,6 +1550,12 @@ void SActorPortrait::SetCameraTransform(const FTransform& Transform)
 	ViewInfo.Location = Transform.GetLocation();
 	ViewInfo.Rotation = Transform.Rotator();
 
+	// The camera was moved somewhere the background wasn't pruned for, e.g. by a custom camera controller
+	if (bPruneBackgroundActors && BackgroundPruneVolume.W > 0.f && !BackgroundPruneVolume.IsInside(ViewInfo.Location))
+	{
+		UpdateBackgroundPruning(true);
+	}
+
 	MarkRenderStateDirty();
 }
 
@@ -1343,7 +1577,7 @@ void SActorPortrait::SetPortraitActorTransform(const FTransform& Transform, bool
 {
 	if (IsValid(PortraitActor))
 	{
-		PortraitActor->SetActorTransform(Transform);
+		PortraitActor->SetActorTransform(Transform * FTransform(GetStageSlotLocation()));
 	}
 
 	if (bResetCamera)
@@ -1371,7 +1605,17 @@ void SActorPortrait::RecaptureSky()
 		IActorPortraitInterface::Execute_OnUpdatePortraitScene(SkySphereActor, PortraitUserData);
 	}
 
-	PortraitScene->UpdateSkyCaptureContents();
+	// Capturing the sky before the sub-levels have streamed in would have to be redone, UpdatePortraitReady recaptures it once they have
+	if (!bIsPortraitReady)
+	{
+		bSkyRecapturePending = true;
+		return;
+	}
+
+	{
+		ACTOR_PORTRAIT_PHASE_SCOPE(SkyRecapture, GetPhaseContext());
+		PortraitScene->UpdateSkyCaptureContents();
+	}
 
 	MarkRenderStateDirty();
 }
@@ -1382,26 +1626,119 @@ void SActorPortrait::RecreatePortraitScene(const TSoftObjectPtr<UWorld>& WorldAs
 	{
 		if (UWorld* PortraitWorld = PortraitScene->GetWorld())
 		{
-			PortraitWorlds.Remove(PortraitWorld);
+			PortraitWorlds.Remove(PortraitWorld, this);
 		}
+
+		ReleasePortraitScene();
 	}
 
-	PortraitScene = MakePimpl<FActorPortraitScene>(WorldAsset, DirectionalLightTemplate, SkyLightTemplate, bTickWorld.Get(), OwningGameInstance);
+	bIsPortraitReady     = false;
+	bSkyRecapturePending = false;
+
+	// Time-slicing only takes effect when the project settings give scene construction a per-frame budget
+	FInstanceWorld::ConstructionValues CVS = FActorPortraitScene::MakeConstructionValues(WorldAsset, ActorClass.Get(), SkySphereClass.Get(), WorldProfile, OwningGameInstance)
+		.SetShouldTickWorld(bTickWorld.Get())
+		.SetTimeSliceConstruction(true);
 
+	// Portraits on a stage with a background world would all stand in front of the background at the origin, casting shadows on and lighting each other
+	const bool bUseSharedStage = !SharedStageName.IsNone() && WorldAsset.IsNull();
+	if (!SharedStageName.IsNone() && !bUseSharedStage)
+	{
+		UE_LOG(LogActorPortrait, Warning, TEXT("%s has a background world and can't use shared stage %s, it gets its own world"), *GetReadableLocation(), *SharedStageName.ToString());
+	}
+
+	if (!bUseSharedStage)
+	{
+		PortraitScene = FActorPortraitScenePool::Get().AcquireScene(CVS.SetLoadAsync(bLoadWorldAsync), DirectionalLightTemplate, SkyLightTemplate);
+	}
+	else
+	{
+		PortraitScene = FActorPortraitScenePool::Get().AcquireSharedStage(CVS.SetLoadAsync(bLoadWorldAsync), SharedStageName, DirectionalLightTemplate, SkyLightTemplate);
+		StageSlot = PortraitScene->AcquireStageSlot();
+	}
+
+	PendingActorClass     = ActorClass.Get();
+	PendingActorTransform = ActorTransform;
+	PendingSkySphereClass = SkySphereClass.Get();
+
+	if (PortraitScene->IsLoading())
+	{
+		PortraitScene->OnSceneLoaded().AddSP(this, &SActorPortrait::OnPortraitSceneLoaded);
+		return;
+	}
+
+	OnPortraitSceneLoaded(PortraitScene->GetWorld() != nullptr);
+}
+
+void SActorPortrait::OnPortraitSceneLoaded(bool bSuccess)
+{
+	PortraitScene->OnSceneLoaded().RemoveAll(this);
+
+	// Spawning the portrait actor and sky sphere is the last stage of a time-sliced construction. Until it has run the scene is reported as
+	// loading, so RecreatePortraitActor and RecreateSkySphere only update the pending classes.
+	if (bSuccess && PortraitScene->GetConstructionValues().bTimeSliceConstruction && FActorPortraitConstructionQueue::IsEnabled())
+	{
+		PortraitConstructionToken = MakeShared<bool>(true);
+		FActorPortraitConstructionQueue::Get().Enqueue(PortraitConstructionToken, { [this]()
+		{
+			PortraitConstructionToken.Reset();
+			FinishPortraitSceneConstruction(true);
+		}});
+		return;
+	}
+
+	FinishPortraitSceneConstruction(bSuccess);
+}
+
+void SActorPortrait::FinishPortraitSceneConstruction(bool bSuccess)
+{
 	if (UWorld* PortraitWorld = PortraitScene->GetWorld())
 	{
 		PortraitWorlds.Add(PortraitWorld, SharedThis(this));
+
+		InitializeStageCapture();
+
+		RecreatePortraitActor(PendingActorClass, PendingActorTransform, false);
+		RecreateSkySphere(PendingSkySphereClass, true);
+		ResetCamera(); // Do this manually so we don't get a one frame delay on resetting the camera.
 	}
 
-	RecreatePortraitActor(ActorClass, ActorTransform, false);
-	RecreateSkySphere(SkySphereClass, true);
-	ResetCamera(); // Do this manually so we don't get a one frame delay on resetting the camera.
+	PendingActorClass     = nullptr;
+	PendingActorTransform = FTransform::Identity;
+	PendingSkySphereClass = nullptr;
+
+	OnPortraitSceneLoadedEvent.ExecuteIfBound(bSuccess);
+
+	BeginWaitForPortraitReady();
+}
+
+bool SActorPortrait::NeedsNewPortraitScene(TSubclassOf<AActor> ActorClass) const
+{
+	if (WorldProfile != EPortraitWorldProfile::Auto || !PortraitScene.IsValid())
+	{
+		return false;
+	}
+
+	const FInstanceWorld::ConstructionValues& SceneCVS = PortraitScene->GetConstructionValues();
+	UClass* SkySphereClass = IsValid(SkySphereActor) ? SkySphereActor->GetClass() : PendingSkySphereClass.Get();
+
+	FInstanceWorld::ConstructionValues CVS = SceneCVS;
+	FActorPortraitScene::ApplyWorldProfile(CVS, WorldProfile, ActorClass.Get(), SkySphereClass);
+
+	return !(CVS == SceneCVS);
 }
 
 void SActorPortrait::RecreatePortraitActor(TSubclassOf<AActor> ActorClass, const FTransform& ActorTransform, bool bResetCamera)
 {
 	QUICK_SCOPE_CYCLE_COUNTER(STAT_SActorPortrait_RecreatePortraitActor);
 
+	if (IsPortraitSceneLoading())
+	{
+		PendingActorClass     = ActorClass.Get();
+		PendingActorTransform = ActorTransform;
+		return;
+	}
+
 	if (IsValid(PortraitActor))
 	{
 		PortraitActor->Destroy();
@@ -1410,18 +1747,30 @@ void SActorPortrait::RecreatePortraitActor(TSubclassOf<AActor> ActorClass, const
 
 	if (UClass* PortraitActorClass = ActorClass.Get())
 	{
+		if (!FActorPortraitScene::SupportsActorClass(PortraitScene->GetConstructionValues(), PortraitActorClass))
+		{
+			UE_LOG(LogActorPortrait, Warning, TEXT("Portrait actor %s needs engine subsystems which were not created for the portrait world, recreate the portrait scene or use the Full world profile"), *PortraitActorClass->GetName());
+		}
+
+		ACTOR_PORTRAIT_PHASE_SCOPE(SpawnPortraitActor, FActorPortraitPhaseContext(PortraitScene->GetConstructionValues().WorldAsset.ToSoftObjectPath(), PortraitActorClass));
+
 		FActorSpawnParameters SpawnParams;
 		SpawnParams.bNoFail = true;
 		SpawnParams.bDeferConstruction = true;
-		PortraitActor = PortraitScene->SpawnPortraitActor(PortraitActorClass, ActorTransform, SpawnParams);
+		const FTransform SpawnTransform = ActorTransform * FTransform(GetStageSlotLocation());
+		PortraitActor = PortraitScene->SpawnPortraitActor(PortraitActorClass, SpawnTransform, SpawnParams);
 
 		PreSpawnPortraitActorEvent.ExecuteIfBound(PortraitActor);
 
-		PortraitScene->FinishSpawningPortraitActor(PortraitActor, ActorTransform);
+		PortraitScene->FinishSpawningPortraitActor(PortraitActor, SpawnTransform);
 		
 		OnSpawnPortraitActorEvent.ExecuteIfBound(PortraitActor);
+
+		bPendingFirstCapture = true;
 	}
 
+	UpdateStageShowOnlyList();
+
 	MarkRenderStateDirty();
 
 	if (bResetCamera)
@@ -1432,18 +1781,33 @@ void SActorPortrait::RecreatePortraitActor(TSubclassOf<AActor> ActorClass, const
 
 void SActorPortrait::RecreateSkySphere(TSubclassOf<AActor> InSkySphereClass, bool bRecaptureSky)
 {
-	UClass* SkySphereClass = InSkySphereClass.Get();
-	if (IsValid(SkySphereActor) && (!SkySphereClass || SkySphereActor->GetClass() != SkySphereClass))
+	if (IsPortraitSceneLoading())
 	{
-		SkySphereActor->Destroy();
-		SkySphereActor = nullptr;
+		PendingSkySphereClass = InSkySphereClass.Get();
+		return;
 	}
 
-	if (!IsValid(SkySphereActor) && SkySphereClass)
+	UClass* SkySphereClass = InSkySphereClass.Get();
+	if (IsOnSharedStage())
 	{
-		FActorSpawnParameters SpawnParams;
-		SpawnParams.bNoFail = true;
-		SkySphereActor = PortraitScene->SpawnPortraitActor<AActor>(SkySphereClass, SpawnParams);
+		// The sky sphere is shared by all portraits on the stage
+		SkySphereActor = PortraitScene->GetOrSpawnStageSkySphere(SkySphereClass);
+		UpdateStageShowOnlyList();
+	}
+	else
+	{
+		if (IsValid(SkySphereActor) && (!SkySphereClass || SkySphereActor->GetClass() != SkySphereClass))
+		{
+			SkySphereActor->Destroy();
+			SkySphereActor = nullptr;
+		}
+
+		if (!IsValid(SkySphereActor) && SkySphereClass)
+		{
+			FActorSpawnParameters SpawnParams;
+			SpawnParams.bNoFail = true;
+			SkySphereActor = PortraitScene->SpawnPortraitActor<AActor>(SkySphereClass, SpawnParams);
+		}
 	}
 
 	if (bRecaptureSky)
@@ -1454,9 +1818,206 @@ void SActorPortrait::RecreateSkySphere(TSubclassOf<AActor> InSkySphereClass, boo
 	MarkRenderStateDirty();
 }
 
+void SActorPortrait::ReleasePortraitScene()
+{
+	if (IsOnSharedStage())
+	{
+		// Other portraits may still be using the stage, remove everything owned by this portrait
+		if (IsValid(PortraitActor))
+		{
+			PortraitActor->Destroy();
+		}
+
+		PortraitScene->DestroyCaptureComponent(StageCaptureComponent);
+		PortraitScene->ReleaseStageSlot(StageSlot);
+	}
+
+	StageCaptureComponent = nullptr;
+	StageSlot             = INDEX_NONE;
+
+	// Pruned background primitives are restored by the scene when it's returned to the pool
+	BackgroundPruneVolume = FSphere(ForceInit);
+
+	// The actors are destroyed by the scene when it's returned to the pool
+	PortraitActor  = nullptr;
+	SkySphereActor = nullptr;
+
+	PendingActorClass     = nullptr;
+	PendingSkySphereClass = nullptr;
+
+	// Drops the queued construction stage of this portrait
+	PortraitConstructionToken.Reset();
+
+	if (PortraitScene.IsValid())
+	{
+		PortraitScene->OnSceneLoaded().RemoveAll(this);
+	}
+
+	if (USceneCaptureComponent2D* CaptureComponent = GetCaptureComponent())
+	{
+		CaptureComponent->TextureTarget = nullptr;
+	}
+
+	FActorPortraitScenePool::Get().ReleaseScene(MoveTemp(PortraitScene));
+}
+
+int64 SActorPortrait::GetRenderTargetMemorySize() const
+{
+	if (!RenderTarget)
+	{
+		return 0;
+	}
+
+	int64 MemorySize = RenderTarget->CalcTextureMemorySizeEnum(TMC_ResidentMips);
+
+	UTextureRenderTarget2D* AtlasPage = nullptr;
+	FBox2f AtlasUVRegion(ForceInit);
+	if (FActorPortraitAtlas::Get().GetAllocation(AtlasAllocationId, AtlasPage, AtlasUVRegion))
+	{
+		const FPixelFormatInfo& PixelFormat = GPixelFormats[AtlasPage->GetFormat()];
+		MemorySize += (int64)RenderSize.X * RenderSize.Y * PixelFormat.BlockBytes / (PixelFormat.BlockSizeX * PixelFormat.BlockSizeY);
+	}
+
+	return MemorySize;
+}
+
+bool SActorPortrait::IsPortraitSceneLoading() const
+{
+	return PortraitScene.IsValid() && (PortraitScene->IsLoading() || PortraitConstructionToken.IsValid());
+}
+
+void SActorPortrait::BeginWaitForPortraitReady()
+{
+	bIsPortraitReady   = false;
+	ReadyWaitStartTime = FPlatformTime::Seconds();
+
+	UpdatePortraitReady();
+}
+
+void SActorPortrait::UpdatePortraitReady()
+{
+	if (bIsPortraitReady || !PortraitScene.IsValid() || !PortraitScene->GetWorld())
+	{
+		return;
+	}
+
+	const bool bStreamingLevelsReady = !bWaitForStreamingLevels || PortraitScene->UpdateStreamingLevels();
+	const bool bTimedOut = !bStreamingLevelsReady && StreamingLevelsTimeout > 0.f && FPlatformTime::Seconds() - ReadyWaitStartTime >= StreamingLevelsTimeout;
+
+	if (!bStreamingLevelsReady && !bTimedOut)
+	{
+		return;
+	}
+
+	if (bTimedOut)
+	{
+		UE_LOG(LogActorPortrait, Warning, TEXT("Sub-levels of portrait world %s did not stream in within %.1f seconds, capturing the portrait anyway"), *PortraitScene->GetWorld()->GetName(), StreamingLevelsTimeout);
+	}
+
+	bIsPortraitReady = true;
+
+	if (bSkyRecapturePending)
+	{
+		bSkyRecapturePending = false;
+
+		ACTOR_PORTRAIT_PHASE_SCOPE(SkyRecapture, GetPhaseContext());
+		PortraitScene->UpdateSkyCaptureContents();
+	}
+
+	MarkRenderStateDirty();
+
+	OnPortraitReadyEvent.ExecuteIfBound(bTimedOut);
+}
+
+bool SActorPortrait::IsOnSharedStage() const
+{
+	return PortraitScene.IsValid() && StageSlot != INDEX_NONE;
+}
+
+void SActorPortrait::InitializeStageCapture()
+{
+	if (IsOnSharedStage() && !IsValid(StageCaptureComponent))
+	{
+		StageCaptureComponent = PortraitScene->CreateCaptureComponent();
+		UpdateStageShowOnlyList();
+	}
+}
+
+void SActorPortrait::UpdateStageShowOnlyList()
+{
+	if (!IsOnSharedStage() || !IsValid(StageCaptureComponent))
+	{
+		return;
+	}
+
+	StageCaptureComponent->PrimitiveRenderMode = ESceneCapturePrimitiveRenderMode::PRM_UseShowOnlyList;
+	StageCaptureComponent->ShowOnlyActors.Reset();
+
+	for (const TObjectKey<AActor>& BackgroundActor : PortraitScene->GetBackgroundActors())
+	{
+		if (AActor* Actor = BackgroundActor.ResolveObjectPtr())
+		{
+			StageCaptureComponent->ShowOnlyActors.Add(Actor);
+		}
+	}
+
+	if (IsValid(SkySphereActor))
+	{
+		StageCaptureComponent->ShowOnlyActors.Add(SkySphereActor);
+	}
+
+	if (IsValid(PortraitActor))
+	{
+		StageCaptureComponent->ShowOnlyActors.Add(PortraitActor);
+
+		TArray<AActor*> AttachedActors;
+		PortraitActor->GetAttachedActors(AttachedActors, false, true);
+		StageCaptureComponent->ShowOnlyActors.Append(AttachedActors);
+	}
+}
+
+void SActorPortrait::UpdateBackgroundPruning(bool bOnlyIfGrown)
+{
+	if (!PortraitScene.IsValid() || PortraitScene->IsLoading())
+	{
+		return;
+	}
+
+	if (!bPruneBackgroundActors || IsOnSharedStage())
+	{
+		BackgroundPruneVolume = FSphere(ForceInit);
+		PortraitScene->RestorePrunedBackgroundPrimitives();
+		return;
+	}
+
+	// The camera can orbit the origin at up to MaxZoomDistance, or further if it was placed there by the auto framing or a custom camera location
+	const float MaxZoomDistance = PortraitCameraSettings.Get().MaxZoomDistance;
+	const FSphere CameraVolume(OrbitOrigin, FMath::Max<double>(MaxZoomDistance, FVector::Dist(ViewInfo.Location, OrbitOrigin)));
+
+	// Everything visible from inside the new volume is visible from the pruned volume, which already has it registered
+	if (bOnlyIfGrown && BackgroundPruneVolume.W > 0.f && FVector::Dist(CameraVolume.Center, BackgroundPruneVolume.Center) + CameraVolume.W <= BackgroundPruneVolume.W)
+	{
+		return;
+	}
+
+	BackgroundPruneVolume = CameraVolume;
+
+	PortraitScene->PruneBackgroundPrimitives(BackgroundPruneVolume, BackgroundPruneDistance);
+}
+
+FVector SActorPortrait::GetStageSlotLocation() const
+{
+	return IsOnSharedStage() ? PortraitScene->GetStageSlotLocation(StageSlot) : FVector::ZeroVector;
+}
+
+FActorPortraitPhaseContext SActorPortrait::GetPhaseContext() const
+{
+	return FActorPortraitPhaseContext(PortraitScene->GetConstructionValues().WorldAsset.ToSoftObjectPath(), IsValid(PortraitActor) ? PortraitActor->GetClass() : nullptr);
+}
+
 UWorld* SActorPortrait::GetPortraitWorld() const
 {
-	return PortraitScene->GetWorld(); 
+	return PortraitScene.IsValid() ? PortraitScene->GetWorld() : nullptr; 
 }
 
 AActor* SActorPortrait::GetSkySphereActor() const
@@ -1471,17 +2032,22 @@ AActor* SActorPortrait::GetPortraitActor() const
 
 USceneCaptureComponent2D* SActorPortrait::GetCaptureComponent() const
 {
-	return PortraitScene->GetCaptureComponent();
+	if (IsOnSharedStage())
+	{
+		return StageCaptureComponent;
+	}
+
+	return PortraitScene.IsValid() ? PortraitScene->GetCaptureComponent() : nullptr;
 }
 
 UDirectionalLightComponent* SActorPortrait::GetDirectionalLightComponent() const
 {
-	return PortraitScene->GetDirectionalLightComponent();
+	return PortraitScene.IsValid() ? PortraitScene->GetDirectionalLightComponent() : nullptr;
 }
 
 USkyLightComponent* SActorPortrait::GetSkyLightComponent() const
 {
-	return PortraitScene->GetSkyLightComponent();
+	return PortraitScene.IsValid() ? PortraitScene->GetSkyLightComponent() : nullptr;
 }
 
 FIntPoint SActorPortrait::GetSizeXY() const
@@ -1541,24 +2107,275 @@ void SActorPortrait::ResizeRenderTarget(const FIntPoint& NewRenderSize)
 		return;
 	}
 
-	if (!CaptureComponent->TextureTarget)
+	if (NewRenderSize.X > 0 && NewRenderSize.Y > 0)
+	{
+		// Only sizes changing bucket need a new render target, smaller changes are drawn from a different part of the same one
+		const ETextureRenderTargetFormat ResolvedFormat = GetResolvedRenderTargetFormat();
+		if (!FActorPortraitRenderTargetPool::IsSuitable(RenderTarget, NewRenderSize, ResolvedFormat))
+		{
+			ReleaseRenderTarget();
+			RenderTarget = FActorPortraitRenderTargetPool::Get().Acquire(NewRenderSize, ResolvedFormat);
+		}
+
+		RenderSize = NewRenderSize;
+	}
+
+	if (CaptureComponent->TextureTarget != RenderTarget)
+	{
+		CaptureComponent->TextureTarget = RenderTarget;
+		RecreateRenderMaterial();
+	}
+
+	Brush.SetUVRegion(FActorPortraitRenderTargetPool::GetUVRegion(RenderTarget, RenderSize));
+
+	UpdateAtlasAllocation();
+}
+
+ETextureRenderTargetFormat SActorPortrait::GetResolvedRenderTargetFormat() const
+{
+	switch (RenderTargetFormat)
+	{
+	case EPortraitRenderTargetFormat::RGBA8:   return ETextureRenderTargetFormat::RTF_RGBA8_SRGB;
+	case EPortraitRenderTargetFormat::RGB10A2: return ETextureRenderTargetFormat::RTF_RGB10A2;
+	case EPortraitRenderTargetFormat::RGBA16F: return ETextureRenderTargetFormat::RTF_RGBA16f;
+	case EPortraitRenderTargetFormat::R8:      return ETextureRenderTargetFormat::RTF_R8;
+	case EPortraitRenderTargetFormat::R16F:    return ETextureRenderTargetFormat::RTF_R16f;
+	default: break;
+	}
+
+	switch (CaptureSource.Get())
+	{
+	case ESceneCaptureSource::SCS_SceneColorHDR:
+	case ESceneCaptureSource::SCS_SceneColorHDRNoAlpha:
+		return ETextureRenderTargetFormat::RTF_RGBA16f;
+	case ESceneCaptureSource::SCS_SceneColorSceneDepth:
+		return ETextureRenderTargetFormat::RTF_RGBA32f; // Depth is written to alpha, half precision can't hold world distances
+	case ESceneCaptureSource::SCS_SceneDepth:
+	case ESceneCaptureSource::SCS_DeviceDepth:
+		return ETextureRenderTargetFormat::RTF_R32f;
+	default:
+		// The format portraits always captured into, so existing portraits use no extra memory. Gamma encoding keeps displayable final color
+		// from banding, portraits which need the HDR range above 1 (FinalColorHDR, FinalToneCurveHDR) can pick RGBA16F.
+		return ETextureRenderTargetFormat::RTF_RGBA8_SRGB;
+	}
+}
+
+bool SActorPortrait::IsHiddenFromView() const
+{
+	const UActorPortraitProjectSettings& Settings = UActorPortraitProjectSettings::Get();
+	if (!Settings.bPauseHiddenPortraits)
+	{
+		return false;
+	}
+
+	return GFrameCounter - LastVisibleFrameNumber > (uint64)FMath::Max(Settings.HiddenPortraitGraceFrames, 1);
+}
+
+void SActorPortrait::SetPausedWhileHidden(bool bInIsPausedWhileHidden)
+{
+	if (bIsPausedWhileHidden == bInIsPausedWhileHidden)
+	{
+		return;
+	}
+
+	bIsPausedWhileHidden = bInIsPausedWhileHidden;
+
+	if (bIsPausedWhileHidden)
+	{
+		PausedFrameNumber = GFrameCounter;
+
+		UE_LOG(LogActorPortrait, VeryVerbose, TEXT("Pausing hidden portrait %s"), *GetReadableLocation());
+
+		// Stop ticking the world, portraits on a shared stage leave it to the other portraits on the stage
+		if (PortraitScene.IsValid() && !IsOnSharedStage())
+		{
+			PortraitScene->TickScene(0.f, false, TickRate.Get(), TimeDilation.Get(), TickPriority.Get());
+		}
+
+		if (USceneCaptureComponent2D* CaptureComponent = GetCaptureComponent())
+		{
+			CaptureComponent->bCaptureEveryFrame = false;
+		}
+
+		SetCappedCaptureRate(0.f, 0.0);
+
+		if (UActorPortraitProjectSettings::Get().bReleaseHiddenPortraitRenderTargets)
+		{
+			ReleaseRenderTarget();
+			Brush.SetResourceObject(nullptr);
+
+			// Cached draw elements would keep drawing the render target, which may now be handed to another portrait
+			Invalidate(EInvalidateWidgetReason::Paint);
+		}
+	}
+	else
+	{
+		UE_LOG(LogActorPortrait, VeryVerbose, TEXT("Resuming portrait %s"), *GetReadableLocation());
+
+		// Re-acquires the render target if it was released, and captures whatever changed while the portrait was hidden
+		MarkRenderStateDirty();
+	}
+}
+
+void SActorPortrait::PauseIfHiddenFromView()
+{
+	if (!bIsPausedWhileHidden && IsHiddenFromView())
+	{
+		SetPausedWhileHidden(true);
+	}
+}
+
+void SActorPortrait::SetCappedCaptureRate(float InCappedCaptureRate, double CurrentTime)
+{
+	if (CappedCaptureRate == InCappedCaptureRate)
+	{
+		return;
+	}
+
+	FActorPortraitCaptureScheduler& CaptureScheduler = FActorPortraitCaptureScheduler::Get();
+
+	if (CappedCaptureRate > 0.f)
+	{
+		CaptureScheduler.RemoveCappedCapture(CappedCaptureRate);
+	}
+
+	CappedCaptureRate = InCappedCaptureRate;
+
+	if (CappedCaptureRate > 0.f)
+	{
+		const float CapturePhase = CaptureScheduler.AddCappedCapture(CappedCaptureRate);
+		NextCappedCaptureTime = CurrentTime + CapturePhase / CappedCaptureRate;
+	}
+}
+
+bool SActorPortrait::ConsumeCappedCapture(double CurrentTime, float DeltaTime)
+{
+	if (CurrentTime < NextCappedCaptureTime || !FActorPortraitCaptureScheduler::Get().TryConsumeCappedCapture(DeltaTime))
+	{
+		return false;
+	}
+
+	// Keep the phase of the portrait, unless it fell more than a capture interval behind
+	const double CaptureInterval = 1.0 / CappedCaptureRate;
+	NextCappedCaptureTime += CaptureInterval;
+
+	if (NextCappedCaptureTime <= CurrentTime)
+	{
+		NextCappedCaptureTime = CurrentTime + CaptureInterval;
+	}
+
+	return true;
+}
+
+void SActorPortrait::ReleaseRenderTarget()
+{
+	if (!RenderTarget)
+	{
+		return;
+	}
+
+	if (AtlasAllocationId != INDEX_NONE)
 	{
-		if (NewRenderSize.X > 0 && NewRenderSize.Y > 0)
+		FActorPortraitAtlas::Get().Free(AtlasAllocationId);
+		AtlasAllocationId = INDEX_NONE;
+	}
+
+	if (USceneCaptureComponent2D* CaptureComponent = GetCaptureComponent())
+	{
+		if (CaptureComponent->TextureTarget == RenderTarget)
 		{
-			UTextureRenderTarget2D* NewRenderTarget2D = NewObject<UTextureRenderTarget2D>(CaptureComponent, NAME_None, RF_Transient);
-			NewRenderTarget2D->RenderTargetFormat = ETextureRenderTargetFormat::RTF_RGBA8_SRGB;
-			NewRenderTarget2D->ClearColor = FLinearColor::Black;
-			NewRenderTarget2D->InitAutoFormat(NewRenderSize.X, NewRenderSize.Y);
-			NewRenderTarget2D->UpdateResourceImmediate(true);
+			CaptureComponent->TextureTarget = nullptr;
+		}
+	}
+
+	FActorPortraitRenderTargetPool::Get().Release(RenderTarget);
+	RenderTarget = nullptr;
+}
+
+void SActorPortrait::UpdateAtlasAllocation()
+{
+	FActorPortraitAtlas& Atlas = FActorPortraitAtlas::Get();
 
-			CaptureComponent->TextureTarget = NewRenderTarget2D;
+	// A render material draws each portrait with its own material instance, which Slate can't batch anyway
+	const bool bUseAtlas = bRenderToAtlas && RenderMaterial == nullptr && RenderTarget != nullptr && RenderSize.X > 0 && RenderSize.Y > 0;
+	if (bUseAtlas)
+	{
+		if (AtlasAllocationId == INDEX_NONE)
+		{
+			AtlasAllocationId = Atlas.Allocate(RenderSize, RenderTarget);
+		}
+		else if (!Atlas.Reallocate(AtlasAllocationId, RenderSize, RenderTarget))
+		{
+			AtlasAllocationId = INDEX_NONE;
 		}
+
+		if (AtlasAllocationId != INDEX_NONE)
+		{
+			UpdateAtlasBrush();
+			return;
+		}
+	}
+	else if (AtlasAllocationId != INDEX_NONE)
+	{
+		Atlas.Free(AtlasAllocationId);
+		AtlasAllocationId = INDEX_NONE;
+	}
+
+	// Draw the portrait's own render target again if the brush was drawing an atlas page, also when the portrait doesn't fit in the atlas
+	if (Brush.GetResourceObject() != RenderTarget && !Cast<UMaterialInstanceDynamic>(Brush.GetResourceObject()))
+	{
 		RecreateRenderMaterial();
 	}
-	else if (NewRenderSize.X > 0 && NewRenderSize.Y > 0)
+
+	Brush.SetUVRegion(FActorPortraitRenderTargetPool::GetUVRegion(RenderTarget, RenderSize));
+}
+
+void SActorPortrait::UpdateAtlasBrush()
+{
+	UTextureRenderTarget2D* AtlasPage = nullptr;
+	FBox2f AtlasUVRegion(ForceInit);
+
+	if (FActorPortraitAtlas::Get().GetAllocation(AtlasAllocationId, AtlasPage, AtlasUVRegion))
+	{
+		Brush.SetResourceObject(AtlasPage);
+		Brush.SetUVRegion(AtlasUVRegion);
+
+		// Cached draw elements (invalidation panels) would keep drawing the old rectangle
+		Invalidate(EInvalidateWidgetReason::Paint);
+	}
+
+	AtlasGeneration = FActorPortraitAtlas::Get().GetGeneration();
+}
+
+void SActorPortrait::UpdateCaptureProjection(USceneCaptureComponent2D* CaptureComponent) const
+{
+	const FBox2f UVRegion = FActorPortraitRenderTargetPool::GetUVRegion(CaptureComponent->TextureTarget, RenderSize);
+
+	CaptureComponent->bUseCustomProjectionMatrix = !UVRegion.Max.Equals(FVector2f::UnitVector);
+	if (!CaptureComponent->bUseCustomProjectionMatrix)
 	{
-		CaptureComponent->TextureTarget->ResizeTarget(NewRenderSize.X, NewRenderSize.Y);
+		return;
 	}
+
+	// Scale and offset the clip space so the view covers the top left UVRegion of the render target. 
+	// Clip space Y points up, so the top of the view stays at Y = 1 while the bottom moves up to 1 - 2 * V.
+	// Scene captures always render their whole target, the rest of the bucket shows the scene beyond the view. It's never drawn (the brush and the 
+	// atlas copy only read UVRegion) but it is shaded, and auto exposure, bloom and temporal AA see it, see RenderTargetPoolBucketSize.
+	const float ScaleX  = UVRegion.Max.X;
+	const float ScaleY  = UVRegion.Max.Y;
+	const float OffsetX = UVRegion.Max.X - 1.f;
+	const float OffsetY = 1.f - UVRegion.Max.Y;
+
+	const FMatrix ProjectionMatrix = ViewInfo.CalculateProjectionMatrix();
+	FMatrix SubRectProjectionMatrix = ProjectionMatrix;
+
+	for (int32 Row = 0; Row < 4; ++Row)
+	{
+		SubRectProjectionMatrix.M[Row][0] = ScaleX * ProjectionMatrix.M[Row][0] + OffsetX * ProjectionMatrix.M[Row][3];
+		SubRectProjectionMatrix.M[Row][1] = ScaleY * ProjectionMatrix.M[Row][1] + OffsetY * ProjectionMatrix.M[Row][3];
+	}
+
+	CaptureComponent->CustomProjectionMatrix = SubRectProjectionMatrix;
 }
 
 void SActorPortrait::ProcessAccumulatedPointerInput()
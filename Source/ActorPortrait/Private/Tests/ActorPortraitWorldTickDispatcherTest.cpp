@@ -0,0 +1,97 @@
+// Copyright Mans Isaksson. All Rights Reserved.
+
+#include "ActorPortraitWorldTickDispatcher.h"
+#include "ActorPortraitScene.h"
+#include "InstanceWorld.h"
+
+#include "Engine/World.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace ActorPortraitWorldTickDispatcherTest
+{
+	static constexpr int32 NumFrames = 1000;
+
+	// Same signature as FWorldDelegates::OnWorldTickStart/End, broadcast locally so no other engine or editor listener runs
+	DECLARE_MULTICAST_DELEGATE_ThreeParams(FWorldTickEvent, UWorld*, ELevelTick, float);
+
+	// Returns the average time in seconds to broadcast the tick start and end events of every world for one frame
+	static double MeasureFrame(const FWorldTickEvent& OnWorldTickStart, const FWorldTickEvent& OnWorldTickEnd, TConstArrayView<UWorld*> Worlds)
+	{
+		const double StartTime = FPlatformTime::Seconds();
+
+		for (int32 Frame = 0; Frame < NumFrames; ++Frame)
+		{
+			for (UWorld* World : Worlds)
+			{
+				OnWorldTickStart.Broadcast(World, LEVELTICK_All, 0.016f);
+				OnWorldTickEnd.Broadcast(World, LEVELTICK_All, 0.016f);
+			}
+		}
+
+		return (FPlatformTime::Seconds() - StartTime) / NumFrames;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FActorPortraitWorldTickDispatchBenchmark, "ActorPortrait.Performance.WorldTickDispatch",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter)
+
+bool FActorPortraitWorldTickDispatchBenchmark::RunTest(const FString& Parameters)
+{
+	using namespace ActorPortraitWorldTickDispatcherTest;
+
+	// Scenes without a game instance, so their tick handlers don't swap any managers
+	const FInstanceWorld::ConstructionValues CVS = FActorPortraitScene::MakeConstructionValues(TSoftObjectPtr<UWorld>(), nullptr, nullptr, EPortraitWorldProfile::Minimal, nullptr)
+		.SetShouldTickWorld(false);
+
+	// Stands in for the game world, which ticks without a portrait scene
+	const TSharedRef<FInstanceWorld> GameWorld = MakeShared<FInstanceWorld>(CVS);
+
+	FActorPortraitWorldTickDispatcher& Dispatcher = FActorPortraitWorldTickDispatcher::Get();
+
+	for (const int32 NumPortraits : { 1, 10, 100 })
+	{
+		const int32 NumScenesBefore = Dispatcher.Num();
+
+		TArray<TSharedPtr<FActorPortraitScene>> Scenes;
+		TArray<UWorld*> Worlds = { GameWorld->GetWorld() };
+
+		for (int32 Index = 0; Index < NumPortraits; ++Index)
+		{
+			const TSharedPtr<FActorPortraitScene>& Scene = Scenes.Add_GetRef(MakeShared<FActorPortraitScene>(CVS, nullptr, nullptr));
+			Worlds.Add(Scene->GetWorld());
+		}
+
+		if (!TestEqual(TEXT("Portrait scenes registered with the dispatcher"), Dispatcher.Num(), NumScenesBefore + NumPortraits))
+		{
+			return false;
+		}
+
+		// Baseline, every scene bound its own handlers and was invoked for every world that ticked
+		FWorldTickEvent PerSceneTickStart, PerSceneTickEnd;
+		for (const TSharedPtr<FActorPortraitScene>& Scene : Scenes)
+		{
+			PerSceneTickStart.AddRaw(Scene.Get(), &FActorPortraitScene::OnWorldTickStart);
+			PerSceneTickEnd.AddRaw(Scene.Get(), &FActorPortraitScene::OnWorldTickEnd);
+		}
+
+		FWorldTickEvent DispatcherTickStart, DispatcherTickEnd;
+		DispatcherTickStart.AddRaw(&Dispatcher, &FActorPortraitWorldTickDispatcher::OnWorldTickStart);
+		DispatcherTickEnd.AddRaw(&Dispatcher, &FActorPortraitWorldTickDispatcher::OnWorldTickEnd);
+
+		const double PerSceneFrameTime   = MeasureFrame(PerSceneTickStart, PerSceneTickEnd, Worlds);
+		const double DispatcherFrameTime = MeasureFrame(DispatcherTickStart, DispatcherTickEnd, Worlds);
+
+		AddInfo(FString::Printf(TEXT("%3d portraits: %8.2f us per frame with per-scene handlers, %8.2f us with the dispatcher (%.1fx, %d frames)"), 
+			NumPortraits, PerSceneFrameTime * 1000000.0, DispatcherFrameTime * 1000000.0, PerSceneFrameTime / FMath::Max(DispatcherFrameTime, UE_DOUBLE_SMALL_NUMBER), NumFrames));
+
+		Scenes.Reset();
+
+		TestEqual(TEXT("Portrait scenes registered with the dispatcher after destroying them"), Dispatcher.Num(), NumScenesBefore);
+	}
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,114 @@
+// Copyright Mans Isaksson. All Rights Reserved.
+
+#include "InstanceWorld.h"
+#include "ActorPortraitModule.h"
+
+#include "Algo/Count.h"
+#include "Misc/AutomationTest.h"
+#include "UObject/UObjectGlobals.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace InstanceWorldGarbageCollectionTest
+{
+	static constexpr int32 NumInstanceWorlds = 16;
+
+	// Seconds to wait for the engine to run the requested garbage collection
+	static constexpr double CollectionTimeout = 10.0;
+}
+
+/**
+ * Waits for the next garbage collection after a batch of instance worlds was destroyed, then checks that the single collection
+ * purged every one of them.
+ */
+class FWaitForCoalescedGarbageCollectionCommand : public IAutomationLatentCommand
+{
+private:
+	FAutomationTestBase* Test;
+	TArray<TWeakObjectPtr<UWorld>> DestroyedWorlds;
+	TSharedRef<int32> NumCollections;
+	FDelegateHandle PostGarbageCollectHandle;
+	double StartTime;
+
+public:
+	FWaitForCoalescedGarbageCollectionCommand(FAutomationTestBase* InTest, TArray<TWeakObjectPtr<UWorld>>&& InDestroyedWorlds, const TSharedRef<int32>& InNumCollections, FDelegateHandle InPostGarbageCollectHandle)
+		: Test(InTest)
+		, DestroyedWorlds(MoveTemp(InDestroyedWorlds))
+		, NumCollections(InNumCollections)
+		, PostGarbageCollectHandle(InPostGarbageCollectHandle)
+		, StartTime(FPlatformTime::Seconds())
+	{
+	}
+
+	virtual ~FWaitForCoalescedGarbageCollectionCommand()
+	{
+		FCoreUObjectDelegates::GetPostGarbageCollect().Remove(PostGarbageCollectHandle);
+	}
+
+	virtual bool Update() override
+	{
+		if (*NumCollections == 0)
+		{
+			if (FPlatformTime::Seconds() - StartTime > InstanceWorldGarbageCollectionTest::CollectionTimeout)
+			{
+				Test->AddError(TEXT("No garbage collection was run after destroying the instance worlds"));
+				return true;
+			}
+
+			return false;
+		}
+
+		Test->TestEqual(TEXT("Garbage collections run for the destroyed instance worlds"), *NumCollections, 1);
+
+		const int32 NumWorldsLeft = Algo::CountIf(DestroyedWorlds, [](const TWeakObjectPtr<UWorld>& World) { return World.IsValid(true); });
+		Test->TestEqual(TEXT("Destroyed instance worlds left after the first garbage collection"), NumWorldsLeft, 0);
+
+		return true;
+	}
+};
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInstanceWorldCoalescedGarbageCollectionTest, "ActorPortrait.InstanceWorld.CoalescedGarbageCollection",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FInstanceWorldCoalescedGarbageCollectionTest::RunTest(const FString& Parameters)
+{
+	using namespace InstanceWorldGarbageCollectionTest;
+
+	if (FActorPortraitModule::IsEndingPlay())
+	{
+		AddError(TEXT("Instance worlds don't request a garbage collection while play is ending, run the test outside of play in editor"));
+		return false;
+	}
+
+	const FInstanceWorld::ConstructionValues CVS = FInstanceWorld::ConstructionValues()
+		.SetCreatePhysicsScene(false)
+		.SetShouldTickWorld(false);
+
+	TArray<TSharedPtr<FInstanceWorld>> InstanceWorlds;
+	TArray<TWeakObjectPtr<UWorld>> Worlds;
+
+	for (int32 Index = 0; Index < NumInstanceWorlds; ++Index)
+	{
+		TSharedPtr<FInstanceWorld>& InstanceWorld = InstanceWorlds.Add_GetRef(MakeShared<FInstanceWorld>(CVS));
+		Worlds.Add(InstanceWorld->GetWorld());
+	}
+
+	if (!TestEqual(TEXT("Created instance worlds"), Algo::CountIf(Worlds, [](const TWeakObjectPtr<UWorld>& World) { return World.IsValid(); }), NumInstanceWorlds))
+	{
+		return false;
+	}
+
+	TSharedRef<int32> NumCollections = MakeShared<int32>(0);
+	const FDelegateHandle PostGarbageCollectHandle = FCoreUObjectDelegates::GetPostGarbageCollect().AddLambda([NumCollections]() { (*NumCollections)++; });
+
+	// Destroy all instance worlds in the same frame, like when a list of portraits is closed
+	InstanceWorlds.Reset();
+
+	TestEqual(TEXT("Garbage collections forced while destroying the instance worlds"), *NumCollections, 0);
+
+	ADD_LATENT_AUTOMATION_COMMAND(FWaitForCoalescedGarbageCollectionCommand(this, MoveTemp(Worlds), NumCollections, PostGarbageCollectHandle));
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
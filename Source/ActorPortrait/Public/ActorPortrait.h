@@ -24,6 +24,8 @@ public:
 	
 	DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnSpawnPortraitActor, AActor*, Actor);
 	DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnCameraReset);
+	DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnPortraitSceneLoaded, bool, bSuccess);
+	DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnPortraitReady, bool, bTimedOut);
 
 private:
 	TSharedPtr<class SActorPortrait> ViewportWidget;
@@ -78,6 +80,10 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="Appearance", AdvancedDisplay)
 	FName TexureParameter;
 
+	// Brush drawn while the background world is loading asynchronously. Set Draw As to None to keep drawing the last rendered frame instead.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="Appearance", AdvancedDisplay)
+	FSlateBrush PlaceholderBrush;
+
 
 	// Toggles the portrait in the designer, useful for improving designer performance
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="Portrait")
@@ -111,14 +117,37 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="Portrait|Ticking")
 	bool bTickWorld;
 
+	// How many times per second to tick the portrait world, 0 ticks it every frame. Lower rates save game thread time on portraits where smooth motion isn't needed.
+	// Portraits on a shared stage tick the same world, it is ticked with the tick rate and time dilation of whichever of them ticks it first each frame.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="Portrait|Ticking", meta = (ClampMin = "0", UIMin = "0", UIMax = "60", EditCondition = "bTickWorld"))
+	float TickRate;
+
+	// Time dilation of the portrait world, values below 1 slow down animations and effects in the portrait. Clamped to the min and max global time dilation of the world settings.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="Portrait|Ticking", meta = (ClampMin = "0.0001", ClampMax = "20", UIMin = "0", UIMax = "4", EditCondition = "bTickWorld"))
+	float TimeDilation;
+
+	// Order in which plugin ticked portrait worlds (ActorPortrait.PluginTickedWorlds) are ticked each frame, higher priorities tick first
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="Portrait|Ticking", meta = (EditCondition = "bTickWorld"))
+	int32 TickPriority;
+
 	// Whether to redraw the portrait each frame
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="Portrait|Rendering")
 	bool bIsRealTime;
 
+	// How many times per second to redraw a real-time portrait at most, 0 redraws it every frame. The redraws of capped portraits are staggered over the frames,
+	// so ten portraits capped at 15 Hz cost about as much as 150 captures per second spread evenly, instead of ten captures every frame. The last capture is shown in between.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="Portrait|Rendering", meta = (ClampMin = "0", UIMin = "0", UIMax = "60", EditCondition = "bIsRealTime"))
+	float MaxCaptureRate;
+
 	// The capture source used by the portrait to render the scene
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="Portrait|Rendering")
 	TEnumAsByte<enum ESceneCaptureSource> CaptureSource;
 
+	// Pixel format of the render target the portrait is captured into. Auto picks the format from the capture source, pick a smaller format to save memory on small icons
+	// or a float format to keep the range of HDR capture sources. See GetRenderTargetMemorySize for the memory used by the portrait.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="Portrait|Rendering")
+	EPortraitRenderTargetFormat RenderTargetFormat;
+
 	// Post processing settings to use for the capture component.
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="Portrait|Rendering")
 	FPostProcessSettings PostProcessingSettings;
@@ -163,6 +192,48 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Portrait", AdvancedDisplay)
 	TSoftObjectPtr<UWorld> BackgroundWorldAsset;
 
+	// Background world baked into a cube map, used instead of BackgroundWorldAsset once it has been baked. No background world is loaded,
+	// the baked cube map replaces the environment cube map of the user data (UPortraitEnvironmentSettings) at runtime and is rendered by the sky sphere.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Portrait", AdvancedDisplay)
+	TObjectPtr<class UPortraitBakedBackdrop> BakedBackdrop;
+
+	// Whether to load the background world asynchronously. The portrait actor is spawned once loading has completed, and PlaceholderBrush is drawn in the meantime.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Portrait", AdvancedDisplay)
+	bool bLoadBackgroundWorldAsync;
+
+	// Whether to hold off capturing the portrait until the sub-levels of the background world have streamed in, PlaceholderBrush is drawn in the meantime.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Portrait", AdvancedDisplay)
+	bool bWaitForStreamingLevels;
+
+	// Seconds to wait for the sub-levels of the background world to stream in before capturing the portrait anyway. Set to 0 to wait indefinitely.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Portrait", AdvancedDisplay, meta = (EditCondition = "bWaitForStreamingLevels", ClampMin = "0", Units = "s"))
+	float StreamingLevelsTimeout;
+
+	// Portraits with the same shared stage name are placed in one shared portrait world instead of each creating their own, each rendered by its own capture component.
+	// Only portraits with equal light templates share a stage, since the lights are stage wide. Ignored for portraits with a background world, which always get their own world.
+	// Leave as None to give this portrait its own world.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Portrait", AdvancedDisplay)
+	FName SharedStageName;
+
+	// Which engine subsystems (physics, FX, AI and navigation) to create for the portrait world. Minimal and Auto make portrait worlds cheaper to create for actors which don't need them.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Portrait", AdvancedDisplay)
+	EPortraitWorldProfile WorldProfile;
+
+	// Whether to unregister the background world primitives which can't be seen from anywhere the camera can orbit or zoom to, once the camera has framed the portrait actor.
+	// The reachable camera locations are taken from the camera orbit origin and MaxZoomDistance. Background actors with all of their primitives pruned stop ticking. Ignored on shared stages.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Portrait", AdvancedDisplay)
+	bool bPruneBackgroundActors;
+
+	// Background primitives further than this from the reachable camera locations are pruned, primitives beyond their own max draw distance are always pruned. Set to 0 to only prune those.
+	// This is a plain distance cut in every direction, distant scenery the camera can see (horizon meshes, mountains) is pruned too. Pruned primitives also lose their collision.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Portrait", AdvancedDisplay, meta = (EditCondition = "bPruneBackgroundActors", ClampMin = "0", Units = "cm"))
+	float BackgroundPruneDistance;
+
+	// Whether to draw the portrait from a render target shared with other portraits (the portrait atlas), so Slate can draw the portraits sharing it in a single batch.
+	// Worthwhile for many portraits on screen at once, such as an inventory grid. The portrait is copied into the atlas after each capture. Ignored when using a render material.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Portrait", AdvancedDisplay)
+	bool bRenderToAtlas;
+
 public:
 
 	UPROPERTY(EditAnywhere, Category=Events, meta=( IsBindableEvent="True" ))
@@ -216,6 +287,16 @@ public:
 	UPROPERTY(BlueprintAssignable, Category=Events)
 	FOnCameraReset PostCameraResetEvent;
 
+	// Called once the portrait scene has been created and the portrait actor has been spawned.
+	// When loading the background world asynchronously this is called once loading has completed, bSuccess is false if the world failed to load.
+	UPROPERTY(BlueprintAssignable, Category=Events)
+	FOnPortraitSceneLoaded OnPortraitSceneLoadedEvent;
+
+	// Called once the sub-levels of the background world have streamed in and the portrait starts being captured, useful to fade the portrait in.
+	// bTimedOut is true if StreamingLevelsTimeout was reached before all sub-levels had streamed in.
+	UPROPERTY(BlueprintAssignable, Category=Events)
+	FOnPortraitReady OnPortraitReadyEvent;
+
 public:
 
 	UActorPortrait();
@@ -224,6 +305,22 @@ public:
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Portrait Widget|Scene")
 	UWorld* GetPortraitWorld() const;
 
+	// Returns true while the background world is being loaded asynchronously
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Portrait Widget|Scene")
+	bool IsPortraitSceneLoading() const;
+
+	// Creates portrait worlds ahead of time and places them in the scene pool, so that portraits using the same background world, world profile and actor class adopt them instead of creating a new world.
+	// The worlds are created synchronously, call this while a loading screen is shown. Uses the default sky sphere if SkySphereClass is not set. Returns the number of created worlds.
+	UFUNCTION(BlueprintCallable, Category = "Portrait Widget|Scene", meta = (WorldContext = "WorldContextObject"))
+	static int32 PrewarmPortraitScenes(UObject* WorldContextObject, TSoftObjectPtr<UWorld> BackgroundWorld, TSubclassOf<AActor> PortraitActorClass, TSubclassOf<AActor> PortraitSkySphereClass, EPortraitWorldProfile PortraitWorldProfile, int32 NumScenes = 1);
+
+	// Prewarms the portrait worlds listed in the project settings for the map which has just been loaded
+	static void PrewarmPortraitScenesFromSettings(UWorld* LoadedWorld);
+
+	// Returns true once the background world and its sub-levels have finished loading and the portrait is being captured
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Portrait Widget|Scene")
+	bool IsPortraitReady() const;
+
 	// Returns sky sphere actor from the portrait world, nullptr if there is none
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Portrait Widget|Scene")
 	AActor* GetPortraitSkySphereActor() const;
@@ -264,14 +361,38 @@ public:
 	UFUNCTION(BlueprintCallable, Category="Portrait Widget|Ticking")
 	void SetTickWorld(bool bInTickWorld);
 
+	// Set how many times per second the portrait world should tick, 0 ticks it every frame
+	UFUNCTION(BlueprintCallable, Category="Portrait Widget|Ticking")
+	void SetTickRate(float InTickRate);
+
+	// Set the time dilation of the portrait world
+	UFUNCTION(BlueprintCallable, Category="Portrait Widget|Ticking")
+	void SetTimeDilation(float InTimeDilation);
+
+	// Set the order in which plugin ticked portrait worlds are ticked, higher priorities tick first
+	UFUNCTION(BlueprintCallable, Category="Portrait Widget|Ticking")
+	void SetTickPriority(int32 InTickPriority);
+
 	// Set whether this portrait should update in real time. If true, the portrait will re-draw whenever the widget is updated
 	UFUNCTION(BlueprintCallable, Category="Portrait Widget|Rendering")
 	void SetIsRealTime(bool bInIsRealTime);
 
+	// Set how many times per second a real-time portrait is redrawn at most, 0 redraws it every frame
+	UFUNCTION(BlueprintCallable, Category="Portrait Widget|Rendering")
+	void SetMaxCaptureRate(float InMaxCaptureRate);
+
 	// Set the capture source used by the capture component to draw the portrait world
 	UFUNCTION(BlueprintCallable, Category="Portrait Widget|Rendering")
 	void SetCaptureSource(ESceneCaptureSource InCaptureSource);
 
+	// Set the pixel format of the render target the portrait is captured into
+	UFUNCTION(BlueprintCallable, Category="Portrait Widget|Rendering")
+	void SetRenderTargetFormat(EPortraitRenderTargetFormat InRenderTargetFormat);
+
+	// Returns the video memory (in bytes) used by the render target of the portrait, including its share of the atlas when rendering to the atlas
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Portrait Widget|Rendering")
+	int64 GetRenderTargetMemorySize() const;
+
 
 	/** 
 	* Set currently viewed actor class. If the class is different from the currently viewed actor class, the actor will be re-created. 
@@ -311,6 +432,15 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Portrait Widget|Scene")
 	void SetPortraitBackgroundWorld(TSoftObjectPtr<UWorld> NewBackgroundWorldAsset);
 
+	/** 
+	* Set the baked backdrop to use instead of the background world.
+	* IMPORTANT: If the backdrop changes, the portrait scene will be re-created, incuding the portrait actor, and any other actors in the world.
+	* 
+	* @param NewBakedBackdrop  The new baked backdrop, nullptr to use the background world
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Portrait Widget|Scene")
+	void SetPortraitBakedBackdrop(class UPortraitBakedBackdrop* NewBakedBackdrop);
+
 	// Applies any changes to the user data. Will cause the sky to be re-captured
 	UFUNCTION(BlueprintCallable, Category = "Portrait Widget|Scene")
 	void ApplyUserData();
@@ -407,7 +537,21 @@ protected:
 
 private:
 
+	UPROPERTY(Transient)
+	TObjectPtr<UObject> BakedBackdropUserData;
+
+	// User data and backdrop cube map BakedBackdropUserData was copied from, the copy is only rebuilt when one of them changes
+	TWeakObjectPtr<UObject> BakedBackdropUserDataSource;
+	TWeakObjectPtr<class UTextureCube> BakedBackdropUserDataCubeMap;
+
 	void RecreateUserData();
 
+	// The background world to load, none when the portrait uses a baked backdrop
+	TSoftObjectPtr<UWorld> GetPortraitWorldAsset() const;
+
+	// The user data to hand to the portrait, a transient copy of the user data with its environment cube map replaced by the baked backdrop when there is one.
+	// The copy is cached, bUserDataEdited re-copies it after the properties of the user data have been changed.
+	UObject* GetPortraitUserData(bool bUserDataEdited = false);
+
 	UGameInstance* GetOwningGameInstance() const;
 };
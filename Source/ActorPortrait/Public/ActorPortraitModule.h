@@ -3,9 +3,12 @@
 #pragma once
 
 #include "Modules/ModuleManager.h"
+#include "Stats/Stats.h"
 
 DECLARE_LOG_CATEGORY_EXTERN(LogActorPortrait, Log, All);
 
+DECLARE_STATS_GROUP(TEXT("ActorPortrait"), STATGROUP_ActorPortrait, STATCAT_Advanced);
+
 class FActorPortraitModule : public IModuleInterface
 {
 private:
@@ -22,4 +25,5 @@ public:
 	void OnApplicationQuit();
 	void OnPrePIEEnded(bool bIsSimulatingInEditor);
 	void OnEndPlayMap();
+	void OnPostLoadMapWithWorld(class UWorld* LoadedWorld);
 };
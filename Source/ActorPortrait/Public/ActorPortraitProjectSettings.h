@@ -0,0 +1,141 @@
+// Copyright Mans Isaksson. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DeveloperSettings.h"
+#include "GameFramework/Actor.h"
+#include "ActorPortraitSettings.h"
+
+#include "ActorPortraitProjectSettings.generated.h"
+
+USTRUCT()
+struct ACTORPORTRAIT_API FPortraitPrewarmSettings
+{
+	GENERATED_BODY()
+
+	// Background world of the portraits to prewarm worlds for
+	UPROPERTY(EditAnywhere, Category="Prewarm")
+	TSoftObjectPtr<UWorld> BackgroundWorld;
+
+	// Class of the portrait actor, decides which engine subsystems are created when using the Auto world profile
+	UPROPERTY(EditAnywhere, Category="Prewarm")
+	TSoftClassPtr<AActor> ActorClass;
+
+	// Sky sphere class of the portraits, decides which engine subsystems are created when using the Auto world profile. Uses the default sky sphere if not set.
+	UPROPERTY(EditAnywhere, Category="Prewarm")
+	TSoftClassPtr<AActor> SkySphereClass;
+
+	// World profile of the portraits, prewarmed worlds are only adopted by portraits using the same profile
+	UPROPERTY(EditAnywhere, Category="Prewarm")
+	EPortraitWorldProfile WorldProfile = EPortraitWorldProfile::Full;
+
+	// Number of portrait worlds to keep ready, limited by MaxPooledScenesPerWorld
+	UPROPERTY(EditAnywhere, Category="Prewarm", meta=(ClampMin="1"))
+	int32 NumScenes = 1;
+
+	// The worlds are prewarmed when one of these maps has finished loading, or when any game map has finished loading if empty
+	UPROPERTY(EditAnywhere, Category="Prewarm")
+	TArray<TSoftObjectPtr<UWorld>> PrewarmOnMaps;
+};
+
+UCLASS(config=Game, defaultconfig, meta=(DisplayName="Actor Portrait"))
+class ACTORPORTRAIT_API UActorPortraitProjectSettings : public UDeveloperSettings
+{
+	GENERATED_BODY()
+public:
+	UActorPortraitProjectSettings();
+
+	// Whether portrait worlds should be kept in a pool when their widget is destroyed, so that new portraits using the same background world can re-use them instead of creating a new world.
+	UPROPERTY(config, EditAnywhere, Category="Scene Pooling")
+	bool bEnableScenePooling;
+
+	// The maximum number of unused portrait worlds kept in the pool. The least recently used world is destroyed when the pool is full.
+	UPROPERTY(config, EditAnywhere, Category="Scene Pooling", meta=(EditCondition="bEnableScenePooling", ClampMin="0"))
+	int32 MaxPooledScenes;
+
+	// The maximum number of unused portrait worlds kept in the pool for a single background world.
+	UPROPERTY(config, EditAnywhere, Category="Scene Pooling", meta=(EditCondition="bEnableScenePooling", ClampMin="0"))
+	int32 MaxPooledScenesPerWorld;
+
+	// Time (in seconds) an unused portrait world is kept in the pool before it is destroyed. Set to 0 to keep pooled worlds until the pool is full.
+	UPROPERTY(config, EditAnywhere, Category="Scene Pooling", meta=(EditCondition="bEnableScenePooling", ClampMin="0", Units="s"))
+	float PooledSceneIdleTimeout;
+
+	// Whether background worlds should be loaded once into a template world which is then duplicated in memory for every portrait using it, instead of loading the world package for every portrait.
+	UPROPERTY(config, EditAnywhere, Category="Background Worlds")
+	bool bUseBackgroundWorldTemplates;
+
+	// Time (in seconds) a template world is kept loaded after the last portrait using it was destroyed, so portraits which are re-created shortly after (e.g. by list views) 
+	// don't load the background world again. Set to 0 to unload templates as soon as they are unused.
+	UPROPERTY(config, EditAnywhere, Category="Background Worlds", meta=(EditCondition="bUseBackgroundWorldTemplates", ClampMin="0", Units="s"))
+	float BackgroundWorldTemplateIdleTimeout;
+
+	// Portrait worlds to create while a map is loading and place in the pool, so portraits created later on can adopt them instead of creating their world when the widget is built.
+	// Light templates don't need to match, they are applied when a portrait adopts the world.
+	UPROPERTY(config, EditAnywhere, Category="Scene Pooling", meta=(EditCondition="bEnableScenePooling"))
+	TArray<FPortraitPrewarmSettings> PrewarmedScenes;
+
+	// Distance between the portraits sharing a stage, large enough that their actors don't light, shadow or reflect each other.
+	// Portraits with a background world don't share stages, since the background can't be placed at every slot.
+	UPROPERTY(config, EditAnywhere, Category="Shared Stages", meta=(ClampMin="0", Units="cm"))
+	float SharedStageSlotSpacing;
+
+	// Time (in milliseconds) per frame spent constructing portrait scenes. Construction is split into stages (creating and initializing the world, 
+	// initializing its actors, begin play, spawning the portrait actor) which are spread over several frames within this budget. Set to 0 to construct portrait scenes in a single frame, 2 ms is a good starting point otherwise.
+	UPROPERTY(config, EditAnywhere, Category="Scene Construction", meta=(ClampMin="0", Units="ms"))
+	float SceneConstructionTimeBudget;
+
+	// Time (in milliseconds) per frame spent tearing down portrait scenes which are no longer used and can't be pooled. Teardown is split into stages 
+	// (destroying components, end play, destroying the world) which are spread over several frames within this budget. Set to 0 to destroy portrait scenes right away.
+	UPROPERTY(config, EditAnywhere, Category="Scene Construction", meta=(ClampMin="0", Units="ms"))
+	float SceneTeardownTimeBudget;
+
+	// Whether render targets of destroyed portraits should be kept in a pool, so that new portraits rendering at a similar size can re-use them instead of creating a new render target.
+	UPROPERTY(config, EditAnywhere, Category="Render Target Pooling")
+	bool bEnableRenderTargetPooling;
+
+	// When above 0, portrait render targets are allocated in multiples of this size (in pixels) and the portrait is rendered into the top left part of its render target.
+	// Larger buckets make pooled render targets more likely to be re-used, at the cost of unused pixels. The unused part is still rendered every capture, showing the
+	// scene beyond the edges of the portrait, which costs up to one bucket of extra shading and is seen by whole-image post processing (auto exposure, bloom, temporal AA),
+	// so portraits can look different than with an exact size render target. 0 (the default) allocates render targets of the exact portrait size, which are still pooled.
+	UPROPERTY(config, EditAnywhere, Category="Render Target Pooling", meta=(ClampMin="0", ClampMax="1024"))
+	int32 RenderTargetPoolBucketSize;
+
+	// The maximum number of unused render targets kept in the pool. The least recently used render target is destroyed when the pool is full.
+	UPROPERTY(config, EditAnywhere, Category="Render Target Pooling", meta=(EditCondition="bEnableRenderTargetPooling", ClampMin="0"))
+	int32 MaxPooledRenderTargets;
+
+	// Time (in seconds) an unused render target is kept in the pool before it is destroyed. Set to 0 to keep pooled render targets until the pool is full.
+	UPROPERTY(config, EditAnywhere, Category="Render Target Pooling", meta=(EditCondition="bEnableRenderTargetPooling", ClampMin="0", Units="s"))
+	float PooledRenderTargetIdleTimeout;
+
+	// Size (in pixels) of the first page of the portrait atlas, pages grow when a portrait doesn't fit. Only used by portraits rendering to the atlas.
+	UPROPERTY(config, EditAnywhere, Category="Portrait Atlas", meta=(ClampMin="64", ClampMax="8192"))
+	int32 AtlasInitialPageSize;
+
+	// Size (in pixels) atlas pages can grow to, a new page is created once a page of this size is full. Portraits larger than this don't render to the atlas.
+	UPROPERTY(config, EditAnywhere, Category="Portrait Atlas", meta=(ClampMin="64", ClampMax="8192"))
+	int32 AtlasMaxPageSize;
+
+	// Empty pixels (per side) around every portrait in the atlas, so filtering doesn't blend neighbouring portraits
+	UPROPERTY(config, EditAnywhere, Category="Portrait Atlas", meta=(ClampMin="0", ClampMax="16"))
+	int32 AtlasPadding;
+
+	// Whether portraits which haven't been painted for a few frames stop capturing and ticking their world until they are painted again.
+	// Portraits are considered hidden when Slate skips painting them (clipped out of a scroll box, collapsed, in a minimized window) or when they are painted fully transparent.
+	UPROPERTY(config, EditAnywhere, Category="Hidden Portraits")
+	bool bPauseHiddenPortraits;
+
+	// Number of frames a portrait has to go unpainted before it is paused, so portraits flickering in and out of view aren't paused every other frame
+	UPROPERTY(config, EditAnywhere, Category="Hidden Portraits", meta=(EditCondition="bPauseHiddenPortraits", ClampMin="1"))
+	int32 HiddenPortraitGraceFrames;
+
+	// Whether paused portraits return their render target to the render target pool. Saves memory, but the portrait has to be captured again before it shows up once it's visible.
+	UPROPERTY(config, EditAnywhere, Category="Hidden Portraits", meta=(EditCondition="bPauseHiddenPortraits"))
+	bool bReleaseHiddenPortraitRenderTargets;
+
+	virtual FName GetCategoryName() const override { return TEXT("Plugins"); }
+
+	static const UActorPortraitProjectSettings& Get() { return *GetDefault<UActorPortraitProjectSettings>(); }
+};
@@ -2,10 +2,19 @@
 
 #pragma once
 #include "InstanceWorld.h"
+#include "UObject/ObjectKey.h"
 #include "ActorPortraitInterface.h"
+#include "ActorPortraitSettings.h"
 
 class FActorPortraitScene : public FInstanceWorld
 {
+	friend class FActorPortraitWorldTickDispatcher;
+	friend class FActorPortraitWorldTickDispatchBenchmark;
+	friend class FActorPortraitTickManager;
+
+public:
+	DECLARE_MULTICAST_DELEGATE_OneParam(FOnPortraitSceneLoaded, bool /*bSuccess*/);
+
 private:
 	TObjectPtr<class UDirectionalLightComponent> DirectionalLightComponent = nullptr;
 	TObjectPtr<class USkyLightComponent> SkyLightComponent = nullptr;
@@ -14,11 +23,56 @@ private:
 	struct FLatentActionManager* LatentActionManagerToRestore = nullptr;
 	class FTimerManager* TimerManagerToRestore = nullptr;
 
+	// Actors which were part of the world when it was created, these are kept when the scene is returned to the pool
+	TSet<TObjectKey<AActor>> BackgroundActors;
+
+	// Background primitives unregistered by PruneBackgroundPrimitives, and background actors whose tick was disabled because all their primitives were pruned
+	TSet<TObjectKey<UPrimitiveComponent>> PrunedBackgroundPrimitives;
+	TSet<TObjectKey<AActor>> PrunedBackgroundActors;
+
+	// Light templates applied once an asynchronously loaded world has finished loading
+	TObjectPtr<UDirectionalLightComponent> PendingDirLightTemplate = nullptr;
+	TObjectPtr<USkyLightComponent> PendingSkyLightTemplate = nullptr;
+
+	// Shared stage state, a shared stage hosts several portraits which each get their own slot and capture component
+	bool bIsSharedStage = false;
+	TBitArray<> UsedStageSlots;
+	TObjectPtr<AActor> StageSkySphereActor = nullptr;
+
+	// Primitive components of portrait actors whose registration was deferred until the actor has finished spawning
+	TMap<TObjectKey<AActor>, TArray<TWeakObjectPtr<UPrimitiveComponent>>> DeferredComponentRegistrations;
+
+	// Frame (GFrameCounter) in which the scene was last prepared for capture and ticked, used to only do it once per frame for shared stages
+	uint64 LastCaptureFrame = 0;
+	uint64 LastTickFrame = 0;
+	uint64 LastStreamingUpdateFrame = 0;
+
+	// Time passed since the world was last ticked when the tick rate is throttled
+	float TickAccumulator = 0.f;
+
+	// Tick settings from the last TickScene call, used by FActorPortraitTickManager to tick worlds without an engine world context
+	float RequestedTickRate = 0.f;
+	int32 TickPriority = 0;
+
+	FOnPortraitSceneLoaded OnPortraitSceneLoaded;
+
 public:
-	FActorPortraitScene(const TSoftObjectPtr<UWorld> &WorldAsset, UDirectionalLightComponent* DirLightTemplate, USkyLightComponent* SkyLightTemplate, bool bShouldTick, UGameInstance* OwningGameInstance);
+	FActorPortraitScene(const FInstanceWorld::ConstructionValues& CVS, UDirectionalLightComponent* DirLightTemplate, USkyLightComponent* SkyLightTemplate);
 
 	virtual ~FActorPortraitScene();
 
+	// Removes everything spawned into the scene after it was created so that it can be stored in the scene pool
+	void PrepareForPooling();
+
+	// Prepares a pooled scene to be used by a new portrait
+	void PrepareForReuse(UDirectionalLightComponent* DirLightTemplate, USkyLightComponent* SkyLightTemplate, bool bShouldTick);
+
+	// Broadcast once an asynchronously loaded scene has finished loading
+	FORCEINLINE FOnPortraitSceneLoaded& OnSceneLoaded() { return OnPortraitSceneLoaded; }
+
+	/** Advances the streaming of the world's sub-levels (at most once per frame), returns true once they have all been loaded and made visible */
+	bool UpdateStreamingLevels();
+
 	void ApplyDirectionalLightTemplate(UDirectionalLightComponent* DirLightTemplate);
 
 	void ApplySkyLightTemplate(USkyLightComponent* SkyLightTemplate);
@@ -27,9 +81,64 @@ public:
 
 	void UpdateCaptureComponentCaptureContents();
 
-#if WITH_EDITOR
-	void EditorTick(float DeltaTime);
-#endif
+	// Captures the scene using the supplied capture component, the scene is only prepared for capture once per frame no matter how many components are captured
+	void UpdateCaptureContents(class USceneCaptureComponent2D* InCaptureComponent);
+
+	// Captures the scene with all of the supplied capture components, submitted together through one scene render builder
+	void UpdateCaptureContents(TConstArrayView<class USceneCaptureComponent2D*> InCaptureComponents);
+
+	// Creates a new capture component set up for rendering a portrait
+	class USceneCaptureComponent2D* CreateCaptureComponent();
+
+	void DestroyCaptureComponent(class USceneCaptureComponent2D* InCaptureComponent);
+
+	FORCEINLINE bool IsSharedStage() const { return bIsSharedStage; }
+
+	FORCEINLINE void SetIsSharedStage(bool bInIsSharedStage) { bIsSharedStage = bInIsSharedStage; }
+
+	// Reserves a slot on the stage for a portrait, see GetStageSlotLocation
+	int32 AcquireStageSlot();
+
+	void ReleaseStageSlot(int32 Slot);
+
+	// Every slot has its own location, SharedStageSlotSpacing apart, so the portraits don't light each other. Portraits with a background world never share a stage.
+	FVector GetStageSlotLocation(int32 Slot) const;
+
+	// Hash of the light template properties applied to the scene, equal for templates which light the scene the same way
+	static uint32 GetLightTemplatesHash(UDirectionalLightComponent* DirLightTemplate, USkyLightComponent* SkyLightTemplate);
+
+	// Returns the sky sphere shared by all portraits on the stage, spawning it if it doesn't exist or is of a different class
+	AActor* GetOrSpawnStageSkySphere(UClass* SkySphereClass);
+
+	FORCEINLINE const TSet<TObjectKey<AActor>>& GetBackgroundActors() const { return BackgroundActors; }
+
+	// Unregisters the primitives of the background actors which can't be seen from any camera location inside CameraVolume, either because they are further away
+	// than PruneDistance (0 to ignore) or than their own max draw distance. Background actors with all of their primitives pruned stop ticking.
+	// Primitives which are back in reach since the previous call are registered again. Does nothing for shared stages, which are seen by several cameras.
+	void PruneBackgroundPrimitives(const FSphere& CameraVolume, float PruneDistance);
+
+	// Registers all primitives unregistered by PruneBackgroundPrimitives again
+	void RestorePrunedBackgroundPrimitives();
+
+	// Construction values of the portrait world for a portrait of ActorClass, this is what decides which pooled scenes a portrait can re-use
+	static FInstanceWorld::ConstructionValues MakeConstructionValues(const TSoftObjectPtr<UWorld>& WorldAsset, UClass* ActorClass, UClass* SkySphereClass, EPortraitWorldProfile WorldProfile, class UGameInstance* OwningGameInstance);
+
+	// Sets which engine subsystems to create for the portrait world based on the world profile and the actor classes which will be spawned into it
+	static void ApplyWorldProfile(FInstanceWorld::ConstructionValues& CVS, EPortraitWorldProfile WorldProfile, UClass* ActorClass, UClass* SkySphereClass);
+
+	// Returns true if the construction values create all the engine subsystems needed by the actor class
+	static bool SupportsActorClass(const FInstanceWorld::ConstructionValues& CVS, UClass* ActorClass);
+
+	// Ticks the world at most TickRate times per second (0 ticks every frame) with DeltaSeconds scaled by TimeDilation. Every frame 
+	// is accumulated into the next tick. The world is ticked manually in the editor, and in non-editor builds when the tick rate is throttled.
+	// Plugin ticked worlds are instead ticked by FActorPortraitTickManager, in order of TickPriority (highest first).
+	// A shared stage is only ticked once per frame, with the settings of the first of its portraits to tick it that frame.
+	void TickScene(float DeltaTime, bool bShouldTick, float TickRate, float TimeDilation, int32 InTickPriority = 0);
+
+	// True if the world has no engine world context and is ticked by FActorPortraitTickManager
+	FORCEINLINE bool IsPluginTicked() const { return !GetConstructionValues().bUseEngineWorldContext; }
+
+	FORCEINLINE int32 GetTickPriority() const { return TickPriority; }
 
 	FORCEINLINE class UDirectionalLightComponent* GetDirectionalLightComponent() const { return DirectionalLightComponent; }
 	FORCEINLINE class USkyLightComponent* GetSkyLightComponent() const { return SkyLightComponent; }
@@ -58,7 +167,13 @@ public:
 		const bool bShouldFinishSpawning = !SpawnParameters.bDeferConstruction;
 		SpawnParameters.bDeferConstruction = true;
 
+		DeferComponentRegistration(SpawnParameters);
+
 		AActor* SpawnedActor = PortraitWorld->SpawnActor(Class, &Transform, SpawnParameters);
+
+		// Construction is always deferred, so the deferred components are registered before the construction script and before the actor initializes its components
+		RegisterDeferredComponents(SpawnedActor);
+
 		if (SpawnedActor != nullptr && SpawnedActor->Implements<UActorPortraitInterface>())
 		{
 			IActorPortraitInterface::Execute_PreSpawnActorInPortraitScene(SpawnedActor);
@@ -88,12 +203,43 @@ public:
 	virtual void AddReferencedObjects(FReferenceCollector& Collector) override;
 	// ~End FGCObject interface
 
+protected:
+
+	// ~Begin FInstanceWorld interface
+	virtual void OnWorldLoaded() override;
+	virtual void OnBeginTeardown() override;
+	// ~End FInstanceWorld interface
+
 private:
 
+	void InitializeScene(UDirectionalLightComponent* DirLightTemplate, USkyLightComponent* SkyLightTemplate);
+
+	/** When batched portrait actor registration is enabled, keeps the native primitive components of the spawned actor from registering one by one in SpawnActor */
+	void DeferComponentRegistration(FActorSpawnParameters& SpawnParameters);
+
+	/** Registers the primitive components deferred by DeferComponentRegistration in a single batch, creating their scene proxies in parallel */
+	void RegisterDeferredComponents(AActor* Actor);
+
 	static const TSet<FName>& PropertyBlacklist();
 
+	// Engine subsystems needed by the default components of an actor class
+	struct FActorClassRequirements
+	{
+		bool bNeedsPhysics = false;
+		bool bNeedsFX = false;
+		bool bNeedsAI = false;
+	};
+
+	static FActorClassRequirements GetActorClassRequirements(UClass* ActorClass);
+
 	static void CopyObjectProperties(UObject* Dest, UObject* Src, const TSet<FName>& PropertyBlackList);
 
 	void OnWorldTickStart(UWorld* InWorld, ELevelTick TickType, float DeltaSeconds);
 	void OnWorldTickEnd(UWorld* InWorld, ELevelTick TickType, float DeltaSeconds);
+
+	// Called by FActorPortraitTickManager once per frame for plugin ticked worlds
+	void TickManaged(float DeltaTime);
+
+	// Adds DeltaTime to the tick accumulator, returns true and the time to tick the world by once a tick is due at TickRate
+	bool ConsumeTickTime(float DeltaTime, float TickRate, float& OutTickDeltaTime);
 };
\ No newline at end of file
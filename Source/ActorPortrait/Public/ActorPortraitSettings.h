@@ -55,6 +55,35 @@ enum class EPortraitCameraFitMode : uint8
 	FitY   UMETA(DisplayName="Fit Y"),
 };
 
+UENUM(BlueprintType)
+enum class EPortraitWorldProfile : uint8
+{
+	// Creates the portrait world with physics, FX, AI and navigation
+	Full    UMETA(DisplayName="Full"),
+	// Creates the portrait world without physics, FX, AI or navigation, for portraits of static actors
+	Minimal UMETA(DisplayName="Minimal"),
+	// Only creates the engine subsystems needed by the components of the portrait actor and sky sphere classes
+	Auto    UMETA(DisplayName="Auto"),
+};
+
+UENUM(BlueprintType)
+enum class EPortraitRenderTargetFormat : uint8
+{
+	// Picks the format from the capture source, 16-bit float for scene color, 32-bit float for depth and 8-bit sRGB for everything else, including HDR final color.
+	// Pick RGBA16F to keep the range above 1 of FinalColorHDR and FinalToneCurveHDR, at twice the memory.
+	Auto    UMETA(DisplayName="Auto"),
+	// 8-bit sRGB color with alpha, 4 bytes per pixel
+	RGBA8   UMETA(DisplayName="RGBA8 (sRGB)"),
+	// 10-bit linear color with 2-bit alpha, 4 bytes per pixel. Only suitable for portraits with an opaque background.
+	RGB10A2 UMETA(DisplayName="RGB10A2"),
+	// 16-bit float color with alpha, 8 bytes per pixel. Keeps the range of HDR capture sources.
+	RGBA16F UMETA(DisplayName="RGBA16F"),
+	// Single 8-bit channel, 1 byte per pixel. Only keeps the red channel, for masks and silhouettes drawn through a render material.
+	R8      UMETA(DisplayName="R8 (Mask)"),
+	// Single 16-bit float channel, 2 bytes per pixel. Only keeps the red channel, for depth and other single channel capture sources.
+	R16F    UMETA(DisplayName="R16F (Mask)"),
+};
+
 USTRUCT(BlueprintType, meta=(HiddenByDefault))
 struct FPortraitCameraSettings
 {
@@ -0,0 +1,46 @@
+// Copyright Mans Isaksson. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+
+#include "PortraitBakedBackdrop.generated.h"
+
+class UTextureCube;
+
+// A background world baked into a cube map, portraits using a baked backdrop render it through the sky sphere instead of loading the background world.
+// Only suitable for backgrounds which never move relative to the portrait, bake the backdrop from the editor (Bake) or with the PortraitBakeBackdrops commandlet.
+UCLASS(BlueprintType)
+class ACTORPORTRAIT_API UPortraitBakedBackdrop : public UDataAsset
+{
+	GENERATED_BODY()
+public:
+
+#if WITH_EDITORONLY_DATA
+	// The world to bake, only referenced in the editor so the world isn't cooked because of the backdrop
+	UPROPERTY(EditAnywhere, Category="Backdrop")
+	TSoftObjectPtr<UWorld> SourceWorld;
+
+	// Location in the source world the backdrop is captured from, this should be where the portrait actor is placed (the world origin by default)
+	UPROPERTY(EditAnywhere, Category="Backdrop")
+	FVector CaptureLocation = FVector::ZeroVector;
+
+	// Resolution of each face of the baked cube map
+	UPROPERTY(EditAnywhere, Category="Backdrop", meta=(ClampMin="16", ClampMax="4096"))
+	int32 Resolution = 1024;
+#endif
+
+	// The baked cube map, used as the environment cube map of the portrait sky sphere
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Backdrop")
+	TObjectPtr<UTextureCube> CubeMap = nullptr;
+
+#if WITH_EDITOR
+	// Captures SourceWorld into CubeMap, returns false if the world could not be loaded. The asset needs to be saved afterwards.
+	bool BakeBackdrop();
+
+	// Bakes the backdrop from the source world
+	UFUNCTION(CallInEditor, Category="Backdrop", meta=(DisplayName="Bake"))
+	void Bake();
+#endif
+};
@@ -7,12 +7,13 @@
 #include "ActorPortraitSettings.h"
 #include "Widgets/DeclarativeSyntaxSupport.h"
 #include "Engine/EngineBaseTypes.h"
-#include "Templates/PimplPtr.h"
 
 class UDirectionalLightComponent;
 class USkyLightComponent;
 class USceneCaptureComponent2D;
+class UTextureRenderTarget2D;
 class UGameInstance;
+enum ETextureRenderTargetFormat : int;
 
 class ACTORPORTRAIT_API SActorPortrait : public SCompoundWidget, public FGCObject
 {
@@ -24,6 +25,8 @@ public:
 	DECLARE_DELEGATE_TwoParams(FNoReplyFocusEventHandler, const FGeometry& /*Geometry*/, const FFocusEvent& /*FocusEvent*/);
 	DECLARE_DELEGATE_OneParam(FOnSpawnPortraitActor, AActor* /*Actor*/);
 	DECLARE_DELEGATE(FPostCameraReset);
+	DECLARE_DELEGATE_OneParam(FOnPortraitSceneLoaded, bool /*bSuccess*/);
+	DECLARE_DELEGATE_OneParam(FOnPortraitReady, bool /*bTimedOut*/);
 
 private:
 
@@ -31,6 +34,15 @@ private:
 	TObjectPtr<UObject> PortraitUserData = nullptr;
 	TObjectPtr<UMaterialInterface> RenderMaterial = nullptr;
 	FName RenderMaterialTextureParameter = NAME_None;
+	bool bLoadWorldAsync = false;
+	FName SharedStageName = NAME_None;
+	EPortraitWorldProfile WorldProfile = EPortraitWorldProfile::Full;
+	bool bWaitForStreamingLevels = true;
+	float StreamingLevelsTimeout = 0.f;
+	bool bPruneBackgroundActors = false;
+	float BackgroundPruneDistance = 0.f;
+	bool bRenderToAtlas = false;
+	EPortraitRenderTargetFormat RenderTargetFormat = EPortraitRenderTargetFormat::Auto;
 
 	// Slate attributes
 	TAttribute<FPortraitCameraSettings> PortraitCameraSettings;
@@ -43,22 +55,49 @@ private:
 	TAttribute<bool> bLockDuringCapture;
 	TAttribute<bool> bIgnoreInput;
 	TAttribute<bool> bTickWorld;
+	TAttribute<float> TickRate;
+	TAttribute<float> TimeDilation;
+	TAttribute<int32> TickPriority;
 	TAttribute<bool> bRealTime;
+	TAttribute<float> MaxCaptureRate;
 	TAttribute<bool> bShouldShowMouseCursor;
 	TAttribute<ESceneCaptureSource> CaptureSource;
+	TAttribute<const FSlateBrush*> PlaceholderBrush;
 
-	TPimplPtr<class FActorPortraitScene> PortraitScene = nullptr;
+	TSharedPtr<class FActorPortraitScene> PortraitScene = nullptr;
 	TObjectPtr<AActor> SkySphereActor = nullptr;
 	TObjectPtr<AActor> PortraitActor = nullptr;
 
+	/* Slot and capture component of this portrait when it's placed on a shared stage */
+	int32 StageSlot = INDEX_NONE;
+	TObjectPtr<USceneCaptureComponent2D> StageCaptureComponent = nullptr;
+
+	/* Actors to spawn once the portrait scene has finished loading asynchronously */
+	TObjectPtr<UClass> PendingActorClass = nullptr;
+	FTransform PendingActorTransform = FTransform::Identity;
+	TObjectPtr<UClass> PendingSkySphereClass = nullptr;
+
+	/* Valid while spawning the portrait actors is queued as a time-sliced construction stage */
+	TSharedPtr<bool> PortraitConstructionToken;
+
 	/* Brush used to draw the capture component render target */
 	FSlateBrush Brush;
 
+	/* Render target the portrait is captured into, acquired from the render target pool and kept when the portrait scene is recreated */
+	TObjectPtr<UTextureRenderTarget2D> RenderTarget = nullptr;
+
+	/* Rectangle of the portrait atlas the render target is copied into, and the atlas generation the brush was last updated for */
+	int32 AtlasAllocationId = INDEX_NONE;
+	uint32 AtlasGeneration = 0;
+
 	/* Stored view information */
 	FMinimalViewInfo ViewInfo;
 	FVector OrbitOrigin = FVector::ZeroVector;
+
+	/* Camera locations the background world was last pruned for, see UpdateBackgroundPruning */
+	FSphere BackgroundPruneVolume = FSphere(ForceInit);
 	
-	/* Current size used to render the portrait */
+	/* Current size used to render the portrait, the render target may be larger than this */
 	FIntPoint RenderSize = FIntPoint(0, 0);
 
 	/* True if scene needs recapture (ignored if real-time) */
@@ -67,8 +106,26 @@ private:
 	/* True if ResetCamera needs to be called next frame */
 	bool bCameraNeedsReset = false;
 
-	/* Keep track of the last rendered frame */
-	uint32 LastFrameNumber = 0;
+	/* Capture rate the portrait is registered with in the capture scheduler, and the time its next capped capture is due */
+	float CappedCaptureRate = 0.f;
+	double NextCappedCaptureTime = 0.0;
+
+	/* Keep track of the last frame (GFrameCounter) a capture was requested and rendered */
+	uint64 LastFrameNumber = 0;
+	mutable uint64 LastCapturedFrameNumber = 0;
+
+	/* True once the sub-levels of the portrait world are loaded and visible, capturing is held off until then */
+	bool bIsPortraitReady = false;
+	bool bSkyRecapturePending = false;
+	double ReadyWaitStartTime = 0.0;
+
+	/* True until the first capture after spawning the portrait actor, used to time the first capture */
+	mutable bool bPendingFirstCapture = false;
+
+	/* Last frame (GFrameCounter) the portrait was painted inside its culling rect with non-zero opacity, whether it's paused for being hidden and the frame it was paused */
+	mutable uint64 LastVisibleFrameNumber = 0;
+	bool bIsPausedWhileHidden = false;
+	uint64 PausedFrameNumber = 0;
 
 	/* Input Events */
 	FPointerEventHandler			OnInputTouchEvent;
@@ -85,6 +142,8 @@ private:
 	FOnSpawnPortraitActor           OnSpawnPortraitActorEvent;
 	FOnSpawnPortraitActor           PreSpawnPortraitActorEvent;
 	FPostCameraReset                PostCameraResetEvent;
+	FOnPortraitSceneLoaded          OnPortraitSceneLoadedEvent;
+	FOnPortraitReady                OnPortraitReadyEvent;
 
 	/** An intermediate reply state that is reset whenever an input event is generated */
 	FReply CurrentReplyState = FReply::Unhandled();
@@ -134,9 +193,23 @@ public:
 		, _bLockDuringCapture(true)
 		, _bIgnoreInput(false)
 		, _bTickWorld(true)
+		, _TickRate(0.f)
+		, _TimeDilation(1.f)
+		, _TickPriority(0)
 		, _bRealTime(true)
+		, _MaxCaptureRate(0.f)
 		, _bShouldShowMouseCursor(true)
 		, _CaptureSource(ESceneCaptureSource::SCS_FinalColorHDR)
+		, _bLoadWorldAsync(false)
+		, _PlaceholderBrush(nullptr)
+		, _SharedStageName(NAME_None)
+		, _WorldProfile(EPortraitWorldProfile::Full)
+		, _bWaitForStreamingLevels(true)
+		, _StreamingLevelsTimeout(10.f)
+		, _bPruneBackgroundActors(false)
+		, _BackgroundPruneDistance(0.f)
+		, _bRenderToAtlas(false)
+		, _RenderTargetFormat(EPortraitRenderTargetFormat::Auto)
 	{
 	}
 
@@ -202,15 +275,57 @@ public:
 		/** Whether to tick the portrait world */
 		SLATE_ATTRIBUTE(bool, bTickWorld)
 
+		/** How many times per second to tick the portrait world, 0 ticks it every frame. Each tick advances the world by the time passed since the previous tick */
+		SLATE_ATTRIBUTE(float, TickRate)
+
+		/** Time dilation of the portrait world, scales how fast the portrait world advances each tick. A shared stage uses the tick rate and time dilation of the first portrait ticking it each frame. */
+		SLATE_ATTRIBUTE(float, TimeDilation)
+
+		/** Order in which plugin ticked portrait worlds (ActorPortrait.PluginTickedWorlds) are ticked each frame, higher priorities tick first */
+		SLATE_ATTRIBUTE(int32, TickPriority)
+
 		/** Whether to update the portrait in real-time (useful if you want to tick animations or particle effects) */
 		SLATE_ATTRIBUTE(bool, bRealTime)
 
+		/** How many times per second a real-time portrait is captured at most, 0 captures it every frame. The captures of capped portraits are staggered over the frames */
+		SLATE_ATTRIBUTE(float, MaxCaptureRate)
+
 		/** Whether the mouse cursor should be shown by default when focusing this widget */
 		SLATE_ATTRIBUTE(bool, bShouldShowMouseCursor)
 
 		/** Which scene to use as source for the portrait capture */
 		SLATE_ATTRIBUTE(ESceneCaptureSource, CaptureSource)
 
+		/** Whether to load the world asset asynchronously instead of blocking the game thread while creating the portrait scene */
+		SLATE_ARGUMENT(bool, bLoadWorldAsync)
+
+		/** Brush drawn while the portrait scene is loading, the last rendered frame is drawn if nullptr */
+		SLATE_ATTRIBUTE(const FSlateBrush*, PlaceholderBrush)
+
+		/** Portraits with the same shared stage name, construction values and light templates share one portrait world, NAME_None gives the portrait its own world. Ignored with a background world. */
+		SLATE_ARGUMENT(FName, SharedStageName)
+
+		/** Which engine subsystems (physics, FX, AI and navigation) to create for the portrait world */
+		SLATE_ARGUMENT(EPortraitWorldProfile, WorldProfile)
+
+		/** Whether to hold off capturing the portrait until the sub-levels of the portrait world have streamed in */
+		SLATE_ARGUMENT(bool, bWaitForStreamingLevels)
+
+		/** Seconds to wait for the sub-levels to stream in before capturing the portrait anyway, 0 waits indefinitely */
+		SLATE_ARGUMENT(float, StreamingLevelsTimeout)
+
+		/** Whether to unregister the background world primitives which can't be seen from anywhere the camera can orbit or zoom to once the camera has been reset */
+		SLATE_ARGUMENT(bool, bPruneBackgroundActors)
+
+		/** Background primitives further than this from the reachable camera locations are pruned, 0 only prunes primitives beyond their own max draw distance. Pruned primitives lose their collision. */
+		SLATE_ARGUMENT(float, BackgroundPruneDistance)
+
+		/** Whether to draw the portrait from a shared atlas render target, so Slate can draw the portraits sharing an atlas page in one batch. Ignored when using a render material. */
+		SLATE_ARGUMENT(bool, bRenderToAtlas)
+
+		/** Pixel format of the render target the portrait is captured into, Auto picks it from the capture source */
+		SLATE_ARGUMENT(EPortraitRenderTargetFormat, RenderTargetFormat)
+
 
 		/** Invoked when touch event occurs on the portrait */
 		SLATE_EVENT(FPointerEventHandler, OnInputTouchEvent)
@@ -258,6 +373,12 @@ public:
 		 */
 		SLATE_EVENT(FPostCameraReset, PostCameraResetEvent)
 
+		/** Invoked once the portrait scene has been created and the portrait actor has been spawned */
+		SLATE_EVENT(FOnPortraitSceneLoaded, OnPortraitSceneLoadedEvent)
+
+		/** Invoked once the sub-levels of the portrait world have streamed in and the portrait is captured, bTimedOut is true if StreamingLevelsTimeout was reached first */
+		SLATE_EVENT(FOnPortraitReady, OnPortraitReadyEvent)
+
 	SLATE_END_ARGS()
 
 	void Construct(const FArguments& InArgs);
@@ -324,16 +445,41 @@ public:
 
 	void SetRealTime(const TAttribute<bool>& InRealTime);
 
+	void SetMaxCaptureRate(const TAttribute<float>& InMaxCaptureRate);
+
 	void SetTickWorld(const TAttribute<bool>& InTickWorld);
 
+	void SetTickRate(const TAttribute<float>& InTickRate);
+
+	void SetTimeDilation(const TAttribute<float>& InTimeDilation);
+
+	void SetTickPriority(const TAttribute<int32>& InTickPriority);
+
 	void SetCaptureSource(const TAttribute<ESceneCaptureSource>& InCaptrueSource);
 
+	/** Sets the pixel format of the render target, the render target is re-created the next time the portrait is captured */
+	void SetRenderTargetFormat(EPortraitRenderTargetFormat InRenderTargetFormat);
+
 	void SetPortraitSize(const TAttribute<FVector2D>& InPortraitSize);
 
 	void SetRenderResolutionOverride(const TAttribute<TOptional<FIntPoint>>& InRenderResolutionOverride);
 
 	void SetResolutionScale(const TAttribute<float>& InResolutionScale);
 
+	void SetPlaceholderBrush(const TAttribute<const FSlateBrush*>& InPlaceholderBrush);
+
+	/** Sets the shared stage to place the portrait on, takes effect the next time the portrait scene is recreated */
+	void SetSharedStageName(FName InSharedStageName);
+
+	/** Sets the world profile used to create the portrait world, takes effect the next time the portrait scene is recreated */
+	void SetWorldProfile(EPortraitWorldProfile InWorldProfile);
+
+	/** Sets whether and how far away background world primitives are pruned, re-applies the pruning right away */
+	void SetBackgroundPruning(bool bInPruneBackgroundActors, float InBackgroundPruneDistance);
+
+	/** Sets whether the portrait is drawn from the shared portrait atlas */
+	void SetRenderToAtlas(bool bInRenderToAtlas);
+
 	/** Reset the camera by recalculating the camera auto-framing */
 	void ResetCamera();
 
@@ -379,6 +525,9 @@ public:
 	/** Will recreate the portrait actor with the new actor class */
 	void RecreatePortraitActor(TSubclassOf<AActor> ActorClass, const FTransform& ActorTransform, bool bResetCamera);
 
+	/** True if the Auto world profile picks other engine subsystems for ActorClass than the portrait scene was created with, the scene then has to be recreated for the actor class */
+	bool NeedsNewPortraitScene(TSubclassOf<AActor> ActorClass) const;
+
 	/** Will recreate the sky sphere */
 	void RecreateSkySphere(TSubclassOf<AActor> InSkySphereClass, bool bRecaptureSky);
 
@@ -391,6 +540,18 @@ public:
 	/** Returns the underlying world used to draw the portrait actor */
 	UWorld* GetPortraitWorld() const;
 
+	/** Returns true while the portrait scene is being loaded asynchronously */
+	bool IsPortraitSceneLoading() const;
+
+	/** Returns the video memory used by the portrait's render target, and its rectangle of the atlas if it renders to the atlas, in bytes */
+	int64 GetRenderTargetMemorySize() const;
+
+	/** Returns true once the portrait world and its sub-levels have finished loading, and the portrait is being captured */
+	FORCEINLINE bool IsPortraitReady() const { return bIsPortraitReady; }
+
+	/** Returns true if the portrait world is shared with other portraits */
+	bool IsOnSharedStage() const;
+
 	/** Returns sky sphere actor from the portrait world, nullptr if there is none */
 	AActor* GetSkySphereActor() const;
 
@@ -415,15 +576,78 @@ public:
 	/** Returns true if the world is part of an actor portrait widget */
 	static bool IsPortraitWorld(UWorld* World);
 
-	/** Returns the actor portrait widget which owns the supplied world */
+	/** Returns the actor portrait widget which owns the supplied world, one of the widgets if the world is a shared stage */
 	static TWeakPtr<SActorPortrait> FindPortraitWidgetFromWorld(UWorld* World);
 
 private:
 
+	/** Returns the portrait scene to the scene pool, clearing all references to actors and resources owned by the scene */
+	void ReleasePortraitScene();
+
+	/** Spawns the pending portrait actor and sky sphere once the portrait scene is ready, queued as a separate stage when construction is time-sliced */
+	void OnPortraitSceneLoaded(bool bSuccess);
+
+	/** Spawns the pending portrait actor and sky sphere into the loaded scene and starts waiting for the portrait to become ready */
+	void FinishPortraitSceneConstruction(bool bSuccess);
+
+	/** Creates the capture component of a portrait on a shared stage, once the stage world exists */
+	void InitializeStageCapture();
+
+	/** Restricts the capture component of a portrait on a shared stage to only render this portrait's actors and the stage background */
+	void UpdateStageShowOnlyList();
+
+	/** Starts waiting for the sub-levels of a newly created portrait scene to stream in */
+	void BeginWaitForPortraitReady();
+
+	/** Checks whether the portrait world has finished streaming, capturing the portrait and invoking OnPortraitReadyEvent once it has */
+	void UpdatePortraitReady();
+
+	/** Prunes the background primitives which can't be seen from anywhere the camera can reach around the orbit origin, restores them if pruning is disabled.
+	 *  With bOnlyIfGrown the background is left alone while the camera can't reach any further than when it was last pruned. */
+	void UpdateBackgroundPruning(bool bOnlyIfGrown = false);
+
+	/** Location of this portrait's slot on its shared stage, zero if the portrait has its own world */
+	FVector GetStageSlotLocation() const;
+
+	/** Background world and portrait actor class, used to tag profiling data */
+	struct FActorPortraitPhaseContext GetPhaseContext() const;
+
 	void RecreateRenderMaterial();
 
 	void ResizeRenderTarget(const FIntPoint& NewRenderSize);
 
+	/** The render target format to use, resolving Auto from the capture source */
+	ETextureRenderTargetFormat GetResolvedRenderTargetFormat() const;
+
+	/** Registers the portrait's capped capture rate with the capture scheduler, 0 unregisters it */
+	void SetCappedCaptureRate(float InCappedCaptureRate, double CurrentTime);
+
+	/** Returns true if the portrait's next capped capture is due and the capture scheduler has room for it this frame */
+	bool ConsumeCappedCapture(double CurrentTime, float DeltaTime);
+
+	/** Returns true if the portrait hasn't been painted visibly for HiddenPortraitGraceFrames frames */
+	bool IsHiddenFromView() const;
+
+	/** Pauses the portrait while it's hidden, or resumes it once it's painted again */
+	void SetPausedWhileHidden(bool bInIsPausedWhileHidden);
+
+	/** Pauses the portrait once it's hidden from view, called every frame whether or not Slate paints (and ticks) the portrait */
+	void PauseIfHiddenFromView();
+
+	friend class FHiddenPortraitWatcher;
+
+	/** Returns the render target to the render target pool */
+	void ReleaseRenderTarget();
+
+	/** Allocates, moves or frees the atlas rectangle of the portrait to match its render size and whether it renders to the atlas */
+	void UpdateAtlasAllocation();
+
+	/** Points the brush at the portrait's atlas page and rectangle */
+	void UpdateAtlasBrush();
+
+	/** Narrows the projection of the capture component to the part of the render target the portrait is drawn from */
+	void UpdateCaptureProjection(USceneCaptureComponent2D* CaptureComponent) const;
+
 	void ProcessAccumulatedPointerInput();
 
 	void UpdateCachedCursorPos(const FGeometry& InGeometry, const FPointerEvent& InMouseEvent);
@@ -0,0 +1,25 @@
+// Copyright Mans Isaksson. All Rights Reserved.
+
+using UnrealBuildTool;
+
+public class ActorPortraitEditor : ModuleRules
+{
+    public ActorPortraitEditor(ReadOnlyTargetRules Target) : base(Target)
+    {
+        PCHUsage = ModuleRules.PCHUsageMode.UseExplicitOrSharedPCHs;
+
+        PublicDependencyModuleNames.AddRange(new string[]
+        {
+            "Core",
+            "CoreUObject",
+            "Engine"
+        });
+
+        PrivateDependencyModuleNames.AddRange(new string[]
+        {
+            "ActorPortrait",
+            "AssetRegistry",
+            "UnrealEd"
+        });
+    }
+}
@@ -0,0 +1,7 @@
+// Copyright Mans Isaksson. All Rights Reserved.
+
+#include "ActorPortraitEditorModule.h"
+
+DEFINE_LOG_CATEGORY(LogActorPortraitEditor);
+
+IMPLEMENT_MODULE(FDefaultModuleImpl, ActorPortraitEditor)
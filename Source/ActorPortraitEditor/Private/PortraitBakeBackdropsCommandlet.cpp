@@ -0,0 +1,88 @@
+// Copyright Mans Isaksson. All Rights Reserved.
+
+#include "PortraitBakeBackdropsCommandlet.h"
+#include "PortraitBakedBackdrop.h"
+#include "ActorPortraitEditorModule.h"
+
+#include "AssetRegistry/IAssetRegistry.h"
+#include "Misc/PackageName.h"
+#include "UObject/Package.h"
+#include "UObject/SavePackage.h"
+
+UPortraitBakeBackdropsCommandlet::UPortraitBakeBackdropsCommandlet()
+{
+	IsClient        = false;
+	IsEditor        = true;
+	IsServer        = false;
+	LogToConsole    = true;
+	ShowErrorCount  = true;
+}
+
+int32 UPortraitBakeBackdropsCommandlet::Main(const FString& Params)
+{
+	TArray<FSoftObjectPath> BackdropPaths;
+
+	FString BackdropsParam;
+	if (FParse::Value(*Params, TEXT("Backdrops="), BackdropsParam, false))
+	{
+		TArray<FString> BackdropNames;
+		BackdropsParam.ParseIntoArray(BackdropNames, TEXT("+"));
+
+		for (const FString& BackdropName : BackdropNames)
+		{
+			// Accept package names as well as full object paths
+			BackdropPaths.Add(FPackageName::IsValidObjectPath(BackdropName) ? FSoftObjectPath(BackdropName) : FSoftObjectPath(BackdropName + TEXT(".") + FPackageName::GetShortName(BackdropName)));
+		}
+	}
+	else
+	{
+		IAssetRegistry& AssetRegistry = IAssetRegistry::GetChecked();
+		AssetRegistry.SearchAllAssets(true);
+
+		TArray<FAssetData> BackdropAssets;
+		AssetRegistry.GetAssetsByClass(UPortraitBakedBackdrop::StaticClass()->GetClassPathName(), BackdropAssets, true);
+
+		for (const FAssetData& BackdropAsset : BackdropAssets)
+		{
+			BackdropPaths.Add(BackdropAsset.GetSoftObjectPath());
+		}
+	}
+
+	int32 NumFailed = 0;
+
+	for (const FSoftObjectPath& BackdropPath : BackdropPaths)
+	{
+		UPortraitBakedBackdrop* Backdrop = Cast<UPortraitBakedBackdrop>(BackdropPath.TryLoad());
+		if (!Backdrop)
+		{
+			UE_LOG(LogActorPortraitEditor, Error, TEXT("Failed to load backdrop %s"), *BackdropPath.ToString());
+			NumFailed++;
+			continue;
+		}
+
+		if (!Backdrop->BakeBackdrop())
+		{
+			NumFailed++;
+			continue;
+		}
+
+		UPackage* Package = Backdrop->GetOutermost();
+		const FString Filename = FPackageName::LongPackageNameToFilename(Package->GetName(), FPackageName::GetAssetPackageExtension());
+
+		FSavePackageArgs SaveArgs;
+		SaveArgs.TopLevelFlags = RF_Public | RF_Standalone;
+		SaveArgs.Error         = GError;
+
+		if (!UPackage::SavePackage(Package, Backdrop, *Filename, SaveArgs))
+		{
+			UE_LOG(LogActorPortraitEditor, Error, TEXT("Failed to save backdrop %s"), *Filename);
+			NumFailed++;
+		}
+
+		// Release the source world before baking the next backdrop
+		CollectGarbage(RF_NoFlags);
+	}
+
+	UE_LOG(LogActorPortraitEditor, Display, TEXT("Baked %d of %d portrait backdrops"), BackdropPaths.Num() - NumFailed, BackdropPaths.Num());
+	return NumFailed > 0 ? 1 : 0;
+}
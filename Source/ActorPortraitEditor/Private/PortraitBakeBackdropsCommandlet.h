@@ -0,0 +1,26 @@
+// Copyright Mans Isaksson. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+
+#include "PortraitBakeBackdropsCommandlet.generated.h"
+
+/**
+ * Bakes portrait backdrop assets (UPortraitBakedBackdrop) from their source worlds and saves them.
+ * 
+ * Usage: UnrealEditor-Cmd.exe <Project> -run=PortraitBakeBackdrops [-Backdrops=/Game/Path/BD_First+/Game/Path/BD_Second] -AllowCommandletRendering
+ * Bakes every backdrop asset in the project when -Backdrops is not given.
+ */
+UCLASS()
+class UPortraitBakeBackdropsCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+public:
+	UPortraitBakeBackdropsCommandlet();
+
+	// ~Begin UCommandlet interface
+	virtual int32 Main(const FString& Params) override;
+	// ~End UCommandlet interface
+};